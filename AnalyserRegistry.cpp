@@ -0,0 +1,391 @@
+#include "AnalyserRegistry.hpp"
+#include "DSPKernels.hpp"
+#include <cmath>
+
+const double envelopeReleaseSeconds = 0.1;  //time constant the RMS envelope falls with
+
+
+int AnalyserRegistry::add(AudioAnalyser& analyser, RunMode runMode)
+{
+    jassert(numAnalysers < maxAnalysers);
+    if (numAnalysers >= maxAnalysers)
+        return -1;
+
+    auto& entry = entries[static_cast<size_t>(numAnalysers)];
+    entry.analyser = &analyser;
+    entry.runMode = runMode;
+    entry.active.store(false);
+    return numAnalysers++;
+}
+
+void AnalyserRegistry::setActive(int index, bool shouldBeActive)
+{
+    if (index >= 0 && index < numAnalysers)
+        entries[static_cast<size_t>(index)].active.store(shouldBeActive);
+}
+
+bool AnalyserRegistry::isRunning(int index) const
+{
+    if (index < 0 || index >= numAnalysers)
+        return false;
+
+    const auto& entry = entries[static_cast<size_t>(index)];
+    return entry.runMode == RunMode::alwaysRun || entry.active.load();
+}
+
+//prepares every analyser, then sizes the shared frame for the largest spectrum asked for
+void AnalyserRegistry::prepare(double newSampleRate, int maximumBlockSize)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 48000.0;
+
+    fftSize = 0;
+    hopSize = 0;
+    for (int i = 0; i < numAnalysers; ++i)
+    {
+        auto* analyser = entries[static_cast<size_t>(i)].analyser;
+        analyser->prepare(sampleRate, maximumBlockSize);
+
+        const int size = analyser->getSpectrumSize();
+        if (size <= 0)
+            continue;
+
+        jassert(juce::isPowerOfTwo(size));
+        fftSize = juce::jmax(fftSize, size);
+
+        const int hop = analyser->getSpectrumHopSize() > 0 ? analyser->getSpectrumHopSize() : size;
+        hopSize = hopSize > 0 ? juce::jmin(hopSize, hop) : hop;
+    }
+
+    monoBuffer.assign(static_cast<size_t>(juce::jmax(1, maximumBlockSize)), 0.0f);
+
+    if (fftSize > 0)
+    {
+        fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(fftSize)));
+        ringBuffer.assign(static_cast<size_t>(fftSize), 0.0f);
+        fftData.assign(static_cast<size_t>(fftSize) * 2, 0.0f);
+
+        //hann window
+        window.resize(static_cast<size_t>(fftSize));
+        for (int i = 0; i < fftSize; ++i)
+            window[static_cast<size_t>(i)] = 0.5f - 0.5f * std::cos(2.0f * juce::MathConstants<float>::pi * i / (fftSize - 1));
+    }
+    else
+    {
+        fft.reset();
+        ringBuffer.clear();
+        fftData.clear();
+        window.clear();
+    }
+
+    energyGate.prepare(sampleRate);
+    releaseCoefficient = static_cast<float>(std::exp(-1.0 / (sampleRate * envelopeReleaseSeconds)));
+    writePosition = 0;
+    samplesUntilFrame = hopSize;
+    samplePosition = 0;
+    rmsEnvelope = 0.0f;
+}
+
+void AnalyserRegistry::release()
+{
+    for (int i = 0; i < numAnalysers; ++i)
+        entries[static_cast<size_t>(i)].analyser->release();
+}
+
+void AnalyserRegistry::process(const float* const* channels, int numChannels, int startSample, int numSamples)
+{
+    if (channels == nullptr || numChannels <= 0 || monoBuffer.empty())
+        return;
+
+    const int chunkCapacity = static_cast<int>(monoBuffer.size());
+
+    for (int chunkStart = 0; chunkStart < numSamples; chunkStart += chunkCapacity)
+    {
+        const int chunkSize = juce::jmin(chunkCapacity, numSamples - chunkStart);
+        DSPKernels::downmixToMono(monoBuffer.data(), channels, numChannels, startSample + chunkStart, chunkSize);
+
+        if (fftSize == 0)
+        {
+            processSlice(0, chunkSize, false);
+            continue;
+        }
+
+        //fills the frame window, slices end where a frame is due
+        int offset = 0;
+        while (offset < chunkSize)
+        {
+            const int sliceSize = juce::jmin(chunkSize - offset, samplesUntilFrame);
+            const int firstPart = juce::jmin(sliceSize, fftSize - writePosition);
+            std::copy(monoBuffer.data() + offset, monoBuffer.data() + offset + firstPart, ringBuffer.data() + writePosition);
+            std::copy(monoBuffer.data() + offset + firstPart, monoBuffer.data() + offset + sliceSize, ringBuffer.data());
+
+            writePosition = (writePosition + sliceSize) % fftSize;
+            samplesUntilFrame -= sliceSize;
+
+            const bool frameDue = samplesUntilFrame == 0;
+            processSlice(offset, sliceSize, frameDue);
+
+            if (frameDue)
+                samplesUntilFrame = hopSize;
+
+            offset += sliceSize;
+        }
+    }
+}
+
+//features of one slice of the mono buffer, then every running analyser
+void AnalyserRegistry::processSlice(int offset, int numSamples, bool frameDue)
+{
+    AudioFeatures features;
+    features.mono = monoBuffer.data() + offset;
+    features.numSamples = numSamples;
+    features.startSample = samplePosition;
+    features.sampleRate = sampleRate;
+
+    float sumOfSquares = 0.0f;
+    for (int i = 0; i < numSamples; ++i)
+        sumOfSquares += features.mono[i] * features.mono[i];
+
+    features.rms = numSamples > 0 ? std::sqrt(sumOfSquares / numSamples) : 0.0f;
+    rmsEnvelope = juce::jmax(features.rms, rmsEnvelope * std::pow(releaseCoefficient, static_cast<float>(numSamples)));
+    features.rmsEnvelope = rmsEnvelope;
+    features.gateOpen = energyGate.process(features.rms, numSamples);
+    features.noiseFloor = energyGate.getNoiseFloor();
+    features.frameDue = frameDue;
+
+    if (frameDue && features.gateOpen && isSpectrumNeeded())
+    {
+        features.frameRms = computeFrame();
+        features.spectrum = fftData.data();
+        features.spectrumSize = fftSize;
+    }
+
+    for (int i = 0; i < numAnalysers; ++i)
+        if (isRunning(i))
+            entries[static_cast<size_t>(i)].analyser->process(features);
+
+    samplePosition += numSamples;
+}
+
+bool AnalyserRegistry::isSpectrumNeeded() const
+{
+    for (int i = 0; i < numAnalysers; ++i)
+        if (isRunning(i) && entries[static_cast<size_t>(i)].analyser->getSpectrumSize() > 0)
+            return true;
+
+    return false;
+}
+
+//windowed copy of the ring in time order and its magnitude spectrum, returns the frame RMS
+float AnalyserRegistry::computeFrame()
+{
+    float sumOfSquares = 0.0f;
+    for (float sample : ringBuffer)
+        sumOfSquares += sample * sample;
+
+    const int olderSamples = fftSize - writePosition;
+    DSPKernels::applyWindow(fftData.data(), ringBuffer.data() + writePosition, window.data(), olderSamples);
+    DSPKernels::applyWindow(fftData.data() + olderSamples, ringBuffer.data(), window.data() + olderSamples, writePosition);
+    juce::FloatVectorOperations::clear(fftData.data() + fftSize, fftSize);
+
+    fft->performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+    return std::sqrt(sumOfSquares / fftSize);
+}
+
+#if JUCE_UNIT_TESTS
+
+#include "ChordVerifier.hpp"
+#include "NoteMapping.hpp"
+#include "SyntheticGuitarSignal.hpp"
+#include <algorithm>
+
+class AnalyserRegistryTests : public juce::UnitTest
+{
+public:
+    AnalyserRegistryTests() : juce::UnitTest("Analyser registry", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        const double sampleRate = 48000.0;
+        const int numSamples = 10000;
+        const int blockSize = 300;
+
+        std::vector<float> left(numSamples), right(numSamples);
+        const int silentSamples = 2000;
+
+        for (int i = silentSamples; i < numSamples; ++i)
+        {
+            left[static_cast<size_t>(i)] = 0.5f * std::sin(2.0f * juce::MathConstants<float>::pi * 1000.0f * i / static_cast<float>(sampleRate));
+            right[static_cast<size_t>(i)] = 0.1f * std::cos(0.01f * i);
+        }
+        const float* channels[] = { left.data(), right.data() };
+
+        beginTest("Every analyser sees the same downmix");
+        {
+            Recorder first, second;
+            AnalyserRegistry registry;
+            registry.add(first, AnalyserRegistry::RunMode::alwaysRun);
+            registry.add(second, AnalyserRegistry::RunMode::alwaysRun);
+            feed(registry, channels, numSamples, blockSize);
+
+            expectEquals(static_cast<int>(first.samples.size()), numSamples);
+            expect(first.samples == second.samples);
+            expect(first.contiguous);
+            expectWithinAbsoluteError(first.samples[1234], 0.5f * (left[1234] + right[1234]), 1.0e-6f);
+        }
+
+        beginTest("Analysers that run when active wait for it");
+        {
+            Recorder background, foreground;
+            AnalyserRegistry registry;
+            registry.add(background, AnalyserRegistry::RunMode::alwaysRun);
+            const int index = registry.add(foreground, AnalyserRegistry::RunMode::whenActive);
+            feed(registry, channels, numSamples, blockSize);
+            expect(foreground.samples.empty());
+
+            registry.setActive(index, true);
+            registry.process(channels, 2, 0, blockSize);
+            expectEquals(static_cast<int>(foreground.samples.size()), blockSize);
+            expectEquals(static_cast<int>(foreground.firstStartSample), static_cast<int>(background.samples.size()) - blockSize);
+        }
+
+        beginTest("A spectrum every hop once the gate opens");
+        {
+            Recorder reader(1024, 128);
+            AnalyserRegistry registry;
+            registry.add(reader, AnalyserRegistry::RunMode::alwaysRun);
+            feed(registry, channels, numSamples, blockSize);
+
+            expectEquals(registry.getSpectrumSize(), 1024);
+            expectEquals(reader.numFramesDue, numSamples / 128);
+            expectEquals(reader.numSpectra, numSamples / 128 - silentSamples / 128);
+            expectEquals(reader.lastPeakBin, juce::roundToInt(1000.0 * 1024 / sampleRate));
+        }
+
+        beginTest("No spectrum while its readers are idle");
+        {
+            Recorder listener, reader(1024, 128);
+            AnalyserRegistry registry;
+            registry.add(listener, AnalyserRegistry::RunMode::alwaysRun);
+            registry.add(reader, AnalyserRegistry::RunMode::whenActive);
+            feed(registry, channels, numSamples, blockSize);
+            expectEquals(listener.numSpectra, 0);
+        }
+
+        beginTest("The chord check reads the shared spectrum as it would its own");
+        {
+            const auto gMajor = ChordVerifier::Shape::fromTab({ { 5, 3 }, { 4, 2 }, { 0, 3 } }, {});
+            auto strum = renderStrum(sampleRate, gMajor, static_cast<int>(sampleRate * 0.4));
+            const float* strumChannels[] = { strum.data() };
+
+            ChordVerifier direct;
+            direct.prepare(sampleRate, 256);
+            direct.setShape(gMajor);
+            for (int start = 0; start < static_cast<int>(strum.size()); start += 256)
+                direct.processBlock(strumChannels, 1, start, juce::jmin(256, static_cast<int>(strum.size()) - start));
+
+            ChordReader shared;
+            shared.verifier.setShape(gMajor);
+            AnalyserRegistry registry;
+            registry.add(shared, AnalyserRegistry::RunMode::alwaysRun);
+            feed(registry, strumChannels, 1, static_cast<int>(strum.size()), 256);
+
+            const auto expected = direct.getLatestResult();
+            const auto result = shared.verifier.getLatestResult();
+            expect(result.isChordCorrect());
+            expectEquals(static_cast<int>(result.hitStrings), static_cast<int>(expected.hitStrings));
+            expectWithinAbsoluteError(result.chordMatch, expected.chordMatch, 0.05f);
+        }
+    }
+
+private:
+    //keeps what it is given
+    struct Recorder : public AudioAnalyser
+    {
+        Recorder(int size = 0, int hop = 0) : spectrumSize(size), spectrumHopSize(hop) {}
+
+        void prepare(double, int maximumBlockSize) override { samples.reserve(static_cast<size_t>(maximumBlockSize)); }
+
+        void process(const AudioFeatures& features) override
+        {
+            if (samples.empty())
+                firstStartSample = features.startSample;
+            else if (features.startSample != firstStartSample + static_cast<juce::int64>(samples.size()))
+                contiguous = false;
+
+            samples.insert(samples.end(), features.mono, features.mono + features.numSamples);
+
+            if (features.frameDue)
+                ++numFramesDue;
+
+            if (features.spectrum != nullptr)
+            {
+                ++numSpectra;
+                lastPeakBin = static_cast<int>(std::max_element(features.spectrum, features.spectrum + features.spectrumSize / 2 + 1) - features.spectrum);
+            }
+        }
+
+        int getSpectrumSize() const override { return spectrumSize; }
+        int getSpectrumHopSize() const override { return spectrumHopSize; }
+
+        int spectrumSize, spectrumHopSize;
+        std::vector<float> samples;
+        juce::int64 firstStartSample = 0;
+        bool contiguous = true;
+        int numFramesDue = 0;
+        int numSpectra = 0;
+        int lastPeakBin = -1;
+    };
+
+    struct ChordReader : public AudioAnalyser
+    {
+        void prepare(double sampleRate, int maximumBlockSize) override { verifier.prepare(sampleRate, maximumBlockSize); }
+
+        void process(const AudioFeatures& features) override
+        {
+            if (features.frameDue)
+                verifier.processSpectrum(features.spectrum, features.frameRms);
+        }
+
+        int getSpectrumSize() const override { return verifier.getFFTSize(); }
+        int getSpectrumHopSize() const override { return verifier.getHopSize(); }
+
+        ChordVerifier verifier;
+    };
+
+    static void feed(AnalyserRegistry& registry, const float* const* channels, int numSamples, int blockSize)
+    {
+        feed(registry, channels, 2, numSamples, blockSize);
+    }
+
+    static void feed(AnalyserRegistry& registry, const float* const* channels, int numChannels, int numSamples, int blockSize)
+    {
+        registry.prepare(48000.0, blockSize);
+        for (int start = 0; start < numSamples; start += blockSize)
+            registry.process(channels, numChannels, start, juce::jmin(blockSize, numSamples - start));
+    }
+
+    static std::vector<float> renderStrum(double sampleRate, const ChordVerifier::Shape& shape, int numSamples)
+    {
+        std::vector<float> output(static_cast<size_t>(numSamples), 0.0f);
+
+        for (int i = ChordVerifier::numStrings - 1, order = 0; i >= 0; --i)
+        {
+            if (shape.frets[static_cast<size_t>(i)] == ChordVerifier::mutedFret)
+                continue;
+
+            const int offset = 240 * order++;
+            const int midiNote = ChordVerifier::getOpenStringMidiNote(i) + shape.frets[static_cast<size_t>(i)];
+            auto string = SyntheticGuitarSignal::renderNote(sampleRate, NoteMapping::getFrequencyForMidiNote(midiNote), 0.12f,
+                                                            numSamples - offset, i + 1);
+            for (int n = offset; n < numSamples; ++n)
+                output[static_cast<size_t>(n)] += string[static_cast<size_t>(n - offset)];
+        }
+
+        return output;
+    }
+};
+
+static AnalyserRegistryTests analyserRegistryTests;
+
+#endif
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+#include "EnergyGate.hpp"
+
+//features of one slice of input, computed once by the registry and shared by every analyser
+struct AudioFeatures
+{
+    const float* mono = nullptr;       //downmixed input
+    int numSamples = 0;
+    juce::int64 startSample = 0;       //position of mono[0] since prepare
+    double sampleRate = 48000.0;
+
+    float rms = 0.0f;                  //RMS of this slice
+    float rmsEnvelope = 0.0f;          //RMS with a fast attack and a slow release
+    float noiseFloor = 0.0f;           //learnt level of the input between notes
+
+    //false while the input is only noise, expensive analysis should wait for it to open
+    bool gateOpen = false;
+
+    //a frame ends with this slice, the spectrum is only taken while the gate is open
+    bool frameDue = false;
+
+    //magnitudes of a Hann windowed frame ending with this slice, as returned by
+    //juce::dsp::FFT::performFrequencyOnlyForwardTransform, null when no frame was taken
+    const float* spectrum = nullptr;
+    int spectrumSize = 0;              //frame length, the spectrum holds spectrumSize / 2 + 1 bins
+    float frameRms = 0.0f;             //RMS of the frame the spectrum was taken from
+};
+
+//something that listens to the input, implemented by each tab's analysis
+class AudioAnalyser
+{
+public:
+    virtual ~AudioAnalyser() = default;
+
+    virtual void prepare(double sampleRate, int maximumBlockSize) = 0;
+    virtual void process(const AudioFeatures& features) = 0;
+    virtual void release() {}
+
+    //frame length and hop the analyser wants spectra at, 0 when it does not read them
+    //asked after prepare, every analyser that reads spectra gets the largest frame asked for
+    virtual int getSpectrumSize() const { return 0; }
+    virtual int getSpectrumHopSize() const { return 0; }
+};
+
+//runs the shared feature extraction once per block and fans it out to the registered analysers
+//analysers added as alwaysRun keep listening while their tab is hidden so switching back does not
+//start detection cold, the others run only while active, the FFT frame is only taken when one of
+//its readers runs but its window keeps filling so a reader that becomes active has it ready
+//an energy gate on the slice RMS marks input that is only noise, no FFT is taken while it is closed
+class AnalyserRegistry
+{
+public:
+    static constexpr int maxAnalysers = 8;
+
+    enum class RunMode
+    {
+        whenActive,
+        alwaysRun
+    };
+
+    AnalyserRegistry() = default;
+
+    //registration is done on the message thread before the audio device starts
+    //returns the index used by setActive
+    int add(AudioAnalyser& analyser, RunMode runMode);
+
+    //safe from the message thread while audio runs
+    void setActive(int index, bool shouldBeActive);
+    bool isRunning(int index) const;
+
+    void prepare(double sampleRate, int maximumBlockSize);
+    void release();
+
+    //downmixes the block, extracts the features and calls the running analysers
+    //the block is sliced at FFT frame boundaries so every frame is delivered
+    void process(const float* const* channels, int numChannels, int startSample, int numSamples);
+
+    int getNumAnalysers() const { return numAnalysers; }
+    int getSpectrumSize() const { return fftSize; }
+    int getSpectrumHopSize() const { return hopSize; }
+
+private:
+    struct Entry
+    {
+        AudioAnalyser* analyser = nullptr;
+        RunMode runMode = RunMode::whenActive;
+        std::atomic<bool> active { false };
+    };
+
+    void processSlice(int offset, int numSamples, bool frameDue);
+    bool isSpectrumNeeded() const;
+    float computeFrame();
+
+    std::array<Entry, maxAnalysers> entries;
+    int numAnalysers = 0;
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> monoBuffer;
+    std::vector<float> ringBuffer;     //last fftSize input samples, oldest at writePosition
+    std::vector<float> window;
+    std::vector<float> fftData;
+
+    double sampleRate = 48000.0;
+    int fftSize = 0;
+    int hopSize = 0;
+    int writePosition = 0;
+    int samplesUntilFrame = 0;
+    juce::int64 samplePosition = 0;
+    float rmsEnvelope = 0.0f;
+    float releaseCoefficient = 0.0f;
+    EnergyGate energyGate;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalyserRegistry)
+};
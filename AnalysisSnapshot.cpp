@@ -0,0 +1,86 @@
+#include "AnalysisSnapshot.hpp"
+
+#if JUCE_UNIT_TESTS
+
+#include <thread>
+
+class AnalysisSnapshotTests : public juce::UnitTest
+{
+public:
+    AnalysisSnapshotTests() : juce::UnitTest("Analysis snapshot", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        beginTest("Reads give the newest value once");
+        {
+            AnalysisSnapshot<Result> snapshot;
+            Result result;
+
+            expect(!snapshot.read(result));
+            expectEquals(result.count, 0);
+
+            snapshot.publish(makeResult(1));
+            expect(snapshot.read(result));
+            expectEquals(result.count, 1);
+            expect(!snapshot.read(result));
+            expectEquals(result.count, 1);
+
+            for (int i = 2; i <= 5; ++i)
+                snapshot.publish(makeResult(i));
+
+            expect(snapshot.read(result));
+            expectEquals(result.count, 5);
+            expect(!snapshot.read(result));
+        }
+
+        beginTest("A reader on another thread never sees a torn or older value");
+        {
+            AnalysisSnapshot<Result> snapshot;
+            constexpr int numPublished = 200000;
+
+            std::thread writer([&snapshot]()
+            {
+                for (int i = 1; i <= numPublished; ++i)
+                    snapshot.publish(makeResult(i));
+            });
+
+            Result result;
+            int lastCount = 0, numTorn = 0, numOlder = 0;
+
+            while (lastCount < numPublished)
+            {
+                if (!snapshot.read(result))
+                    continue;
+
+                if (result.frequency != result.count * 2.0f || result.midiNote != result.count % 128)
+                    ++numTorn;
+                if (result.count <= lastCount)
+                    ++numOlder;
+
+                lastCount = result.count;
+            }
+
+            writer.join();
+
+            expectEquals(numTorn, 0);
+            expectEquals(numOlder, 0);
+        }
+    }
+
+private:
+    struct Result
+    {
+        int count = 0;
+        float frequency = 0.0f;
+        int midiNote = 0;
+    };
+
+    static Result makeResult(int count)
+    {
+        return { count, count * 2.0f, count % 128 };
+    }
+};
+
+static AnalysisSnapshotTests analysisSnapshotTests;
+
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <type_traits>
+#include <juce_core/juce_core.h>
+
+//the latest analysis result handed from one writer thread to one reader thread
+//a triple buffer, the writer fills a slot of its own and swaps it in as the newest, the reader
+//swaps the newest out when there is one, so neither side ever waits, locks or sees half a result
+//meant for the UI pulling once per display frame, results published in between are skipped
+template <typename Value>
+class AnalysisSnapshot
+{
+public:
+    static_assert(std::is_trivially_copyable<Value>::value, "snapshots are copied slot to slot");
+
+    AnalysisSnapshot() = default;
+
+    //writer thread only
+    void publish(const Value& value) noexcept
+    {
+        slots[static_cast<size_t>(writeSlot)] = value;
+        writeSlot = middle.exchange(writeSlot | newValueFlag, std::memory_order_acq_rel) & slotMask;
+    }
+
+    //reader thread only, copies out the newest value and returns true when it wasn't read before
+    bool read(Value& value) noexcept
+    {
+        const bool isNew = (middle.load(std::memory_order_relaxed) & newValueFlag) != 0;
+
+        if (isNew)
+            readSlot = middle.exchange(readSlot, std::memory_order_acq_rel) & slotMask;
+
+        value = slots[static_cast<size_t>(readSlot)];
+        return isNew;
+    }
+
+private:
+    static constexpr int slotMask = 3;
+    static constexpr int newValueFlag = 4;
+
+    std::array<Value, 3> slots {};
+    int writeSlot = 0;                  //writer thread
+    int readSlot = 1;                   //reader thread
+    std::atomic<int> middle { 2 };      //newest slot, flagged until the reader takes it
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalysisSnapshot)
+};
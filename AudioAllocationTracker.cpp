@@ -0,0 +1,138 @@
+#include "AudioAllocationTracker.hpp"
+
+#if GUITAR_APP_TRACK_AUDIO_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local int audioCallbackDepth = 0;
+    thread_local bool reportingAllocation = false;
+    std::atomic<int> audioAllocationCount { 0 };
+
+    //counts and flags an allocation if the calling thread is inside the audio callback
+    void noteAllocation()
+    {
+        if (audioCallbackDepth == 0 || reportingAllocation)
+            return;
+
+        //the assertion machinery may allocate itself, so it must not be reported again
+        reportingAllocation = true;
+        audioAllocationCount.fetch_add(1, std::memory_order_relaxed);
+        jassertfalse; //heap allocation inside getNextAudioBlock, check the call stack
+        reportingAllocation = false;
+    }
+
+    void* allocate(std::size_t size)
+    {
+        noteAllocation();
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment)
+    {
+        noteAllocation();
+
+        void* ptr = nullptr;
+        std::size_t align = juce::jmax(static_cast<std::size_t>(alignment), sizeof(void*));
+        if (posix_memalign(&ptr, align, size == 0 ? 1 : size) != 0)
+            return nullptr;
+
+        return ptr;
+    }
+}
+
+namespace AudioAllocationTracker
+{
+    ScopedAudioCallback::ScopedAudioCallback()
+    {
+        ++audioCallbackDepth;
+    }
+
+    ScopedAudioCallback::~ScopedAudioCallback()
+    {
+        --audioCallbackDepth;
+    }
+
+    int getAllocationCount()
+    {
+        return audioAllocationCount.load(std::memory_order_relaxed);
+    }
+
+    void resetAllocationCount()
+    {
+        audioAllocationCount.store(0, std::memory_order_relaxed);
+    }
+}
+
+//global allocation hooks, every C++ heap allocation in the app passes through these
+//plain malloc calls are not hooked, the JUCE and standard containers used on the
+//audio path all allocate through operator new
+void* operator new(std::size_t size)
+{
+    if (void* ptr = allocate(size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    if (void* ptr = allocate(size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void* ptr = allocateAligned(size, alignment))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    if (void* ptr = allocateAligned(size, alignment))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept                                      { std::free(ptr); }
+void operator delete[](void* ptr) noexcept                                    { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept                         { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept                       { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept               { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept             { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept                    { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept                  { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept       { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept     { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept   { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+#endif
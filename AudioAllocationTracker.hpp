@@ -0,0 +1,39 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//debug build tool that flags heap allocations made inside the audio callback
+//enabled by default in debug builds, define GUITAR_APP_TRACK_AUDIO_ALLOCATIONS=0 to turn it off
+//(or =1 to force it on in a release build when profiling on a device)
+#ifndef GUITAR_APP_TRACK_AUDIO_ALLOCATIONS
+ #define GUITAR_APP_TRACK_AUDIO_ALLOCATIONS JUCE_DEBUG
+#endif
+
+namespace AudioAllocationTracker
+{
+   #if GUITAR_APP_TRACK_AUDIO_ALLOCATIONS
+    //marks the current thread as running the audio callback for the lifetime of the object
+    //any operator new on that thread in the meantime is counted and hits a jassert
+    class ScopedAudioCallback
+    {
+    public:
+        ScopedAudioCallback();
+        ~ScopedAudioCallback();
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedAudioCallback)
+    };
+
+    //allocations seen inside audio callbacks since startup or the last reset
+    int getAllocationCount();
+    void resetAllocationCount();
+   #else
+    class ScopedAudioCallback
+    {
+    public:
+        ScopedAudioCallback() {}
+    };
+
+    inline int getAllocationCount() { return 0; }
+    inline void resetAllocationCount() {}
+   #endif
+}
@@ -0,0 +1,65 @@
+#include <juce_core/juce_core.h>
+#include "../DSPBenchmark.hpp"
+#include "../PitchAccuracyBench.hpp"
+#include <iostream>
+
+//micro-benchmarks for the DSP hot paths, run on the target machine to accept or reject optimisations
+//
+//  GuitarDSPBenchmark [--hop-size=N] [--block-size=N] [--min-seconds=S] [--quick]
+//  GuitarDSPBenchmark --accuracy [--hop-size=N] [--block-size=N] [--detector=yin|pyin|decimated|mpm]
+//                                 [--engine=fft|direct] [--noise=L]
+//
+//--accuracy plays synthetic notes E2 to E6 through the pitch path and reports latency and error,
+//--detector picks the engine and --engine the difference function of the YIN engines
+//the second table is the per-frame saving of the decimating front end for each engine
+
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+    DSPBenchmark::Settings settings;
+
+    if (args.containsOption("--hop-size"))
+        settings.hopSize = juce::jmax(0, args.getValueForOption("--hop-size").getIntValue());
+    if (args.containsOption("--block-size"))
+        settings.blockSize = juce::jmax(1, args.getValueForOption("--block-size").getIntValue());
+    if (args.containsOption("--min-seconds"))
+        settings.minSecondsPerCase = juce::jmax(0.0, args.getValueForOption("--min-seconds").getDoubleValue());
+
+    if (args.containsOption("--accuracy"))
+    {
+        PitchAccuracyBench::Settings accuracySettings;
+        accuracySettings.hopSize = settings.hopSize;
+        accuracySettings.blockSize = settings.blockSize;
+
+        if (args.containsOption("--detector"))
+        {
+            const auto detector = args.getValueForOption("--detector");
+            accuracySettings.engine = detector.equalsIgnoreCase("pyin")      ? PitchDetector::Engine::probabilisticYin
+                                    : detector.equalsIgnoreCase("decimated") ? PitchDetector::Engine::decimatedYin
+                                    : detector.equalsIgnoreCase("mpm")       ? PitchDetector::Engine::mpm
+                                                                             : PitchDetector::Engine::yin;
+        }
+        if (args.containsOption("--engine"))
+            accuracySettings.differenceEngine = args.getValueForOption("--engine").equalsIgnoreCase("direct")
+                                                      ? YINAudioComponent::DifferenceEngine::Direct
+                                                      : YINAudioComponent::DifferenceEngine::FFT;
+        if (args.containsOption("--noise"))
+            accuracySettings.noiseLevel = juce::jmax(0.0f, args.getValueForOption("--noise").getFloatValue());
+
+        std::cout << PitchAccuracyBench::formatSummary(PitchAccuracyBench::run(accuracySettings), true) << std::flush;
+        return 0;
+    }
+
+    //the app's own configuration only, for a fast check
+    if (args.containsOption("--quick"))
+    {
+        settings.windowSizes = { 8192 };
+        settings.sampleRates = { 48000.0 };
+    }
+
+    std::cout << "hop " << settings.hopSize << " samples, block " << settings.blockSize << " samples\n"
+              << DSPBenchmark::formatResults(DSPBenchmark::runAll(settings)) << "\n"
+              << DSPBenchmark::formatComparisons(DSPBenchmark::compareAllDecimation(settings)) << std::flush;
+
+    return 0;
+}
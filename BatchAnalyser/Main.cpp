@@ -0,0 +1,310 @@
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../DSPKernels.hpp"
+#include "../YINAudioComponent.hpp"
+#include "../TempoDetector.hpp"
+#include <iostream>
+
+//headless pitch and tempo analysis over audio files
+//streams each file through YINAudioComponent and TempoDetector exactly as the app
+//feeds them, one block at a time, and writes the per-frame results as CSV or JSON
+
+const int defaultBlockSize = 512;  //samples per block, matches a typical device buffer
+const int defaultHopSize = 512;    //samples between pitch estimates
+
+struct AnalyserSettings
+{
+    int blockSize = defaultBlockSize;
+    int hopSize = defaultHopSize;
+    bool writeJson = false;
+    YINAudioComponent::DifferenceEngine engine = YINAudioComponent::DifferenceEngine::FFT;
+    juce::File outputDirectory;
+};
+
+struct PitchFrame
+{
+    double timeSeconds;
+    float frequency;  //-1 for frames without a detected pitch
+};
+
+struct OnsetFrame
+{
+    double timeSeconds;
+    double tempo;
+};
+
+struct FileResult
+{
+    juce::File file;
+    bool succeeded = false;
+    juce::String error;
+    double sampleRate = 0.0;
+    double audioSeconds = 0.0;
+    std::vector<PitchFrame> pitchFrames;
+    std::vector<OnsetFrame> onsetFrames;
+};
+
+//streams one file through the detectors block by block
+static FileResult analyseFile(const juce::File& file, const AnalyserSettings& settings)
+{
+    FileResult result;
+    result.file = file;
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr)
+    {
+        result.error = "unsupported or unreadable audio file";
+        return result;
+    }
+
+    const double sampleRate = reader->sampleRate;
+    const int numChannels = static_cast<int>(reader->numChannels);
+    const juce::int64 totalSamples = reader->lengthInSamples;
+
+    juce::AudioBuffer<float> block(numChannels, settings.blockSize);
+    std::vector<float> monoBuffer(static_cast<size_t>(settings.blockSize));
+
+    YINAudioComponent yinProcessor;
+    yinProcessor.initialize(static_cast<float>(sampleRate), settings.blockSize);
+    yinProcessor.setHopSize(settings.hopSize);
+    yinProcessor.setDifferenceEngine(settings.engine);
+
+    TempoDetector tempoDetector;
+    tempoDetector.prepare(sampleRate, settings.blockSize);
+
+    for (juce::int64 position = 0; position < totalSamples; position += settings.blockSize)
+    {
+        const int numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(settings.blockSize), totalSamples - position));
+        reader->read(&block, 0, numSamples, position, true, true);
+
+        //averages signal for mono processing
+        DSPKernels::downmixToMono(monoBuffer.data(), block.getArrayOfReadPointers(), numChannels, 0, numSamples);
+
+        //the block is split at analysis boundaries so every analysed frame gets its own row
+        int offset = 0;
+        while (offset < numSamples)
+        {
+            const int samplesUntilAnalysis = yinProcessor.getSamplesUntilNextAnalysis();
+            const int sliceSize = juce::jmin(numSamples - offset, samplesUntilAnalysis);
+
+            float pitch = yinProcessor.processAudioBuffer(monoBuffer.data() + offset, sliceSize);
+            offset += sliceSize;
+
+            if (sliceSize == samplesUntilAnalysis)
+                result.pitchFrames.push_back({ static_cast<double>(position + offset) / sampleRate, pitch });
+        }
+
+        //onsets carry their own sample position, so each is placed within the block
+        tempoDetector.processBlock(block.getArrayOfReadPointers(), numChannels, 0, numSamples);
+        for (int i = 0; i < tempoDetector.getNumOnsets(); ++i)
+            result.onsetFrames.push_back({ static_cast<double>(tempoDetector.getOnsetSample(i)) / sampleRate, tempoDetector.getCurrentTempo() });
+    }
+
+    result.sampleRate = sampleRate;
+    result.audioSeconds = static_cast<double>(totalSamples) / sampleRate;
+    result.succeeded = true;
+    return result;
+}
+
+//one row per analysed frame or onset
+static void writeCsv(const FileResult& result, juce::OutputStream& out)
+{
+    out << "event,time_seconds,value\n";
+
+    for (const auto& frame : result.pitchFrames)
+        out << "pitch," << juce::String(frame.timeSeconds, 6) << ","
+            << (frame.frequency > 0.0f ? juce::String(frame.frequency, 3) : juce::String()) << "\n";
+
+    for (const auto& onset : result.onsetFrames)
+        out << "onset," << juce::String(onset.timeSeconds, 6) << "," << juce::String(onset.tempo, 3) << "\n";
+}
+
+static void writeJson(const FileResult& result, juce::OutputStream& out)
+{
+    juce::Array<juce::var> pitch;
+    for (const auto& frame : result.pitchFrames)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("time", frame.timeSeconds);
+        entry->setProperty("frequency", frame.frequency > 0.0f ? juce::var(frame.frequency) : juce::var());
+        pitch.add(juce::var(entry));
+    }
+
+    juce::Array<juce::var> onsets;
+    for (const auto& onset : result.onsetFrames)
+    {
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("time", onset.timeSeconds);
+        entry->setProperty("tempo", onset.tempo);
+        onsets.add(juce::var(entry));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("file", result.file.getFullPathName());
+    root->setProperty("sampleRate", result.sampleRate);
+    root->setProperty("durationSeconds", result.audioSeconds);
+    root->setProperty("pitch", pitch);
+    root->setProperty("onsets", onsets);
+
+    out << juce::JSON::toString(juce::var(root)) << "\n";
+}
+
+//writes the results next to the input file unless an output directory was given
+static bool writeResult(const FileResult& result, const AnalyserSettings& settings)
+{
+    auto fileName = result.file.getFileNameWithoutExtension() + (settings.writeJson ? ".analysis.json" : ".analysis.csv");
+    auto outputFile = settings.outputDirectory != juce::File() ? settings.outputDirectory.getChildFile(fileName)
+                                                               : result.file.getSiblingFile(fileName);
+
+    outputFile.deleteFile();
+    juce::FileOutputStream out(outputFile);
+    if (!out.openedOk())
+        return false;
+
+    if (settings.writeJson)
+        writeJson(result, out);
+    else
+        writeCsv(result, out);
+
+    out.flush();
+    return out.getStatus().wasOk();
+}
+
+//expands directories into the audio files they contain
+static juce::Array<juce::File> collectInputFiles(const juce::ArgumentList& args)
+{
+    juce::Array<juce::File> files;
+
+    for (const auto& argument : args.arguments)
+    {
+        if (argument.isOption())
+            continue;
+
+        auto file = argument.resolveAsFile();
+        if (file.isDirectory())
+            files.addArray(file.findChildFiles(juce::File::findFiles, true, "*.wav;*.aif;*.aiff"));
+        else if (file.existsAsFile())
+            files.add(file);
+        else
+            std::cerr << "Skipping missing input: " << argument.text << std::endl;
+    }
+
+    return files;
+}
+
+static void printUsage()
+{
+    std::cout << "GuitarBatchAnalyser [options] <file or directory>...\n"
+                 "  --block-size=N   samples per processing block (default " << defaultBlockSize << ")\n"
+                 "  --hop-size=N     samples between pitch estimates, 0 for non-overlapping windows (default " << defaultHopSize << ")\n"
+                 "  --engine=fft|direct  YIN difference function engine (default fft)\n"
+                 "  --json           write JSON instead of CSV\n"
+                 "  --output=DIR     directory for result files (default: next to each input)\n"
+                 "  --threads=N      worker threads (default: all cores)\n"
+                 "  --run-tests      run the DSP unit tests and exit\n";
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h") || args.size() == 0)
+    {
+        printUsage();
+        return 0;
+    }
+
+    if (args.containsOption("--run-tests"))
+    {
+        juce::UnitTestRunner runner;
+        runner.runAllTests();
+
+        int failures = 0;
+        for (int i = 0; i < runner.getNumResults(); ++i)
+            failures += runner.getResult(i)->failures;
+
+        return failures == 0 ? 0 : 1;
+    }
+
+    AnalyserSettings settings;
+    if (args.containsOption("--block-size"))
+        settings.blockSize = juce::jmax(1, args.getValueForOption("--block-size").getIntValue());
+    if (args.containsOption("--hop-size"))
+        settings.hopSize = juce::jmax(0, args.getValueForOption("--hop-size").getIntValue());
+    if (args.getValueForOption("--engine") == "direct")
+        settings.engine = YINAudioComponent::DifferenceEngine::Direct;
+    settings.writeJson = args.containsOption("--json");
+
+    if (args.containsOption("--output"))
+    {
+        settings.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--output"));
+        settings.outputDirectory.createDirectory();
+    }
+
+    int numThreads = juce::SystemStats::getNumCpus();
+    if (args.containsOption("--threads"))
+        numThreads = juce::jmax(1, args.getValueForOption("--threads").getIntValue());
+
+    auto files = collectInputFiles(args);
+    if (files.isEmpty())
+    {
+        std::cerr << "No audio files to analyse" << std::endl;
+        return 1;
+    }
+
+    //one job per file, each job owns its own reader and detectors
+    std::vector<FileResult> results(static_cast<size_t>(files.size()));
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    {
+        juce::ThreadPool pool(numThreads);
+
+        for (int i = 0; i < files.size(); ++i)
+        {
+            pool.addJob([&results, &files, &settings, i]()
+            {
+                auto& result = results[static_cast<size_t>(i)];
+                result = analyseFile(files[i], settings);
+
+                if (result.succeeded && !writeResult(result, settings))
+                {
+                    result.succeeded = false;
+                    result.error = "could not write results";
+                }
+
+                return juce::ThreadPoolJob::jobHasFinished;
+            });
+        }
+
+        while (pool.getNumJobs() > 0)
+            juce::Thread::sleep(20);
+    }
+
+    auto elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    //summary
+    double totalAudioSeconds = 0.0;
+    int failedFiles = 0;
+    for (const auto& result : results)
+    {
+        if (result.succeeded)
+        {
+            totalAudioSeconds += result.audioSeconds;
+        }
+        else
+        {
+            ++failedFiles;
+            std::cerr << result.file.getFullPathName() << ": " << result.error << std::endl;
+        }
+    }
+
+    std::cout << "Analysed " << (files.size() - failedFiles) << " of " << files.size() << " files, "
+              << juce::String(totalAudioSeconds, 1) << " s of audio in " << juce::String(elapsedSeconds, 2) << " s ("
+              << juce::String(totalAudioSeconds / juce::jmax(elapsedSeconds, 1e-9), 1) << "x real time, "
+              << numThreads << " threads)" << std::endl;
+
+    return failedFiles == 0 ? 0 : 1;
+}
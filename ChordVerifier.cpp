@@ -0,0 +1,483 @@
+#include "ChordVerifier.hpp"
+#include "DSPKernels.hpp"
+#include "NoteMapping.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    //analysis window of at least this long, 8192 samples at 44.1 and 48 kHz
+    //gives bins under 6 Hz so semitones resolve from about 200 Hz up
+    const double minWindowSeconds = 0.15;
+    const int hopsPerWindow = 8;
+
+    //band the pitch class profile is taken from, low E up to the upper harmonics
+    const float lowestFrequency = 70.0f;
+    const float highestFrequency = 2000.0f;
+
+    //RMS of the window below which the strum is not judged
+    const float inputGateLevel = 0.0055f;
+
+    //a note needs a spectral peak this far above the median magnitude of the band
+    const float presenceOverNoise = 8.0f;
+
+    //harmonic used for the fret check is the lowest with semitones at least this many bins apart
+    const float minSemitoneSpacingBins = 2.0f;
+    const int maxHarmonic = 4;
+
+    //frames a note must be heard in before its string counts as hit, and the count cap
+    const int hitFramesToConfirm = 2;
+    const int maxHitCount = 4;
+
+    //chord match changes smaller than this do not notify the UI
+    const float matchChangeToPublish = 0.05f;
+
+    const int fretBits = 5;
+    const juce::uint32 fretMask = (1u << fretBits) - 1u;
+    const int openStringMidiNotes[ChordVerifier::numStrings] = { 64, 59, 55, 50, 45, 40 };
+
+    using PitchModel::pitchClassOf;
+
+    //the published word, masks in the low 32 bits and the float bits of the match in the high 32
+    juce::uint64 packResult(juce::uint32 masks, float chordMatch)
+    {
+        juce::uint32 matchBits = 0;
+        std::memcpy(&matchBits, &chordMatch, sizeof(matchBits));
+        return (static_cast<juce::uint64>(matchBits) << 32) | masks;
+    }
+
+    float getPublishedMatch(juce::uint64 published)
+    {
+        const auto matchBits = static_cast<juce::uint32>(published >> 32);
+        float chordMatch = 0.0f;
+        std::memcpy(&chordMatch, &matchBits, sizeof(chordMatch));
+        return chordMatch;
+    }
+}
+
+//Shape
+ChordVerifier::Shape ChordVerifier::Shape::fromTab(const std::vector<std::pair<int, int>>& positions, const std::vector<int>& mutedStrings)
+{
+    Shape result;
+    result.frets.fill(0);
+
+    for (int stringNumber : mutedStrings)
+        if (stringNumber >= 1 && stringNumber <= numStrings)
+            result.frets[static_cast<size_t>(stringNumber - 1)] = mutedFret;
+
+    for (const auto& position : positions)
+        if (position.first >= 0 && position.first < numStrings)
+            result.frets[static_cast<size_t>(position.first)] = position.second;
+
+    return result;
+}
+
+juce::uint32 ChordVerifier::Shape::pack() const
+{
+    juce::uint32 packed = 0;
+    for (int i = 0; i < numStrings; ++i)
+        packed |= (static_cast<juce::uint32>(juce::jlimit(0, static_cast<int>(fretMask), frets[static_cast<size_t>(i)] + 1)) & fretMask) << (i * fretBits);
+    return packed;
+}
+
+ChordVerifier::Shape ChordVerifier::Shape::unpack(juce::uint32 packed)
+{
+    Shape result;
+    for (int i = 0; i < numStrings; ++i)
+        result.frets[static_cast<size_t>(i)] = static_cast<int>((packed >> (i * fretBits)) & fretMask) - 1;
+    return result;
+}
+
+bool ChordVerifier::Shape::isEmpty() const
+{
+    for (int fret : frets)
+        if (fret != mutedFret)
+            return false;
+    return true;
+}
+
+PitchModel::NoteSet ChordVerifier::Shape::getNotes() const
+{
+    PitchModel::NoteSet notes;
+    for (int i = 0; i < numStrings; ++i)
+        if (frets[static_cast<size_t>(i)] != mutedFret)
+            notes.add(getOpenStringMidiNote(i) + frets[static_cast<size_t>(i)]);
+    return notes;
+}
+
+int ChordVerifier::getOpenStringMidiNote(int stringIndex)
+{
+    return openStringMidiNotes[juce::jlimit(0, numStrings - 1, stringIndex)];
+}
+
+//sizes the FFT, window and band tables for the sample rate
+void ChordVerifier::prepare(double newSampleRate, int maximumBlockSize)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 48000.0;
+
+    const int fftOrder = juce::jmax(10, static_cast<int>(std::ceil(std::log2(sampleRate * minWindowSeconds))));
+    fftSize = 1 << fftOrder;
+    hopSize = fftSize / hopsPerWindow;
+    binWidth = static_cast<float>(sampleRate / fftSize);
+
+    fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+    fftData.assign(static_cast<size_t>(fftSize) * 2, 0.0f);
+    ringBuffer.assign(static_cast<size_t>(fftSize), 0.0f);
+    monoBuffer.assign(static_cast<size_t>(juce::jmax(1, maximumBlockSize)), 0.0f);
+
+    //hann window
+    window.resize(static_cast<size_t>(fftSize));
+    for (int i = 0; i < fftSize; ++i)
+        window[static_cast<size_t>(i)] = 0.5f - 0.5f * std::cos(2.0f * juce::MathConstants<float>::pi * i / (fftSize - 1));
+
+    lowestBin = juce::jmax(1, static_cast<int>(lowestFrequency / binWidth));
+    highestBin = juce::jmin(fftSize / 2, static_cast<int>(highestFrequency / binWidth));
+
+    bandMagnitudes.assign(static_cast<size_t>(highestBin - lowestBin + 1), 0.0f);
+    binPitchClass.assign(static_cast<size_t>(fftSize / 2 + 1), -1);
+    for (int bin = lowestBin; bin <= highestBin; ++bin)
+    {
+        const auto estimate = PitchModel::Tuning().estimate(bin * binWidth);
+        if (estimate.isValid())
+            binPitchClass[static_cast<size_t>(bin)] = static_cast<juce::int8>(pitchClassOf(estimate.midiNote));
+    }
+
+    applyShape(requestedShape.load());
+    reset();
+}
+
+void ChordVerifier::reset()
+{
+    std::fill(ringBuffer.begin(), ringBuffer.end(), 0.0f);
+    writePosition = 0;
+    samplesUntilFrame = hopSize;
+    hitCounters.fill(0);
+    publishedResult.store(0);
+}
+
+//rebuilds the pitch class template for a new shape, no allocation
+void ChordVerifier::applyShape(juce::uint32 packedShape)
+{
+    activeShape = packedShape;
+    shape = Shape::unpack(packedShape);
+
+    chordPitchClasses = shape.getNotes().getPitchClasses();
+    for (size_t pitchClass = 0; pitchClass < chordTemplate.size(); ++pitchClass)
+        chordTemplate[pitchClass] = ((chordPitchClasses >> pitchClass) & 1u) != 0 ? 1.0f : 0.0f;
+
+    hitCounters.fill(0);
+}
+
+bool ChordVerifier::processBlock(const float* const* channels, int numChannels, int startSample, int numSamples)
+{
+    if (fft == nullptr || channels == nullptr || numChannels <= 0)
+        return false;
+
+    bool resultChanged = false;
+    const int chunkCapacity = static_cast<int>(monoBuffer.size());
+
+    for (int chunkStart = 0; chunkStart < numSamples; chunkStart += chunkCapacity)
+    {
+        const int chunkSize = juce::jmin(chunkCapacity, numSamples - chunkStart);
+        DSPKernels::downmixToMono(monoBuffer.data(), channels, numChannels, startSample + chunkStart, chunkSize);
+
+        //fills the sliding window, a frame runs every hop
+        int samplesRead = 0;
+        while (samplesRead < chunkSize)
+        {
+            const int toCopy = juce::jmin(chunkSize - samplesRead, samplesUntilFrame, fftSize - writePosition);
+            std::copy(monoBuffer.data() + samplesRead, monoBuffer.data() + samplesRead + toCopy, ringBuffer.data() + writePosition);
+
+            samplesRead += toCopy;
+            writePosition = (writePosition + toCopy) % fftSize;
+            samplesUntilFrame -= toCopy;
+
+            if (samplesUntilFrame == 0)
+            {
+                resultChanged = analyseFrame() || resultChanged;
+                samplesUntilFrame = hopSize;
+            }
+        }
+    }
+
+    return resultChanged;
+}
+
+//one FFT frame over the window, then the note tests on its spectrum
+bool ChordVerifier::analyseFrame()
+{
+    float sumOfSquares = 0.0f;
+    for (float sample : ringBuffer)
+        sumOfSquares += sample * sample;
+
+    //windowed copy of the ring in time order, the oldest sample is at the write position
+    const int olderSamples = fftSize - writePosition;
+    DSPKernels::applyWindow(fftData.data(), ringBuffer.data() + writePosition, window.data(), olderSamples);
+    DSPKernels::applyWindow(fftData.data() + olderSamples, ringBuffer.data(), window.data() + olderSamples, writePosition);
+    juce::FloatVectorOperations::clear(fftData.data() + fftSize, fftSize);
+
+    fft->performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+    return processSpectrum(fftData.data(), std::sqrt(sumOfSquares / fftSize));
+}
+
+//per string note tests and the pitch class profile
+bool ChordVerifier::processSpectrum(const float* magnitudes, float frameRms)
+{
+    if (fftSize == 0)
+        return false;
+
+    const auto packedShape = requestedShape.load();
+    if (packedShape != activeShape)
+        applyShape(packedShape);
+
+    Result result;
+
+    for (int i = 0; i < numStrings; ++i)
+        if (shape.frets[static_cast<size_t>(i)] != mutedFret)
+            result.expectedStrings |= 1u << i;
+
+    if (shape.isEmpty() || magnitudes == nullptr || frameRms < inputGateLevel)
+    {
+        hitCounters.fill(0);
+        return publish(result);
+    }
+
+    result.active = true;
+
+    //pitch class profile over the band, magnitudes rather than energies so the
+    //strong low harmonics do not swamp the other chord tones
+    std::array<float, 12> chroma {};
+    for (int bin = lowestBin; bin <= highestBin; ++bin)
+        chroma[static_cast<size_t>(binPitchClass[static_cast<size_t>(bin)])] += magnitudes[bin];
+
+    //the median magnitude of the band is the noise floor, the chord's own peaks are too few to move it
+    std::copy(magnitudes + lowestBin, magnitudes + highestBin + 1, bandMagnitudes.begin());
+    auto median = bandMagnitudes.begin() + static_cast<std::ptrdiff_t>(bandMagnitudes.size() / 2);
+    std::nth_element(bandMagnitudes.begin(), median, bandMagnitudes.end());
+    const float noiseFloor = *median;
+
+    //strings to play must carry their note, muted strings are flagged when heard ringing open
+    //unless another string plays the same pitch class
+    for (int i = 0; i < numStrings; ++i)
+    {
+        const int fret = shape.frets[static_cast<size_t>(i)];
+        const int openNote = getOpenStringMidiNote(i);
+        const bool checkString = fret != mutedFret || ((chordPitchClasses >> pitchClassOf(openNote)) & 1u) == 0;
+
+        auto& counter = hitCounters[static_cast<size_t>(i)];
+        if (checkString && isNotePresent(magnitudes, openNote + juce::jmax(0, fret), noiseFloor))
+            counter = juce::jmin(maxHitCount, counter + 1);
+        else
+            counter = juce::jmax(0, counter - 1);
+
+        if (counter >= hitFramesToConfirm)
+        {
+            if (fret != mutedFret)
+                result.hitStrings |= 1u << i;
+            else
+                result.ringingMutedStrings |= 1u << i;
+        }
+    }
+
+    //cosine similarity of the heard pitch classes with the chord's
+    float dot = 0.0f, chromaNorm = 0.0f, templateNorm = 0.0f;
+    for (size_t pitchClass = 0; pitchClass < chroma.size(); ++pitchClass)
+    {
+        dot += chroma[pitchClass] * chordTemplate[pitchClass];
+        chromaNorm += chroma[pitchClass] * chroma[pitchClass];
+        templateNorm += chordTemplate[pitchClass];
+    }
+    result.chordMatch = chromaNorm > 0.0f && templateNorm > 0.0f ? dot / std::sqrt(chromaNorm * templateNorm) : 0.0f;
+
+    return publish(result);
+}
+
+//largest magnitude within a quarter tone of the frequency
+float ChordVerifier::peakMagnitude(const float* magnitudes, float frequency) const
+{
+    const float centreBin = frequency / binWidth;
+    const float halfWidth = juce::jmax(1.0f, centreBin * (std::exp2(1.0f / 24.0f) - 1.0f));
+    const int firstBin = juce::jmax(1, static_cast<int>(std::ceil(centreBin - halfWidth)));
+    const int lastBin = juce::jmin(fftSize / 2, static_cast<int>(std::floor(centreBin + halfWidth)));
+
+    float peak = 0.0f;
+    for (int bin = firstBin; bin <= lastBin; ++bin)
+        peak = juce::jmax(peak, magnitudes[bin]);
+    return peak;
+}
+
+//the fundamental shows the string is sounding, at low notes the bins are too wide to tell
+//neighbouring frets apart so the fret is checked on the first harmonic where they resolve
+bool ChordVerifier::isNotePresent(const float* magnitudes, int midiNote, float noiseFloor) const
+{
+    const float fundamental = NoteMapping::getFrequencyForMidiNote(midiNote);
+    const float threshold = noiseFloor * presenceOverNoise;
+
+    if (peakMagnitude(magnitudes, fundamental) <= threshold)
+        return false;
+
+    const float semitoneRatio = std::exp2(1.0f / 12.0f);
+    int harmonic = 1;
+    while (harmonic < maxHarmonic && fundamental * harmonic * (semitoneRatio - 1.0f) / binWidth < minSemitoneSpacingBins)
+        ++harmonic;
+
+    const float frequency = fundamental * harmonic;
+    const float peak = peakMagnitude(magnitudes, frequency);
+
+    return peak > threshold
+        && peak > peakMagnitude(magnitudes, frequency / semitoneRatio)
+        && peak > peakMagnitude(magnitudes, frequency * semitoneRatio);
+}
+
+//stores the result for the UI, returns true when it differs from the last one
+bool ChordVerifier::publish(const Result& result)
+{
+    const juce::uint32 masks = result.expectedStrings
+                             | (result.hitStrings << numStrings)
+                             | (result.ringingMutedStrings << (2 * numStrings))
+                             | (result.active ? 1u << (3 * numStrings) : 0u);
+
+    const auto published = publishedResult.load();
+    const bool changed = masks != static_cast<juce::uint32>(published)
+                      || std::abs(result.chordMatch - getPublishedMatch(published)) > matchChangeToPublish;
+
+    if (changed)
+        publishedResult.store(packResult(masks, result.chordMatch));
+
+    return changed;
+}
+
+ChordVerifier::Result ChordVerifier::getLatestResult() const
+{
+    const auto published = publishedResult.load();
+    const auto masks = static_cast<juce::uint32>(published);
+    const juce::uint32 stringMask = (1u << numStrings) - 1u;
+
+    Result result;
+    result.expectedStrings = masks & stringMask;
+    result.hitStrings = (masks >> numStrings) & stringMask;
+    result.ringingMutedStrings = (masks >> (2 * numStrings)) & stringMask;
+    result.active = ((masks >> (3 * numStrings)) & 1u) != 0;
+    result.chordMatch = getPublishedMatch(published);
+    return result;
+}
+
+#if JUCE_UNIT_TESTS
+
+#include "SyntheticGuitarSignal.hpp"
+
+class ChordVerifierTests : public juce::UnitTest
+{
+public:
+    ChordVerifierTests() : juce::UnitTest("Chord verifier", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        using Shape = ChordVerifier::Shape;
+
+        const auto cMajor = Shape::fromTab({ { 4, 3 }, { 3, 2 }, { 1, 1 } }, { 6 });
+        const auto eMajor = Shape::fromTab({ { 4, 2 }, { 3, 2 }, { 2, 1 } }, {});
+        const auto dMajor = Shape::fromTab({ { 2, 2 }, { 1, 3 }, { 0, 2 } }, { 5, 6 });
+
+        beginTest("Shapes follow the Chords tab layout");
+        expectEquals(cMajor.frets[5], ChordVerifier::mutedFret);
+        expectEquals(cMajor.frets[4], 3);
+        expectEquals(cMajor.frets[0], 0);
+        expect(Shape::unpack(dMajor.pack()).frets == dMajor.frets);
+        expect(Shape().isEmpty());
+
+        beginTest("Every string of a clean strum is hit");
+        for (const auto& shape : { cMajor, eMajor, dMajor })
+        {
+            auto result = strum(shape, shape);
+            expect(result.active);
+            expectEquals(static_cast<int>(result.hitStrings), static_cast<int>(result.expectedStrings));
+            expectEquals(static_cast<int>(result.ringingMutedStrings), 0);
+            expectGreaterThan(result.chordMatch, 0.6f);
+        }
+
+        beginTest("The wrong chord matches less well");
+        expectLessThan(strum(cMajor, eMajor).chordMatch, strum(cMajor, cMajor).chordMatch - 0.2f);
+
+        beginTest("A string not played is missed");
+        {
+            auto played = cMajor;
+            played.frets[4] = ChordVerifier::mutedFret;
+            auto result = strum(cMajor, played);
+            expect(!result.isStringHit(4));
+            expect(result.isStringHit(3));
+            expect(!result.isChordCorrect());
+        }
+
+        beginTest("A wrong fret is missed");
+        {
+            auto played = dMajor;
+            played.frets[0] = 3;
+            auto result = strum(dMajor, played);
+            expect(!result.isStringHit(0));
+            expect(result.isStringHit(2));
+        }
+
+        beginTest("A muted string left ringing is flagged");
+        {
+            auto played = dMajor;
+            played.frets[5] = 0;
+            auto result = strum(dMajor, played);
+            expect(result.isMutedStringRinging(5));
+            expect(!result.isMutedStringRinging(4));
+        }
+
+        beginTest("Silence is not judged");
+        {
+            ChordVerifier verifier;
+            verifier.prepare(48000.0, 512);
+            verifier.setShape(cMajor);
+            juce::AudioBuffer<float> silence(1, 48000);
+            silence.clear();
+            verifier.processBlock(silence.getArrayOfReadPointers(), 1, 0, silence.getNumSamples());
+            expect(!verifier.getLatestResult().active);
+        }
+    }
+
+private:
+    //strums the played shape with the expected one selected and returns the result after 0.4 s
+    static ChordVerifier::Result strum(const ChordVerifier::Shape& expected, const ChordVerifier::Shape& played)
+    {
+        const double sampleRate = 48000.0;
+        const int numSamples = static_cast<int>(sampleRate * 0.4);
+        const int strumSpacing = 240;
+
+        juce::AudioBuffer<float> input(1, numSamples);
+        input.clear();
+
+        //low string first, as on a downstroke
+        for (int i = ChordVerifier::numStrings - 1, order = 0; i >= 0; --i)
+        {
+            if (played.frets[static_cast<size_t>(i)] == ChordVerifier::mutedFret)
+                continue;
+
+            const int offset = strumSpacing * order++;
+            const int midiNote = ChordVerifier::getOpenStringMidiNote(i) + played.frets[static_cast<size_t>(i)];
+            auto string = SyntheticGuitarSignal::renderNote(sampleRate, NoteMapping::getFrequencyForMidiNote(midiNote), 0.12f,
+                                                            numSamples - offset, i + 1);
+            auto* samples = input.getWritePointer(0);
+            for (int n = offset; n < numSamples; ++n)
+                samples[n] += string[static_cast<size_t>(n - offset)];
+        }
+
+        ChordVerifier verifier;
+        verifier.prepare(sampleRate, 256);
+        verifier.setShape(expected);
+
+        for (int start = 0; start < numSamples; start += 256)
+            verifier.processBlock(input.getArrayOfReadPointers(), 1, start, juce::jmin(256, numSamples - start));
+
+        return verifier.getLatestResult();
+    }
+};
+
+static ChordVerifierTests chordVerifierTests;
+
+#endif
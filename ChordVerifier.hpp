@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+#include "PitchModel.hpp"
+
+//real time chord check for the Chords tab
+//runs one FFT frame every hop over a sliding window and tests each string of the selected
+//shape for its expected note, the fundamental shows the string is sounding and the lowest
+//harmonic that resolves a semitone shows it is fretted correctly
+//frames come from processBlock or from the AnalyserRegistry's shared spectrum through processSpectrum
+//all buffers are sized in prepare so processBlock is safe on the audio thread
+class ChordVerifier
+{
+public:
+    static constexpr int numStrings = 6;   //index 0 is the high e string, 5 the low E
+    static constexpr int mutedFret = -1;
+
+    //fret per string, 0 for open and mutedFret for strings that should not sound
+    struct Shape
+    {
+        std::array<int, numStrings> frets { mutedFret, mutedFret, mutedFret, mutedFret, mutedFret, mutedFret };
+
+        //builds a shape from the Chords tab layout, positions are {string index, fret} and
+        //muted strings are numbered 1 (high e) to 6 (low E), every other string is open
+        static Shape fromTab(const std::vector<std::pair<int, int>>& positions, const std::vector<int>& mutedStrings);
+
+        //packs the frets into one word so the shape can be handed over atomically
+        juce::uint32 pack() const;
+        static Shape unpack(juce::uint32 packed);
+
+        bool isEmpty() const;
+
+        //notes the shape sounds in standard tuning
+        PitchModel::NoteSet getNotes() const;
+    };
+
+    struct Result
+    {
+        juce::uint32 expectedStrings = 0;      //bit per string index that should sound
+        juce::uint32 hitStrings = 0;           //expected strings heard with the right note
+        juce::uint32 ringingMutedStrings = 0;  //muted strings heard ringing open
+        float chordMatch = 0.0f;               //0 to 1 similarity of the heard and expected pitch classes
+        bool active = false;                   //false while the input is too quiet to judge
+
+        bool isStringHit(int stringIndex) const { return (hitStrings >> stringIndex) & 1u; }
+        bool isStringExpected(int stringIndex) const { return (expectedStrings >> stringIndex) & 1u; }
+        bool isMutedStringRinging(int stringIndex) const { return (ringingMutedStrings >> stringIndex) & 1u; }
+        bool isChordCorrect() const { return active && expectedStrings != 0 && hitStrings == expectedStrings && ringingMutedStrings == 0; }
+    };
+
+    ChordVerifier() = default;
+
+    void prepare(double sampleRate, int maximumBlockSize);
+    void reset();
+
+    //selected chord, safe to call from the message thread while audio runs
+    void setShape(const Shape& shape) { requestedShape.store(shape.pack()); }
+
+    //downmixes the block and runs a frame every hop
+    //returns true when the published result changed
+    bool processBlock(const float* const* channels, int numChannels, int startSample, int numSamples);
+
+    //runs the note tests on a frame taken elsewhere, the magnitudes of a Hann windowed frame of
+    //getFFTSize samples as juce::dsp::FFT::performFrequencyOnlyForwardTransform returns them
+    //null magnitudes mark a frame the caller judged too quiet to take
+    //returns true when the published result changed
+    bool processSpectrum(const float* magnitudes, float frameRms);
+
+    //latest result, safe from any thread
+    Result getLatestResult() const;
+
+    int getFFTSize() const { return fftSize; }
+    int getHopSize() const { return hopSize; }
+
+    //standard tuning, E4 B3 G3 D3 A2 E2
+    static int getOpenStringMidiNote(int stringIndex);
+
+private:
+    bool analyseFrame();
+    void applyShape(juce::uint32 packedShape);
+    float peakMagnitude(const float* magnitudes, float frequency) const;
+    bool isNotePresent(const float* magnitudes, int midiNote, float noiseFloor) const;
+    bool publish(const Result& result);
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> fftData;
+    std::vector<float> window;
+    std::vector<float> ringBuffer;
+    std::vector<float> monoBuffer;
+    std::vector<float> bandMagnitudes;      //scratch for the noise floor median
+    std::vector<juce::int8> binPitchClass;  //pitch class of each bin inside the analysis band, -1 outside
+
+    int fftSize = 0;
+    int hopSize = 0;
+    int writePosition = 0;
+    int samplesUntilFrame = 0;
+    int lowestBin = 0;
+    int highestBin = 0;
+    double sampleRate = 48000.0;
+    float binWidth = 1.0f;
+
+    //shape handed over from the message thread and the one the tables were built for
+    std::atomic<juce::uint32> requestedShape { Shape().pack() };
+    juce::uint32 activeShape = Shape().pack();
+    Shape shape;
+    juce::uint16 chordPitchClasses = 0;   //bit per pitch class the shape sounds
+    std::array<float, 12> chordTemplate {};
+    std::array<int, numStrings> hitCounters {};
+
+    //published result, the string masks in the low word and the bits of chordMatch in the high one
+    //so a reader always gets the masks and the match of the same frame
+    std::atomic<juce::uint64> publishedResult { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChordVerifier)
+};
@@ -0,0 +1,355 @@
+#include "DSPBenchmark.hpp"
+#include "ChordVerifier.hpp"
+#include "DSPKernels.hpp"
+#include "NoteMapping.hpp"
+#include "TempoDetector.hpp"
+#include <cmath>
+#include <functional>
+
+namespace
+{
+    //guitar-like test tone, a decaying A2 with a few harmonics and a little noise
+    std::vector<float> makeTestSignal(int numSamples, double sampleRate)
+    {
+        std::vector<float> signal(static_cast<size_t>(numSamples));
+        juce::Random random(1234);
+
+        const double fundamental = 110.0;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            double time = i / sampleRate;
+            double value = 0.0;
+            for (int harmonic = 1; harmonic <= 5; ++harmonic)
+                value += std::sin(juce::MathConstants<double>::twoPi * fundamental * harmonic * time) / harmonic;
+
+            signal[static_cast<size_t>(i)] = static_cast<float>(0.3 * value * std::exp(-time) + 0.01 * (random.nextFloat() - 0.5f));
+        }
+
+        return signal;
+    }
+
+    //runs the case repeatedly until minSeconds have passed, returns nanoseconds per call
+    double timeCalls(const std::function<void()>& call, double minSeconds)
+    {
+        call();  //warm up caches and any lazy setup
+
+        const auto ticksPerSecond = static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        juce::int64 calls = 0;
+        double elapsedSeconds = 0.0;
+
+        do
+        {
+            call();
+            ++calls;
+            elapsedSeconds = static_cast<double>(juce::Time::getHighResolutionTicks() - startTicks) / ticksPerSecond;
+        }
+        while (elapsedSeconds < minSeconds || calls < 3);
+
+        return elapsedSeconds * 1.0e9 / static_cast<double>(calls);
+    }
+
+    //keeps results observable so the optimiser cannot drop the timed work
+    volatile float benchmarkSink = 0.0f;
+
+    //processAudioBuffer fed a hop per call once the window has filled, at a decimation factor
+    DSPBenchmark::Result timeStreamedPitchDetection(int windowSize, double sampleRate, YINAudioComponent::DifferenceEngine engine,
+                                                    int decimationFactor, int hopSize, double minSeconds)
+    {
+        YINAudioComponent yinProcessor;
+        yinProcessor.setDecimationFactor(decimationFactor);
+        yinProcessor.initialize(static_cast<float>(sampleRate), windowSize);
+        const int analysedSize = yinProcessor.getWindowSize();
+        yinProcessor.setDifferenceEngine(engine);
+        yinProcessor.setHopSize(hopSize);
+
+        //a hop per call once the window has filled, block mode takes a whole window per call
+        const int samplesPerCall = yinProcessor.getAnalysisInterval();
+        const int numCalls = 16;
+        auto signal = makeTestSignal(analysedSize + numCalls * samplesPerCall, sampleRate);
+        yinProcessor.processAudioBuffer(signal.data(), analysedSize - samplesPerCall);
+
+        DSPBenchmark::Result result;
+        result.name = juce::String("YIN ") + (engine == YINAudioComponent::DifferenceEngine::FFT ? "fft" : "direct")
+                    + " /" + juce::String(yinProcessor.getDecimationFactor()) + " N=" + juce::String(analysedSize)
+                    + " @" + juce::String(sampleRate / 1000.0, 1) + "k";
+        result.sampleRate = sampleRate;
+        result.samplesPerCall = samplesPerCall;
+
+        int call = 0;
+        result.nanosecondsPerCall = timeCalls([&]()
+        {
+            const int position = analysedSize - samplesPerCall + (call++ % numCalls) * samplesPerCall;
+            benchmarkSink = yinProcessor.processAudioBuffer(signal.data() + position, samplesPerCall);
+        }, minSeconds);
+
+        return result;
+    }
+}
+
+namespace DSPBenchmark
+{
+    double Result::nanosecondsPerSample() const
+    {
+        return samplesPerCall > 0 ? nanosecondsPerCall / samplesPerCall : 0.0;
+    }
+
+    double Result::callsPerSecond() const
+    {
+        return nanosecondsPerCall > 0.0 ? 1.0e9 / nanosecondsPerCall : 0.0;
+    }
+
+    double Result::realTimePercent() const
+    {
+        if (samplesPerCall <= 0 || sampleRate <= 0.0)
+            return 0.0;
+
+        double budgetNanoseconds = samplesPerCall / sampleRate * 1.0e9;
+        return 100.0 * nanosecondsPerCall / budgetNanoseconds;
+    }
+
+    Result timePitchDetection(int windowSize, double sampleRate, YINAudioComponent::DifferenceEngine engine,
+                              int hopSize, double minSeconds)
+    {
+        YINAudioComponent yinProcessor;
+        yinProcessor.initialize(static_cast<float>(sampleRate), windowSize);
+
+        //initialize raises short windows to the minimum, so time and label the window it chose
+        const int analysedSize = yinProcessor.getWindowSize();
+        yinProcessor.setDifferenceEngine(engine);
+
+        auto signal = makeTestSignal(analysedSize, sampleRate);
+
+        Result result;
+        result.name = juce::String("YIN ") + (engine == YINAudioComponent::DifferenceEngine::FFT ? "fft" : "direct")
+                    + (yinProcessor.hasFixedKernels() ? " fixed" : "")
+                    + " N=" + juce::String(analysedSize) + " @" + juce::String(sampleRate / 1000.0, 1) + "k";
+        result.sampleRate = sampleRate;
+
+        //each analysis accounts for one hop of new input, or the whole window without overlap
+        result.samplesPerCall = hopSize > 0 ? juce::jmin(hopSize, analysedSize) : analysedSize;
+        result.nanosecondsPerCall = timeCalls([&]() { benchmarkSink = yinProcessor.process(signal.data(), analysedSize); }, minSeconds);
+
+        return result;
+    }
+
+    Result timeDecimatedPitchDetection(int windowSize, double sampleRate, YINAudioComponent::DifferenceEngine engine,
+                                       int hopSize, double minSeconds)
+    {
+        return timeStreamedPitchDetection(windowSize, sampleRate, engine, YINAudioComponent::automaticDecimation, hopSize, minSeconds);
+    }
+
+    double DecimationComparison::speedup() const
+    {
+        return decimated.nanosecondsPerCall > 0.0 ? fullRate.nanosecondsPerCall / decimated.nanosecondsPerCall : 0.0;
+    }
+
+    DecimationComparison compareDecimation(int windowSize, double sampleRate, YINAudioComponent::DifferenceEngine engine,
+                                           int hopSize, double minSeconds)
+    {
+        DecimationComparison comparison;
+        comparison.fullRate = timeStreamedPitchDetection(windowSize, sampleRate, engine, 1, hopSize, minSeconds);
+        comparison.decimated = timeStreamedPitchDetection(windowSize, sampleRate, engine, YINAudioComponent::automaticDecimation,
+                                                          hopSize, minSeconds);
+        return comparison;
+    }
+
+    Result timeProbabilisticPitchDetection(int windowSize, double sampleRate, int hopSize, double minSeconds)
+    {
+        YINAudioComponent yinProcessor;
+        yinProcessor.initialize(static_cast<float>(sampleRate), windowSize);
+        const int analysedSize = yinProcessor.getWindowSize();
+        yinProcessor.setProbabilistic(true);
+
+        auto signal = makeTestSignal(analysedSize, sampleRate);
+
+        Result result;
+        result.name = "YIN probabilistic N=" + juce::String(analysedSize) + " @" + juce::String(sampleRate / 1000.0, 1) + "k";
+        result.sampleRate = sampleRate;
+        result.samplesPerCall = hopSize > 0 ? juce::jmin(hopSize, analysedSize) : analysedSize;
+        result.nanosecondsPerCall = timeCalls([&]() { benchmarkSink = yinProcessor.process(signal.data(), analysedSize); }, minSeconds);
+
+        return result;
+    }
+
+    Result timeCandidateVerification(int windowSize, double sampleRate, int numCandidates, int hopSize, double minSeconds)
+    {
+        //A minor from A2 upwards, the test tone's A2 is the first candidate so its octave guards run too
+        //and the window never falls back to the full search, which a tone outside the candidates would
+        const int scaleSteps[] = { 0, 2, 3, 5, 7, 8, 10 };
+        std::vector<float> frequencies;
+        for (int i = 0; i < numCandidates; ++i)
+            frequencies.push_back(NoteMapping::getFrequencyForMidiNote(45 + 12 * (i / 7) + scaleSteps[i % 7]));
+
+        YINAudioComponent yinProcessor;
+        yinProcessor.initialize(static_cast<float>(sampleRate), windowSize);
+        const int analysedSize = yinProcessor.getWindowSize();
+        yinProcessor.setCandidateFrequencies(frequencies.data(), numCandidates);
+
+        auto signal = makeTestSignal(analysedSize, sampleRate);
+
+        Result result;
+        result.name = "YIN verify x" + juce::String(numCandidates) + " N=" + juce::String(analysedSize) + " @" + juce::String(sampleRate / 1000.0, 1) + "k";
+        result.sampleRate = sampleRate;
+        result.samplesPerCall = hopSize > 0 ? juce::jmin(hopSize, analysedSize) : analysedSize;
+        result.nanosecondsPerCall = timeCalls([&]() { benchmarkSink = yinProcessor.process(signal.data(), analysedSize); }, minSeconds);
+
+        return result;
+    }
+
+    Result timeDownmix(int numChannels, int blockSize, double sampleRate, double minSeconds)
+    {
+        std::vector<std::vector<float>> channelData(static_cast<size_t>(numChannels), makeTestSignal(blockSize, sampleRate));
+        std::vector<const float*> channels;
+        for (auto& channel : channelData)
+            channels.push_back(channel.data());
+
+        std::vector<float> mono(static_cast<size_t>(blockSize));
+
+        Result result;
+        result.name = "Mono downmix " + juce::String(numChannels) + "ch B=" + juce::String(blockSize);
+        result.sampleRate = sampleRate;
+        result.samplesPerCall = blockSize;
+        result.nanosecondsPerCall = timeCalls([&]()
+        {
+            DSPKernels::downmixToMono(mono.data(), channels.data(), numChannels, 0, blockSize);
+            benchmarkSink = mono[0];
+        }, minSeconds);
+
+        return result;
+    }
+
+    Result timeTempoDetection(int blockSize, double sampleRate, double minSeconds)
+    {
+        TempoDetector tempoDetector;
+        tempoDetector.prepare(sampleRate, blockSize);
+
+        //one half second beat of the test tone looped, a fresh attack every beat at 120 BPM
+        //so onsets and tempo updates are exercised
+        const int blocksPerBeat = juce::jmax(1, static_cast<int>(sampleRate * 0.5 / blockSize));
+        auto signal = makeTestSignal(blocksPerBeat * blockSize, sampleRate);
+        int blockIndex = 0;
+
+        Result result;
+        result.name = "Tempo processBlock B=" + juce::String(blockSize);
+        result.sampleRate = sampleRate;
+        result.samplesPerCall = blockSize;
+        result.nanosecondsPerCall = timeCalls([&]()
+        {
+            tempoDetector.processBlock(signal.data() + (blockIndex++ % blocksPerBeat) * blockSize, blockSize);
+            benchmarkSink = static_cast<float>(tempoDetector.getCurrentTempo());
+        }, minSeconds);
+
+        return result;
+    }
+
+    Result timeChordVerification(double sampleRate, double minSeconds)
+    {
+        ChordVerifier verifier;
+        verifier.prepare(sampleRate, 4096);
+        verifier.setShape(ChordVerifier::Shape::fromTab({ { 3, 2 }, { 2, 2 }, { 1, 2 } }, { 6 }));
+
+        const int hopSize = verifier.getHopSize();
+        auto signal = makeTestSignal(verifier.getFFTSize(), sampleRate);
+        const float* channels[] = { signal.data() };
+        int position = 0;
+
+        Result result;
+        result.name = "Chord verify frame N=" + juce::String(verifier.getFFTSize()) + " @" + juce::String(sampleRate / 1000.0, 1) + "k";
+        result.sampleRate = sampleRate;
+        result.samplesPerCall = hopSize;
+        result.nanosecondsPerCall = timeCalls([&]()
+        {
+            verifier.processBlock(channels, 1, position, hopSize);
+            position = (position + hopSize) % (static_cast<int>(signal.size()) - hopSize + 1);
+            benchmarkSink = verifier.getLatestResult().chordMatch;
+        }, minSeconds);
+
+        return result;
+    }
+
+    std::vector<Result> runAll(const Settings& settings)
+    {
+        std::vector<Result> results;
+
+        for (auto sampleRate : settings.sampleRates)
+            for (auto windowSize : settings.windowSizes)
+                for (auto engine : settings.engines)
+                    results.push_back(timePitchDetection(windowSize, sampleRate, engine, settings.hopSize, settings.minSecondsPerCase));
+
+        for (auto sampleRate : settings.sampleRates)
+            for (auto windowSize : settings.windowSizes)
+                for (auto engine : settings.engines)
+                    results.push_back(timeDecimatedPitchDetection(windowSize, sampleRate, engine, settings.hopSize, settings.minSecondsPerCase));
+
+        for (auto sampleRate : settings.sampleRates)
+            for (auto windowSize : settings.windowSizes)
+                results.push_back(timeProbabilisticPitchDetection(windowSize, sampleRate, settings.hopSize, settings.minSecondsPerCase));
+
+        for (auto sampleRate : settings.sampleRates)
+            for (auto windowSize : settings.windowSizes)
+                for (auto numCandidates : settings.candidateCounts)
+                    results.push_back(timeCandidateVerification(windowSize, sampleRate, numCandidates, settings.hopSize, settings.minSecondsPerCase));
+
+        for (auto sampleRate : settings.sampleRates)
+        {
+            results.push_back(timeDownmix(settings.numChannels, settings.blockSize, sampleRate, settings.minSecondsPerCase));
+            results.push_back(timeTempoDetection(settings.blockSize, sampleRate, settings.minSecondsPerCase));
+            results.push_back(timeChordVerification(sampleRate, settings.minSecondsPerCase));
+        }
+
+        return results;
+    }
+
+    std::vector<DecimationComparison> compareAllDecimation(const Settings& settings)
+    {
+        std::vector<DecimationComparison> comparisons;
+
+        for (auto sampleRate : settings.sampleRates)
+            for (auto windowSize : settings.windowSizes)
+                for (auto engine : settings.engines)
+                    comparisons.push_back(compareDecimation(windowSize, sampleRate, engine, settings.hopSize, settings.minSecondsPerCase));
+
+        return comparisons;
+    }
+
+    juce::String formatResults(const std::vector<Result>& results)
+    {
+        juce::String table;
+        table << juce::String("case").paddedRight(' ', 40)
+              << juce::String("ns/call").paddedLeft(' ', 14)
+              << juce::String("ns/sample").paddedLeft(' ', 12)
+              << juce::String("calls/s").paddedLeft(' ', 12)
+              << juce::String("% RT").paddedLeft(' ', 10) << "\n";
+
+        for (const auto& result : results)
+        {
+            table << result.name.paddedRight(' ', 40)
+                  << juce::String(result.nanosecondsPerCall, 0).paddedLeft(' ', 14)
+                  << juce::String(result.nanosecondsPerSample(), 2).paddedLeft(' ', 12)
+                  << juce::String(result.callsPerSecond(), 0).paddedLeft(' ', 12)
+                  << juce::String(result.realTimePercent(), 2).paddedLeft(' ', 10) << "\n";
+        }
+
+        return table;
+    }
+
+    juce::String formatComparisons(const std::vector<DecimationComparison>& comparisons)
+    {
+        juce::String table;
+        table << juce::String("decimation").paddedRight(' ', 40)
+              << juce::String("full ns/frame").paddedLeft(' ', 16)
+              << juce::String("ns/frame").paddedLeft(' ', 14)
+              << juce::String("speedup").paddedLeft(' ', 10) << "\n";
+
+        for (const auto& comparison : comparisons)
+        {
+            table << comparison.decimated.name.paddedRight(' ', 40)
+                  << juce::String(comparison.fullRate.nanosecondsPerCall, 0).paddedLeft(' ', 16)
+                  << juce::String(comparison.decimated.nanosecondsPerCall, 0).paddedLeft(' ', 14)
+                  << (juce::String(comparison.speedup(), 1) + "x").paddedLeft(' ', 10) << "\n";
+        }
+
+        return table;
+    }
+}
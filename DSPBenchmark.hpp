@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <juce_core/juce_core.h>
+#include "YINAudioComponent.hpp"
+
+//micro-benchmarks for the DSP hot paths
+//each case is timed until a minimum run time has passed and reported per call,
+//per input sample and as a share of the real-time budget for the samples a call consumes
+namespace DSPBenchmark
+{
+    struct Result
+    {
+        juce::String name;
+        double nanosecondsPerCall = 0.0;
+        int samplesPerCall = 0;      //input samples each call accounts for (hop, block)
+        double sampleRate = 0.0;
+
+        double nanosecondsPerSample() const;
+        double callsPerSecond() const;
+        double realTimePercent() const;  //time per call over the audio duration it covers
+    };
+
+    struct Settings
+    {
+        std::vector<int> windowSizes { 8192, 16384 };   //YINAudioComponent raises shorter windows to 8192
+        std::vector<double> sampleRates { 44100.0, 48000.0, 96000.0 };
+        std::vector<YINAudioComponent::DifferenceEngine> engines { YINAudioComponent::DifferenceEngine::Direct,
+                                                                   YINAudioComponent::DifferenceEngine::FFT };
+        int hopSize = 512;         //samples between pitch estimates in the app
+        int blockSize = 512;       //device block size for the per-block paths
+        int numChannels = 2;       //channels for the downmix case
+        std::vector<int> candidateCounts { 1, 7 };  //the required note alone and a whole scale
+        double minSecondsPerCase = 0.2;
+    };
+
+    //one YIN analysis of a full window, results are named after the window initialize settled on
+    Result timePitchDetection(int windowSize, double sampleRate, YINAudioComponent::DifferenceEngine engine,
+                              int hopSize, double minSeconds);
+
+    //the same analysis behind the decimating front end at the factor picked for the rate, fed a hop
+    //per call so the filtering of each hop is counted with the analysis it completes
+    Result timeDecimatedPitchDetection(int windowSize, double sampleRate, YINAudioComponent::DifferenceEngine engine,
+                                       int hopSize, double minSeconds);
+
+    //the per-frame cost at the full rate against the decimated one, the same detector and signal fed a
+    //hop per call, so the saving of the front end is measured rather than assumed
+    struct DecimationComparison
+    {
+        Result fullRate;
+        Result decimated;
+
+        double speedup() const;   //full rate time over decimated time
+    };
+
+    DecimationComparison compareDecimation(int windowSize, double sampleRate, YINAudioComponent::DifferenceEngine engine,
+                                           int hopSize, double minSeconds);
+
+    //probabilistic mode, the dip search and one step of the Viterbi tracker on top of the full search
+    Result timeProbabilisticPitchDetection(int windowSize, double sampleRate, int hopSize, double minSeconds);
+
+    //the restricted lag search of verification mode for a number of candidates
+    Result timeCandidateVerification(int windowSize, double sampleRate, int numCandidates, int hopSize, double minSeconds);
+
+    //the mono downmix done once per block by AnalyserRegistry::process
+    Result timeDownmix(int numChannels, int blockSize, double sampleRate, double minSeconds);
+
+    //TempoDetector::processBlock for one mono block as the Tempo tab feeds it, onset detection included
+    Result timeTempoDetection(int blockSize, double sampleRate, double minSeconds);
+
+    //ChordVerifier::processBlock fed one hop per call, so every call runs an FFT frame
+    Result timeChordVerification(double sampleRate, double minSeconds);
+
+    std::vector<Result> runAll(const Settings& settings);
+
+    //every window, rate and engine of the settings
+    std::vector<DecimationComparison> compareAllDecimation(const Settings& settings);
+
+    //fixed width tables for console output
+    juce::String formatResults(const std::vector<Result>& results);
+    juce::String formatComparisons(const std::vector<DecimationComparison>& comparisons);
+}
@@ -0,0 +1,208 @@
+#include "DSPKernels.hpp"
+#include <cmath>
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+ #define GUITAR_APP_DSP_NEON 1
+ #include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define GUITAR_APP_DSP_SSE 1
+ #include <emmintrin.h>
+#endif
+
+namespace DSPKernels
+{
+    //windowing goes through FloatVectorOperations, which uses vDSP on Apple platforms
+    void applyWindow(float* dest, const float* source, const float* window, int numSamples)
+    {
+        juce::FloatVectorOperations::multiply(dest, source, window, numSamples);
+    }
+
+    float sumOfMagnitudes(const float* source, int numSamples)
+    {
+        int i = 0;
+
+       #if GUITAR_APP_DSP_NEON
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            acc0 = vaddq_f32(acc0, vabsq_f32(vld1q_f32(source + i)));
+            acc1 = vaddq_f32(acc1, vabsq_f32(vld1q_f32(source + i + 4)));
+        }
+        float lanes[4];
+        vst1q_f32(lanes, vaddq_f32(acc0, acc1));
+        float sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+       #elif GUITAR_APP_DSP_SSE
+        const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            acc0 = _mm_add_ps(acc0, _mm_and_ps(_mm_loadu_ps(source + i), signMask));
+            acc1 = _mm_add_ps(acc1, _mm_and_ps(_mm_loadu_ps(source + i + 4), signMask));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+        float sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+       #else
+        float sum = 0.0f;
+       #endif
+
+        //remaining samples
+        for (; i < numSamples; ++i)
+            sum += std::abs(source[i]);
+
+        return sum;
+    }
+
+    float sumOfSquaredDifferences(const float* a, const float* b, int numSamples)
+    {
+        int i = 0;
+
+       #if GUITAR_APP_DSP_NEON
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            float32x4_t diff0 = vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i));
+            float32x4_t diff1 = vsubq_f32(vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+            acc0 = vmlaq_f32(acc0, diff0, diff0);
+            acc1 = vmlaq_f32(acc1, diff1, diff1);
+        }
+        float lanes[4];
+        vst1q_f32(lanes, vaddq_f32(acc0, acc1));
+        float sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+       #elif GUITAR_APP_DSP_SSE
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            __m128 diff0 = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+            __m128 diff1 = _mm_sub_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(diff0, diff0));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(diff1, diff1));
+        }
+        float lanes[4];
+        _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+        float sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+       #else
+        float sum = 0.0f;
+       #endif
+
+        //remaining samples
+        for (; i < numSamples; ++i)
+        {
+            float diff = a[i] - b[i];
+            sum += diff * diff;
+        }
+
+        return sum;
+    }
+
+    void downmixToMono(float* dest, const float* const* channels, int numChannels, int startSample, int numSamples)
+    {
+        if (numChannels <= 0)
+            return;
+
+        juce::FloatVectorOperations::copy(dest, channels[0] + startSample, numSamples);
+        for (int channel = 1; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::add(dest, channels[channel] + startSample, numSamples);
+
+        if (numChannels > 1)
+            juce::FloatVectorOperations::multiply(dest, 1.0f / numChannels, numSamples);
+    }
+
+    void applyWindowScalar(float* dest, const float* source, const float* window, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = source[i] * window[i];
+    }
+
+    float sumOfMagnitudesScalar(const float* source, int numSamples)
+    {
+        float sum = 0.0f;
+        for (int i = 0; i < numSamples; ++i)
+            sum += std::abs(source[i]);
+
+        return sum;
+    }
+
+    float sumOfSquaredDifferencesScalar(const float* a, const float* b, int numSamples)
+    {
+        float sum = 0.0f;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float diff = a[i] - b[i];
+            sum += diff * diff;
+        }
+
+        return sum;
+    }
+}
+
+#if JUCE_UNIT_TESTS
+
+//checks every vectorised kernel against its scalar reference
+//lengths cover the SIMD tails and the offsets cover unaligned loads
+class DSPKernelsTests : public juce::UnitTest
+{
+public:
+    DSPKernelsTests() : juce::UnitTest("DSP kernels", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        using namespace DSPKernels;
+
+        auto random = getRandom();
+        std::vector<float> a(4096 + 8), b(4096 + 8), window(4096 + 8);
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            a[i] = random.nextFloat() * 2.0f - 1.0f;
+            b[i] = random.nextFloat() * 2.0f - 1.0f;
+            window[i] = random.nextFloat();
+        }
+
+        const int lengths[] = { 0, 1, 3, 7, 8, 9, 15, 16, 17, 255, 1023, 4096 };
+        const int offsets[] = { 0, 1, 2, 3 };
+
+        beginTest("applyWindow matches scalar");
+        for (int length : lengths)
+            for (int offset : offsets)
+            {
+                std::vector<float> expected(static_cast<size_t>(length) + 1), actual(static_cast<size_t>(length) + 1);
+                applyWindowScalar(expected.data(), a.data() + offset, window.data() + offset, length);
+                applyWindow(actual.data(), a.data() + offset, window.data() + offset, length);
+                for (int i = 0; i < length; ++i)
+                    expectWithinAbsoluteError(actual[i], expected[i], 1e-6f);
+            }
+
+        beginTest("sumOfMagnitudes matches scalar");
+        for (int length : lengths)
+            for (int offset : offsets)
+                expectWithinRelativeTolerance(sumOfMagnitudes(a.data() + offset, length),
+                                              sumOfMagnitudesScalar(a.data() + offset, length));
+
+        beginTest("sumOfSquaredDifferences matches scalar");
+        for (int length : lengths)
+            for (int offset : offsets)
+            {
+                //misaligned against each other, as the YIN lag loop is
+                expectWithinRelativeTolerance(sumOfSquaredDifferences(a.data() + offset, b.data() + 3 - offset, length),
+                                              sumOfSquaredDifferencesScalar(a.data() + offset, b.data() + 3 - offset, length));
+                expectWithinRelativeTolerance(sumOfSquaredDifferences(a.data(), a.data() + offset, length),
+                                              sumOfSquaredDifferencesScalar(a.data(), a.data() + offset, length));
+            }
+    }
+
+private:
+    //summation order differs between the paths, so sums are compared relative to their size
+    void expectWithinRelativeTolerance(float actual, float expected)
+    {
+        expectWithinAbsoluteError(actual, expected, 1e-5f * juce::jmax(1.0f, std::abs(expected)));
+    }
+};
+
+static DSPKernelsTests dspKernelsTests;
+
+#endif
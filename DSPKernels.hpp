@@ -0,0 +1,26 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//vectorised kernels for the per-frame DSP hot loops
+//SSE2 and NEON paths are picked at compile time, other targets use the scalar versions
+//the scalar versions are kept public as the reference the unit tests compare against
+namespace DSPKernels
+{
+    //dest[i] = source[i] * window[i], dest may alias source
+    void applyWindow(float* dest, const float* source, const float* window, int numSamples);
+
+    //sum of |source[i]|
+    float sumOfMagnitudes(const float* source, int numSamples);
+
+    //sum of (a[i] - b[i])^2, the inner loop of the direct YIN difference function
+    float sumOfSquaredDifferences(const float* a, const float* b, int numSamples);
+
+    //averages numChannels channels into dest, the mono downmix ahead of pitch detection
+    void downmixToMono(float* dest, const float* const* channels, int numChannels, int startSample, int numSamples);
+
+    //scalar references
+    void applyWindowScalar(float* dest, const float* source, const float* window, int numSamples);
+    float sumOfMagnitudesScalar(const float* source, int numSamples);
+    float sumOfSquaredDifferencesScalar(const float* a, const float* b, int numSamples);
+}
@@ -0,0 +1,203 @@
+#include "Decimator.hpp"
+#include <cmath>
+
+//-6 dB point, the passband reaches the top fundamentals but harmonics close to the new Nyquist are
+//removed, at a few samples per period they would make the dips between two lags too shallow for YIN
+const double cutoffOfOutputNyquist = 0.3;
+
+
+void Decimator::prepare(int newFactor)
+{
+    factor = 1;
+    while (factor * 2 <= juce::jlimit(1, maxFactor, newFactor))
+        factor *= 2;
+
+    if (factor == 1)
+    {
+        taps.assign(1, 1.0f);
+    }
+    else
+    {
+        //Blackman windowed sinc, odd length so the delay is a whole number of samples
+        const int numTaps = tapsPerPhase * factor + 1;
+        const double cutoff = cutoffOfOutputNyquist * 0.5 / factor;   //cycles per input sample
+        const double centre = (numTaps - 1) / 2.0;
+        const double pi = juce::MathConstants<double>::pi;
+
+        taps.resize(static_cast<size_t>(numTaps));
+        double sum = 0.0;
+        for (int k = 0; k < numTaps; ++k)
+        {
+            const double t = k - centre;
+            const double sinc = t == 0.0 ? 2.0 * cutoff : std::sin(2.0 * pi * cutoff * t) / (pi * t);
+            const double phase = 2.0 * pi * k / (numTaps - 1);
+            const double window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+            const double tap = sinc * window;
+            taps[static_cast<size_t>(numTaps - 1 - k)] = static_cast<float>(tap);
+            sum += tap;
+        }
+
+        //unity gain at DC
+        for (auto& tap : taps)
+            tap = static_cast<float>(tap / sum);
+    }
+
+    history.assign(2 * taps.size(), 0.0f);
+    reset();
+}
+
+void Decimator::reset()
+{
+    std::fill(history.begin(), history.end(), 0.0f);
+    writePosition = 0;
+    pendingInputs = 0;
+    pendingMagnitude = 0.0f;
+}
+
+int Decimator::getFactorForSampleRate(double sampleRate)
+{
+    int rateFactor = 1;
+    while (rateFactor < maxFactor && sampleRate / (rateFactor * 2) >= minimumOutputRate)
+        rateFactor *= 2;
+
+    return rateFactor;
+}
+
+int Decimator::process(const float* input, int numInput, float* output, float* magnitudes)
+{
+    if (input == nullptr || output == nullptr || numInput <= 0 || taps.empty())
+        return 0;
+
+    if (factor == 1)
+    {
+        std::copy(input, input + numInput, output);
+        if (magnitudes != nullptr)
+            for (int i = 0; i < numInput; ++i)
+                magnitudes[i] = std::abs(input[i]);
+
+        return numInput;
+    }
+
+    const int numTaps = getNumTaps();
+    int numOutput = 0;
+
+    for (int i = 0; i < numInput; ++i)
+    {
+        history[static_cast<size_t>(writePosition)] = input[i];
+        history[static_cast<size_t>(writePosition + numTaps)] = input[i];
+        writePosition = writePosition + 1 < numTaps ? writePosition + 1 : 0;
+        pendingMagnitude += std::abs(input[i]);
+
+        if (++pendingInputs < factor)
+            continue;
+
+        //the latest numTaps samples, oldest first, start at the write position
+        const float* window = history.data() + writePosition;
+        float sum = 0.0f;
+        for (int k = 0; k < numTaps; ++k)
+            sum += taps[static_cast<size_t>(k)] * window[k];
+
+        if (magnitudes != nullptr)
+            magnitudes[numOutput] = pendingMagnitude;
+
+        output[numOutput++] = sum;
+        pendingInputs = 0;
+        pendingMagnitude = 0.0f;
+    }
+
+    return numOutput;
+}
+
+#if JUCE_UNIT_TESTS
+
+class DecimatorTests : public juce::UnitTest
+{
+public:
+    DecimatorTests() : juce::UnitTest("Decimator", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        beginTest("Factors keep the output rate above the minimum");
+        expectEquals(Decimator::getFactorForSampleRate(44100.0), 4);
+        expectEquals(Decimator::getFactorForSampleRate(48000.0), 4);
+        expectEquals(Decimator::getFactorForSampleRate(96000.0), 8);
+        expectEquals(Decimator::getFactorForSampleRate(8000.0), 1);
+
+        beginTest("Fundamentals pass and the harmonics near the new Nyquist are rejected");
+        for (int factor : { 4, 8 })
+        {
+            const double inputRate = 12000.0 * factor;
+            for (double fundamental : { 82.4, 659.3, 1318.5 })   //low E, E5, E6
+                expectWithinAbsoluteError(getGain(factor, inputRate, fundamental), 1.0f, 0.01f);
+
+            for (double harmonic : { 3000.0, 5500.0, 7000.0, 20000.0 })
+                expectLessThan(getGain(factor, inputRate, harmonic), 0.001f);
+        }
+
+        beginTest("Blocks of any size give the same output");
+        {
+            const int numInput = 4000;
+            std::vector<float> input(static_cast<size_t>(numInput));
+            juce::Random random(7);
+            for (auto& sample : input)
+                sample = random.nextFloat() * 2.0f - 1.0f;
+
+            Decimator whole, pieces;
+            whole.prepare(8);
+            pieces.prepare(8);
+
+            std::vector<float> wholeOutput(static_cast<size_t>(numInput)), pieceOutput(static_cast<size_t>(numInput));
+            const int numWhole = whole.process(input.data(), numInput, wholeOutput.data());
+            expectEquals(numWhole, numInput / 8);
+
+            int numPieces = 0;
+            for (int offset = 0, size = 1; offset < numInput; offset += size, size = size % 37 + 3)
+            {
+                const int blockSize = juce::jmin(size, numInput - offset);
+                const int expected = (pieces.getPendingInputs() + blockSize) / 8;
+                const int written = pieces.process(input.data() + offset, blockSize, pieceOutput.data() + numPieces);
+                expectEquals(written, expected);
+                numPieces += written;
+            }
+
+            expectEquals(numPieces, numWhole);
+            for (int i = 0; i < numWhole; ++i)
+                expectEquals(pieceOutput[static_cast<size_t>(i)], wholeOutput[static_cast<size_t>(i)]);
+        }
+
+        beginTest("A factor of 1 passes samples straight through");
+        {
+            Decimator passThrough;
+            passThrough.prepare(1);
+            const float input[] = { 0.1f, -0.2f, 0.3f };
+            float output[3] = {};
+            expectEquals(passThrough.process(input, 3, output), 3);
+            expectEquals(output[2], 0.3f);
+            expectEquals(passThrough.getLatency(), 0);
+        }
+    }
+
+private:
+    //peak of the settled output for a unit sine
+    static float getGain(int factor, double sampleRate, double frequency)
+    {
+        Decimator decimator;
+        decimator.prepare(factor);
+
+        const int numInput = 16384;
+        std::vector<float> input(static_cast<size_t>(numInput)), output(static_cast<size_t>(numInput));
+        for (int i = 0; i < numInput; ++i)
+            input[static_cast<size_t>(i)] = static_cast<float>(std::sin(2.0 * juce::MathConstants<double>::pi * frequency * i / sampleRate));
+
+        const int numOutput = decimator.process(input.data(), numInput, output.data());
+        float peak = 0.0f;
+        for (int i = decimator.getNumTaps() / factor + 1; i < numOutput; ++i)
+            peak = juce::jmax(peak, std::abs(output[static_cast<size_t>(i)]));
+
+        return peak;
+    }
+};
+
+static DecimatorTests decimatorTests;
+
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <juce_core/juce_core.h>
+
+//anti-aliasing decimator for the front of the pitch path
+//guitar fundamentals sit below about 1.4 kHz, so the detectors can run at a fraction of the
+//device rate, a windowed sinc low-pass keeps the band below the new Nyquist and only every
+//factor-th output of the filter is computed, the polyphase form, so a kept sample costs the
+//same as one of the full rate filter and the others cost nothing but the copy into the history
+class Decimator
+{
+public:
+    static constexpr int maxFactor = 8;
+    static constexpr int tapsPerPhase = 64;
+    static constexpr double minimumOutputRate = 11000.0;   //4x from 44.1 and 48 kHz, 8x from 88.2 and 96 kHz
+
+    Decimator() = default;
+
+    //designs the filter for a factor of 1, 2, 4 or 8 and clears the history, 1 passes samples straight through
+    void prepare(int factor);
+    void reset();
+
+    //largest factor that keeps the output rate at or above minimumOutputRate
+    static int getFactorForSampleRate(double sampleRate);
+
+    //filters numInput samples and writes the kept ones to output, returns how many were written
+    //output needs room for (numInput + getPendingInputs()) / getFactor() samples
+    //magnitudes, when given, gets the sum of |input| over the inputs behind each kept sample, so
+    //level gates downstream can still judge the input before the low-pass
+    int process(const float* input, int numInput, float* output, float* magnitudes = nullptr);
+
+    int getFactor() const { return factor; }
+    int getNumTaps() const { return static_cast<int>(taps.size()); }
+
+    //inputs taken since the last output, the next output comes after getFactor() - getPendingInputs() more
+    int getPendingInputs() const { return pendingInputs; }
+
+    //group delay of the filter in input samples
+    int getLatency() const { return (getNumTaps() - 1) / 2; }
+
+private:
+    int factor = 1;
+    std::vector<float> taps;   //reversed, so a kept output is a dot product with the history in time order
+
+    //delay line written twice, numTaps apart, so the latest numTaps samples are always contiguous
+    std::vector<float> history;
+    int writePosition = 0;
+    int pendingInputs = 0;
+    float pendingMagnitude = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Decimator)
+};
@@ -0,0 +1,161 @@
+#include "EnergyGate.hpp"
+#include <cmath>
+
+const double envelopeReleaseSeconds = 0.05;  //time constant the envelope falls with, attacks follow the block RMS at once
+const double floorRiseDbPerSecond = 3.0;     //slow enough that a ringing note decays faster than the floor rises
+const float minimumNoiseFloor = 1.0e-5f;     //about -100 dBFS, keeps the level ratios finite in digital silence
+const float initialNoiseFloor = 0.001f;      //quiet input assumed at the start so a strum straight away opens the gate
+const float minimumOpenLevel = 0.002f;       //RMS below this never opens the gate, about -54 dBFS
+const float onsetOverFloor = 4.0f;           //12 dB above the floor opens at once
+const float sustainOverFloor = 2.0f;         //6 dB above the floor opens once held for sustainSeconds
+const double sustainSeconds = 0.1;
+const float closeOverFloor = 1.4f;           //3 dB above the floor, below it for hangSeconds closes
+const double hangSeconds = 0.25;
+
+
+void EnergyGate::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 48000.0;
+    reset();
+}
+
+//the noise floor is learnt again from the quiet starting level
+void EnergyGate::reset()
+{
+    envelope = 0.0f;
+    noiseFloor = initialNoiseFloor;
+    open = false;
+    samplesAboveSustainLevel = 0;
+    samplesBelowCloseLevel = 0;
+}
+
+bool EnergyGate::process(float rms, int numSamples)
+{
+    if (numSamples <= 0)
+        return open;
+
+    const double seconds = numSamples / sampleRate;
+    envelope = juce::jmax(rms, envelope * static_cast<float>(std::exp(-seconds / envelopeReleaseSeconds)));
+
+    //the floor follows the envelope straight down and rises at most floorRiseDbPerSecond
+    if (envelope < noiseFloor)
+        noiseFloor = envelope;
+    else
+        noiseFloor = juce::jmin(envelope, noiseFloor * static_cast<float>(std::pow(10.0, floorRiseDbPerSecond * seconds / 20.0)));
+
+    noiseFloor = juce::jmax(minimumNoiseFloor, noiseFloor);
+
+    const float overFloor = envelope / noiseFloor;
+    const bool loudEnough = envelope >= minimumOpenLevel;
+
+    if (!open)
+    {
+        samplesAboveSustainLevel = loudEnough && overFloor >= sustainOverFloor ? samplesAboveSustainLevel + numSamples : 0;
+
+        if (loudEnough && (overFloor >= onsetOverFloor || samplesAboveSustainLevel >= static_cast<int>(sustainSeconds * sampleRate)))
+        {
+            open = true;
+            samplesBelowCloseLevel = 0;
+        }
+    }
+    else
+    {
+        samplesBelowCloseLevel = !loudEnough || overFloor < closeOverFloor ? samplesBelowCloseLevel + numSamples : 0;
+
+        if (samplesBelowCloseLevel >= static_cast<int>(hangSeconds * sampleRate))
+        {
+            open = false;
+            samplesAboveSustainLevel = 0;
+        }
+    }
+
+    return open;
+}
+
+#if JUCE_UNIT_TESTS
+
+class EnergyGateTests : public juce::UnitTest
+{
+public:
+    EnergyGateTests() : juce::UnitTest("Energy gate", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        const double sampleRate = 48000.0;
+        const int blockSize = 512;
+        const double blockSeconds = blockSize / sampleRate;
+
+        beginTest("Digital silence stays closed");
+        {
+            EnergyGate gate;
+            gate.prepare(sampleRate);
+            expect(!feed(gate, 0.0f, 2.0, blockSize).first);
+        }
+
+        beginTest("Steady hiss is learnt and ignored");
+        {
+            EnergyGate gate;
+            gate.prepare(sampleRate);
+            feed(gate, 0.0005f, 1.0, blockSize);
+            expect(gate.process(0.02f, blockSize));
+            expect(!feed(gate, 0.02f, 12.0, blockSize).second);
+            expectWithinAbsoluteError(gate.getNoiseFloor(), 0.02f, 1.0e-4f);
+        }
+
+        beginTest("A pluck over hiss opens at once and closes after its tail");
+        {
+            EnergyGate gate;
+            gate.prepare(sampleRate);
+            feed(gate, 0.01f, 12.0, blockSize);
+            expect(!gate.isOpen());
+
+            const double decaySeconds = 0.5;
+            double openSeconds = 0.0, closedAt = -1.0;
+            for (double time = 0.0; time < 5.0; time += blockSeconds)
+            {
+                const float rms = 0.2f * static_cast<float>(std::exp(-time / decaySeconds)) + 0.01f;
+                const bool open = gate.process(rms, blockSize);
+
+                if (time == 0.0)
+                    expect(open);
+                if (open)
+                    openSeconds += blockSeconds;
+                else if (closedAt < 0.0)
+                    closedAt = time;
+            }
+
+            //the pluck is 3 dB over the hiss after about 1.8 s, then the hang
+            expectGreaterThan(openSeconds, 1.5);
+            expectWithinAbsoluteError(closedAt, 2.0, 0.5);
+        }
+
+        beginTest("Energy that is held opens the gate");
+        {
+            EnergyGate gate;
+            gate.prepare(sampleRate);
+            feed(gate, 0.001f, 1.0, blockSize);
+
+            //three times the floor, under the onset ratio
+            int blocksToOpen = 0;
+            while (!gate.process(0.003f, blockSize) && blocksToOpen < 100)
+                ++blocksToOpen;
+
+            expectWithinAbsoluteError(blocksToOpen * blockSeconds, 0.1, 2.0 * blockSeconds);
+        }
+    }
+
+private:
+    //feeds a steady level, returns whether the gate was ever open and whether it is open at the end
+    static std::pair<bool, bool> feed(EnergyGate& gate, float rms, double seconds, int blockSize)
+    {
+        bool everOpen = false;
+        const int numBlocks = static_cast<int>(seconds * 48000.0 / blockSize);
+        for (int i = 0; i < numBlocks; ++i)
+            everOpen = gate.process(rms, blockSize) || everOpen;
+        return { everOpen, gate.isOpen() };
+    }
+};
+
+static EnergyGateTests energyGateTests;
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//decides from block levels alone whether the input is worth the expensive analysis
+//an envelope follower on the block RMS is compared with a noise floor that drops straight to
+//any quieter level and creeps up slowly, so hiss and room noise are learnt and ignored
+//the gate opens at once on an onset well above the floor or after energy has stayed above it
+//for a moment, and holds through a short hang so note tails are still analysed
+class EnergyGate
+{
+public:
+    EnergyGate() = default;
+
+    void prepare(double sampleRate);
+    void reset();
+
+    //feeds the RMS of a block of numSamples, returns whether the gate is open
+    bool process(float rms, int numSamples);
+
+    bool isOpen() const { return open; }
+    float getEnvelope() const { return envelope; }
+    float getNoiseFloor() const { return noiseFloor; }
+
+private:
+    double sampleRate = 48000.0;
+    float envelope = 0.0f;
+    float noiseFloor = 0.0f;
+    bool open = false;
+    int samplesAboveSustainLevel = 0;
+    int samplesBelowCloseLevel = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EnergyGate)
+};
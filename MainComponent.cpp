@@ -1,10 +1,13 @@
 #include "MainComponent.hpp"
 #include "CustomLookAndFeel.hpp"
+#include "AudioAllocationTracker.hpp"
 
 
 //MainComponent
 MainComponent::MainComponent()
-    : tabs(juce::TabbedButtonBar::TabsAtBottom)
+    : tabs(juce::TabbedButtonBar::TabsAtBottom),
+      tab1(library),
+      tab2(library)
 {
     DBG("MainComponent Constructor Called");
 
@@ -34,6 +37,14 @@ MainComponent::MainComponent()
         tabs.addTab(std::get<0>(config), juce::Colours::transparentBlack, std::get<1>(config), false);
     }
 
+    //the chord check only runs in front, pitch and tempo keep listening behind other tabs
+    analysers.add(tab1, AnalyserRegistry::RunMode::whenActive);
+    analysers.add(tab2, AnalyserRegistry::RunMode::alwaysRun);
+    analysers.add(tab3, AnalyserRegistry::RunMode::alwaysRun);
+
+    tabs.getTabbedButtonBar().addChangeListener(this);
+    changeListenerCallback(&tabs.getTabbedButtonBar());
+
     //Initialize audio
     setAudioChannels(1, 0);
 }
@@ -41,6 +52,7 @@ MainComponent::MainComponent()
 //MainComponent destructor
 MainComponent::~MainComponent()
 {
+    tabs.getTabbedButtonBar().removeChangeListener(this);
     tabs.setLookAndFeel(nullptr);
     setLookAndFeel(nullptr);
     shutdownAudio();
@@ -72,42 +84,44 @@ void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate
     DBG("prepareToPlay called with sampleRate: " + juce::String(sampleRate) +
         " and samplesPerBlockExpected: " + juce::String(samplesPerBlockExpected));
 
-    //calls prepare to play for tab 2 and 3
-    tab2.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    tab3.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    //prepares each tab's analysis and the shared feature extraction
+    analysers.prepare(sampleRate, samplesPerBlockExpected);
+}
+
+//marks the analysis of the tab in front as active
+void MainComponent::changeListenerCallback(juce::ChangeBroadcaster*)
+{
+    const int currentTab = tabs.getCurrentTabIndex();
+    for (int i = 0; i < analysers.getNumAnalysers(); ++i)
+        analysers.setActive(i, i == currentTab);
 }
 
-//this handles the audio buffer management depending on the selected tab
+//downmix, levels and FFT frame are computed once and shared by every running analysis
 void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
 {
+    //debug builds flag any heap allocation made from here on in the callback
+    AudioAllocationTracker::ScopedAudioCallback allocationGuard;
+
     if (bufferToFill.buffer == nullptr || bufferToFill.buffer->getNumChannels() == 0)
     {
         bufferToFill.clearActiveBufferRegion();
         return;
     }
 
-    //process audio depending on selected tab
-    switch (tabs.getCurrentTabIndex())
-    {
-        case 1:
-            tab2.processAudioBuffer(bufferToFill);
-            break;
-
-        case 2:
-            tab3.processAudioBuffer(bufferToFill);
-            break;
+    analysers.process(bufferToFill.buffer->getArrayOfReadPointers(), bufferToFill.buffer->getNumChannels(),
+                      bufferToFill.startSample, bufferToFill.numSamples);
 
-        default:
-            bufferToFill.clearActiveBufferRegion();  //clears the buffer
-            break;
-    }
+    //the analysis only listens
+    bufferToFill.clearActiveBufferRegion();
 }
 
-//calls release resources for tab 2 and 3
+//releases each tab's analysis
 void MainComponent::releaseResources()
 {
-    tab2.releaseResources();
-    tab3.releaseResources();
+    analysers.release();
+
+    //the audio path must stay allocation free, see AudioAllocationTracker
+    jassert(AudioAllocationTracker::getAllocationCount() == 0);
 }
 
 //handles app suspensions
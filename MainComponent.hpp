@@ -5,9 +5,12 @@
 #include "TabComponent2.hpp"
 #include "TabComponent3.hpp"
 #include "CustomLookAndFeel.hpp"
+#include "AnalyserRegistry.hpp"
+#include "MusicLibrary.hpp"
 
 //MainComponent declaration
-class MainComponent : public juce::AudioAppComponent
+class MainComponent : public juce::AudioAppComponent,
+                      private juce::ChangeListener
 {
 public:
     MainComponent();
@@ -24,12 +27,20 @@ public:
     
 
 private:
+    //chords and scales for the tabs, mapped before they are built
+    MusicLibrary library { MusicLibrary::getDefaultFile() };
+
     juce::TabbedComponent tabs;
     TabComponent1 tab1;
     TabComponent2 tab2;
     TabComponent3 tab3;
 
+    //each tab's analysis, indexed like the tabs
+    AnalyserRegistry analysers;
+
     CustomLookAndFeel customLookAndFeel;
 
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainComponent)
 };
@@ -0,0 +1,271 @@
+#include "McLeodPitchDetector.hpp"
+#include "DSPKernels.hpp"
+#include <cmath>
+
+const float windowPeriods = 3.0f;   //periods of the lowest note the window holds
+
+//sizes the window for the lowest note, blocks of any size pass through the circular buffer
+void McLeodPitchDetector::initialize(float newSampleRate, int bufferSize)
+{
+    juce::ignoreUnused(bufferSize);
+
+    if (newSampleRate <= 0.0f)
+        return;
+
+    sampleRate = newSampleRate;
+
+    const int windowSize = juce::nextPowerOfTwo(static_cast<int>(std::ceil(windowPeriods * sampleRate / minFrequency)));
+    const int maxLag = static_cast<int>(std::ceil(sampleRate / minFrequency)) + 2;
+
+    ringBuffer.assign(static_cast<size_t>(windowSize), 0.0f);
+    windowBuffer.assign(static_cast<size_t>(windowSize), 0.0f);
+    nsdf.assign(static_cast<size_t>(maxLag) + 2, 0.0f);
+    squaredPrefixSum.assign(static_cast<size_t>(windowSize) + 1, 0.0);
+
+    //linear correlation up to maxLag without wrapping around
+    const int fftSize = juce::nextPowerOfTwo(windowSize + maxLag);
+    int fftOrder = 0;
+    while ((1 << fftOrder) < fftSize)
+        ++fftOrder;
+
+    fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+    fftBuffer.assign(2 * static_cast<size_t>(fftSize), 0.0f);
+
+    writePosition = 0;
+    samplesUntilAnalysis = windowSize;   //the first window always has to fill completely
+}
+
+//as YINAudioComponent, a hop of 0 or of the window length or more analyses each window once
+void McLeodPitchDetector::setHopSize(int newHopSize)
+{
+    hopSize = juce::jmax(0, newHopSize);
+
+    const int windowSize = getWindowSize();
+    const bool streaming = hopSize > 0 && hopSize < windowSize;
+
+    if (streaming && samplesUntilAnalysis > hopSize && samplesUntilAnalysis < windowSize)
+        samplesUntilAnalysis = hopSize;
+}
+
+void McLeodPitchDetector::reset()
+{
+    std::fill(ringBuffer.begin(), ringBuffer.end(), 0.0f);
+    writePosition = 0;
+    samplesUntilAnalysis = getWindowSize();
+}
+
+//copies the block into the circular buffer, analysing the window whenever an analysis falls due
+PitchDetector::Result McLeodPitchDetector::analyseBlock(const float* samples, int numSamples)
+{
+    Result result;
+
+    if (samples == nullptr || numSamples <= 0 || ringBuffer.empty())
+        return result;
+
+    const int capacity = getWindowSize();
+    int samplesRead = 0;
+
+    while (samplesRead < numSamples)
+    {
+        const int samplesToCopy = std::min({ numSamples - samplesRead, samplesUntilAnalysis, capacity - writePosition });
+
+        std::copy(samples + samplesRead, samples + samplesRead + samplesToCopy, ringBuffer.begin() + writePosition);
+
+        samplesRead += samplesToCopy;
+        samplesUntilAnalysis -= samplesToCopy;
+        writePosition = (writePosition + samplesToCopy) % capacity;
+
+        if (samplesUntilAnalysis == 0)
+        {
+            //the oldest sample sits at the write position once the buffer is full
+            const int olderSamples = capacity - writePosition;
+            std::copy(ringBuffer.begin() + writePosition, ringBuffer.end(), windowBuffer.begin());
+            std::copy(ringBuffer.begin(), ringBuffer.begin() + writePosition, windowBuffer.begin() + olderSamples);
+
+            result = analyseWindowBuffer(capacity);
+            samplesUntilAnalysis = hopSize > 0 && hopSize < capacity ? hopSize : capacity;
+        }
+    }
+
+    return result;
+}
+
+PitchDetector::Result McLeodPitchDetector::analyseWindow(const float* samples, int numSamples)
+{
+    if (samples == nullptr || numSamples <= 0 || numSamples > getWindowSize())
+        return {};
+
+    std::copy(samples, samples + numSamples, windowBuffer.begin());
+    return analyseWindowBuffer(numSamples);
+}
+
+//n(tau) = 2 r(tau) / (sum x[j]^2 + sum x[j + tau]^2) over j < N - tau
+void McLeodPitchDetector::computeNormalisedSquareDifference(int numSamples, int maxLag)
+{
+    const int fftSize = fft->getSize();
+
+    squaredPrefixSum[0] = 0.0;
+    for (int j = 0; j < numSamples; ++j)
+        squaredPrefixSum[static_cast<size_t>(j) + 1] = squaredPrefixSum[static_cast<size_t>(j)] + static_cast<double>(windowBuffer[static_cast<size_t>(j)]) * windowBuffer[static_cast<size_t>(j)];
+
+    //autocorrelation as the inverse transform of the power spectrum of the zero padded window
+    std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+    std::copy(windowBuffer.begin(), windowBuffer.begin() + numSamples, fftBuffer.begin());
+
+    fft->performRealOnlyForwardTransform(fftBuffer.data());
+    for (int bin = 0; bin < fftSize; ++bin)
+    {
+        const float re = fftBuffer[static_cast<size_t>(2 * bin)];
+        const float im = fftBuffer[static_cast<size_t>(2 * bin + 1)];
+        fftBuffer[static_cast<size_t>(2 * bin)] = re * re + im * im;
+        fftBuffer[static_cast<size_t>(2 * bin + 1)] = 0.0f;
+    }
+    fft->performRealOnlyInverseTransform(fftBuffer.data());
+
+    const double totalEnergy = squaredPrefixSum[static_cast<size_t>(numSamples)];
+    for (int tau = 0; tau <= maxLag; ++tau)
+    {
+        const double energy = squaredPrefixSum[static_cast<size_t>(numSamples - tau)] + totalEnergy - squaredPrefixSum[static_cast<size_t>(tau)];
+        nsdf[static_cast<size_t>(tau)] = energy > 0.0 ? static_cast<float>(2.0 * fftBuffer[static_cast<size_t>(tau)] / energy) : 0.0f;
+    }
+}
+
+//key maxima are the highest points of each positive lobe after n(tau) first goes negative
+PitchDetector::Result McLeodPitchDetector::analyseWindowBuffer(int numSamples)
+{
+    Result result;
+
+    //the same input gate as YIN, quiet windows are not analysed
+    if (DSPKernels::sumOfMagnitudes(windowBuffer.data(), numSamples) / numSamples < inputMagnitudeThreshold)
+        return result;
+
+    const int minLag = juce::jmax(2, static_cast<int>(sampleRate / maxFrequency));
+    const int maxLag = juce::jmin(static_cast<int>(nsdf.size()) - 2, numSamples / 2);
+    computeNormalisedSquareDifference(numSamples, maxLag + 1);
+
+    std::array<int, 64> keyMaxima;
+    int numKeyMaxima = 0;
+    float highest = 0.0f;
+
+    int tau = 1;
+    while (tau < maxLag && nsdf[static_cast<size_t>(tau)] > 0.0f)
+        ++tau;
+
+    int lobeMaximum = -1;
+    for (; tau <= maxLag && numKeyMaxima < static_cast<int>(keyMaxima.size()); ++tau)
+    {
+        const float value = nsdf[static_cast<size_t>(tau)];
+
+        if (value > 0.0f)
+        {
+            if (tau >= minLag && (lobeMaximum < 0 || value > nsdf[static_cast<size_t>(lobeMaximum)]))
+                lobeMaximum = tau;
+        }
+        else if (lobeMaximum >= 0)
+        {
+            keyMaxima[static_cast<size_t>(numKeyMaxima++)] = lobeMaximum;
+            highest = juce::jmax(highest, nsdf[static_cast<size_t>(lobeMaximum)]);
+            lobeMaximum = -1;
+        }
+    }
+
+    //a lobe still rising at the end of the range only counts once it has turned
+    if (lobeMaximum >= 0 && lobeMaximum < maxLag && numKeyMaxima < static_cast<int>(keyMaxima.size()))
+    {
+        keyMaxima[static_cast<size_t>(numKeyMaxima++)] = lobeMaximum;
+        highest = juce::jmax(highest, nsdf[static_cast<size_t>(lobeMaximum)]);
+    }
+
+    for (int i = 0; i < numKeyMaxima; ++i)
+    {
+        const int peak = keyMaxima[static_cast<size_t>(i)];
+        if (nsdf[static_cast<size_t>(peak)] < keyMaximumThreshold * highest)
+            continue;
+
+        //parabolic interpolation of the lag and of the clarity at the peak
+        const float s0 = nsdf[static_cast<size_t>(peak - 1)];
+        const float s1 = nsdf[static_cast<size_t>(peak)];
+        const float s2 = nsdf[static_cast<size_t>(peak + 1)];
+        const float denominator = s0 - 2.0f * s1 + s2;
+        const float shift = std::abs(denominator) > 1e-6f ? juce::jlimit(-0.5f, 0.5f, 0.5f * (s0 - s2) / denominator) : 0.0f;
+        const float clarity = juce::jmin(1.0f, s1 - 0.25f * (s0 - s2) * shift);
+
+        if (clarity < clarityThreshold)
+            break;
+
+        result.frequency = sampleRate / (static_cast<float>(peak) + shift);
+        result.confidence = clarity;
+        break;
+    }
+
+    return result;
+}
+
+#if JUCE_UNIT_TESTS
+
+#include "NoteMapping.hpp"
+#include "SyntheticGuitarSignal.hpp"
+
+class McLeodPitchDetectorTests : public juce::UnitTest
+{
+public:
+    McLeodPitchDetectorTests() : juce::UnitTest("McLeod pitch detector", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        const float sampleRate = 48000.0f;
+
+        McLeodPitchDetector mpm;
+        mpm.initialize(sampleRate, 512);
+        const int windowSize = mpm.getWindowSize();
+
+        beginTest("The window holds a few periods of low E");
+        expectEquals(windowSize, 4096);
+
+        beginTest("Plucked notes across the neck");
+        for (int midiNote = 40; midiNote <= 84; midiNote += 4)
+        {
+            const float frequency = NoteMapping::getFrequencyForMidiNote(midiNote);
+            auto signal = SyntheticGuitarSignal::renderNote(sampleRate, frequency, 0.6f, windowSize);
+            const auto result = mpm.analyseWindow(signal.data(), windowSize);
+
+            expectGreaterThan(result.frequency, 0.0f);
+            expectWithinAbsoluteError(1200.0f * std::log2(result.frequency / frequency), 0.0f, 5.0f);
+            expectGreaterThan(result.confidence, 0.9f);
+        }
+
+        beginTest("Silence and noise have no pitch");
+        {
+            std::vector<float> silence(static_cast<size_t>(windowSize), 0.0f);
+            expectLessThan(mpm.analyseWindow(silence.data(), windowSize).frequency, 0.0f);
+
+            juce::Random random(3);
+            std::vector<float> noise(static_cast<size_t>(windowSize));
+            for (auto& sample : noise)
+                sample = random.nextFloat() - 0.5f;
+            expectLessThan(mpm.analyseWindow(noise.data(), windowSize).frequency, 0.0f);
+        }
+
+        beginTest("Streaming analyses every hop once the window has filled");
+        {
+            McLeodPitchDetector streaming;
+            streaming.initialize(sampleRate, 512);
+            streaming.setHopSize(512);
+
+            auto signal = SyntheticGuitarSignal::renderNote(sampleRate, 110.0f, 0.6f, windowSize + 8 * 512);
+            int numResults = 0;
+            for (int offset = 0; offset < static_cast<int>(signal.size()); offset += 512)
+            {
+                expectEquals(streaming.getSamplesUntilNextAnalysis(), offset < windowSize ? windowSize - offset : 512);
+                if (streaming.analyseBlock(signal.data() + offset, 512).frequency > 0.0f)
+                    ++numResults;
+            }
+
+            expectEquals(numResults, 9);
+        }
+    }
+};
+
+static McLeodPitchDetectorTests mcLeodPitchDetectorTests;
+
+#endif
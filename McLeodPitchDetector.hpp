@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+#include "PitchDetector.hpp"
+
+//McLeod pitch method (MPM)
+//the normalised square difference n(tau) = 2 r(tau) / m(tau) of the window, with r the
+//autocorrelation from an FFT and m the energy of the overlapping segments from prefix sums, then
+//the first key maximum above a fraction of the highest, refined by parabolic interpolation
+//n(tau) needs only two periods in the window, so a shorter window than YIN's reaches low E
+class McLeodPitchDetector : public PitchDetector
+{
+public:
+    static constexpr float minFrequency = 70.0f;       //a little under drop D
+    static constexpr float maxFrequency = 1500.0f;
+    static constexpr float keyMaximumThreshold = 0.9f; //of the highest key maximum, as in the paper
+    static constexpr float clarityThreshold = 0.6f;    //below this the window is taken as unpitched
+
+    McLeodPitchDetector() = default;
+
+    void initialize(float sampleRate, int bufferSize) override;
+    void setHopSize(int newHopSize) override;
+    void reset() override;
+    int getSamplesUntilNextAnalysis() const override { return samplesUntilAnalysis; }
+    Result analyseBlock(const float* samples, int numSamples) override;
+
+    int getWindowSize() const override { return static_cast<int>(ringBuffer.size()); }
+
+    //analyses a contiguous window of getWindowSize() samples or fewer
+    Result analyseWindow(const float* samples, int numSamples);
+
+private:
+    Result analyseWindowBuffer(int numSamples);
+    void computeNormalisedSquareDifference(int numSamples, int maxLag);
+
+    float sampleRate = 48000.0f;
+    int hopSize = 0;
+    float inputMagnitudeThreshold = 0.05f;
+
+    //circular buffer holding the current window, as YINAudioComponent
+    std::vector<float> ringBuffer;
+    int writePosition = 0;
+    int samplesUntilAnalysis = 0;
+
+    std::vector<float> windowBuffer;   //the circular buffer in time order
+    std::vector<float> nsdf;
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> fftBuffer;
+    std::vector<double> squaredPrefixSum;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(McLeodPitchDetector)
+};
@@ -0,0 +1,583 @@
+#include "MusicLibrary.hpp"
+#include "ChordVerifier.hpp"
+#include "PitchModel.hpp"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+const juce::uint32 libraryMagic = 0x42494c47;   //"GLIB"
+const juce::uint16 libraryVersion = 2;
+const char* const libraryFileName = "GuitarLibrary.bin";
+
+struct MusicLibrary::FileHeader
+{
+    juce::uint32 magic;
+    juce::uint16 version;
+    juce::uint16 headerSize;
+    juce::uint32 numChords;
+    juce::uint32 chordsOffset;
+    juce::uint32 chordNotesOffset;
+    juce::uint32 numScales;
+    juce::uint32 scalesOffset;
+    juce::uint32 numScaleNotes;
+    juce::uint32 scaleNotesOffset;
+    juce::uint32 namesOffset;
+    juce::uint32 namesSize;
+    juce::uint32 chordDisplayOffset;
+    juce::uint32 scaleDisplayOffset;
+    juce::uint32 totalSize;
+};
+
+struct MusicLibrary::ChordRecord
+{
+    juce::uint8 root;
+    juce::uint8 quality;
+    juce::int8 frets[numStrings];
+    juce::uint16 pitchClasses;
+    juce::uint16 reserved;
+    juce::uint32 nameOffset;
+};
+
+struct MusicLibrary::ChordNotesEntry
+{
+    juce::uint16 pitchClasses;
+    juce::uint16 reserved;
+    juce::uint32 chordIndex;
+};
+
+struct MusicLibrary::ScaleRecord
+{
+    juce::uint8 root;
+    juce::uint8 type;
+    juce::uint16 numNotes;
+    juce::uint32 firstNote;
+    juce::uint32 nameOffset;
+};
+
+struct MusicLibrary::ScaleNoteRecord
+{
+    juce::uint8 midiNote;
+    juce::uint8 stringNumber;
+    juce::uint8 fret;
+    juce::uint8 reserved;
+};
+
+namespace
+{
+    //sort keys of the chord and scale records
+    int chordKey(int root, int quality) { return root * 256 + quality; }
+    int scaleKey(int root, int type) { return root * 256 + type; }
+
+    juce::uint32 alignedSize(size_t size) { return static_cast<juce::uint32>((size + 3) & ~static_cast<size_t>(3)); }
+
+    //run of records whose key matches, by binary search of records sorted by key
+    template <typename Record, typename KeyFunction>
+    MusicLibrary::IndexRange findRun(const Record* records, int numRecords, int key, KeyFunction keyOf)
+    {
+        if (records == nullptr || numRecords <= 0)
+            return {};
+
+        const auto* end = records + numRecords;
+        const auto* first = std::lower_bound(records, end, key, [&keyOf](const Record& record, int value) { return keyOf(record) < value; });
+        const auto* last = std::upper_bound(first, end, key, [&keyOf](int value, const Record& record) { return value < keyOf(record); });
+        return { static_cast<int>(first - records), static_cast<int>(last - records) };
+    }
+
+    //a section of count records starting at offset lies inside the file and is aligned for them
+    bool isSectionValid(juce::uint32 offset, juce::uint32 count, size_t recordSize, size_t fileSize)
+    {
+        return offset % 4 == 0 && offset <= fileSize && count <= (fileSize - offset) / recordSize;
+    }
+}
+
+//Builder
+void MusicLibrary::Builder::addChord(const juce::String& name, int root, ChordQuality quality, const std::array<int, numStrings>& frets)
+{
+    chords.push_back({ name, root, quality, frets });
+}
+
+void MusicLibrary::Builder::addScale(const juce::String& name, int root, ScaleType type, const std::vector<ScaleNote>& notes)
+{
+    scales.push_back({ name, root, type, notes });
+}
+
+//lays the sections out one after another and fills in the records in sorted order
+juce::MemoryBlock MusicLibrary::Builder::build() const
+{
+    std::vector<size_t> chordOrder(chords.size()), scaleOrder(scales.size());
+    std::iota(chordOrder.begin(), chordOrder.end(), static_cast<size_t>(0));
+    std::iota(scaleOrder.begin(), scaleOrder.end(), static_cast<size_t>(0));
+
+    std::stable_sort(chordOrder.begin(), chordOrder.end(), [this](size_t a, size_t b)
+    {
+        return chordKey(chords[a].root, static_cast<int>(chords[a].quality)) < chordKey(chords[b].root, static_cast<int>(chords[b].quality));
+    });
+    std::stable_sort(scaleOrder.begin(), scaleOrder.end(), [this](size_t a, size_t b)
+    {
+        return scaleKey(scales[a].root, static_cast<int>(scales[a].type)) < scaleKey(scales[b].root, static_cast<int>(scales[b].type));
+    });
+
+    size_t numScaleNotes = 0;
+    for (const auto& scale : scales)
+        numScaleNotes += scale.notes.size();
+
+    //names in the order added, the records point back at them
+    std::string nameTable;
+    std::vector<juce::uint32> chordNameOffsets, scaleNameOffsets;
+    for (const auto& chord : chords)
+    {
+        chordNameOffsets.push_back(static_cast<juce::uint32>(nameTable.size()));
+        nameTable += chord.name.toStdString();
+        nameTable.push_back('\0');
+    }
+    for (const auto& scale : scales)
+    {
+        scaleNameOffsets.push_back(static_cast<juce::uint32>(nameTable.size()));
+        nameTable += scale.name.toStdString();
+        nameTable.push_back('\0');
+    }
+    if (nameTable.empty())
+        nameTable.push_back('\0');
+
+    FileHeader header {};
+    header.magic = libraryMagic;
+    header.version = libraryVersion;
+    header.headerSize = static_cast<juce::uint16>(sizeof(FileHeader));
+    header.numChords = static_cast<juce::uint32>(chords.size());
+    header.chordsOffset = alignedSize(sizeof(FileHeader));
+    header.chordNotesOffset = header.chordsOffset + alignedSize(chords.size() * sizeof(ChordRecord));
+    header.numScales = static_cast<juce::uint32>(scales.size());
+    header.scalesOffset = header.chordNotesOffset + alignedSize(chords.size() * sizeof(ChordNotesEntry));
+    header.numScaleNotes = static_cast<juce::uint32>(numScaleNotes);
+    header.scaleNotesOffset = header.scalesOffset + alignedSize(scales.size() * sizeof(ScaleRecord));
+    header.namesOffset = header.scaleNotesOffset + alignedSize(numScaleNotes * sizeof(ScaleNoteRecord));
+    header.namesSize = static_cast<juce::uint32>(nameTable.size());
+    header.chordDisplayOffset = header.namesOffset + alignedSize(nameTable.size());
+    header.scaleDisplayOffset = header.chordDisplayOffset + alignedSize(chords.size() * sizeof(juce::uint32));
+    header.totalSize = header.scaleDisplayOffset + alignedSize(scales.size() * sizeof(juce::uint32));
+
+    juce::MemoryBlock block(header.totalSize, true);
+    auto* data = static_cast<char*>(block.getData());
+    std::memcpy(data, &header, sizeof(FileHeader));
+    std::memcpy(data + header.namesOffset, nameTable.data(), nameTable.size());
+
+    //record index of each chord and scale in the order they were added
+    std::vector<juce::uint32> chordDisplay(chords.size()), scaleDisplay(scales.size());
+    for (size_t i = 0; i < chordOrder.size(); ++i)
+        chordDisplay[chordOrder[i]] = static_cast<juce::uint32>(i);
+    for (size_t i = 0; i < scaleOrder.size(); ++i)
+        scaleDisplay[scaleOrder[i]] = static_cast<juce::uint32>(i);
+    if (!chordDisplay.empty())
+        std::memcpy(data + header.chordDisplayOffset, chordDisplay.data(), chordDisplay.size() * sizeof(juce::uint32));
+    if (!scaleDisplay.empty())
+        std::memcpy(data + header.scaleDisplayOffset, scaleDisplay.data(), scaleDisplay.size() * sizeof(juce::uint32));
+
+    std::vector<ChordNotesEntry> notesIndex;
+    for (size_t i = 0; i < chordOrder.size(); ++i)
+    {
+        const auto& chord = chords[chordOrder[i]];
+
+        ChordRecord record {};
+        record.root = static_cast<juce::uint8>(PitchModel::pitchClassOf(chord.root));
+        record.quality = static_cast<juce::uint8>(chord.quality);
+
+        PitchModel::NoteSet notes;
+        for (int string = 0; string < numStrings; ++string)
+        {
+            const int fret = chord.frets[static_cast<size_t>(string)];
+            record.frets[string] = static_cast<juce::int8>(fret < 0 ? mutedFret : juce::jmin(fret, 127));
+            if (fret >= 0)
+                notes.add(ChordVerifier::getOpenStringMidiNote(string) + fret);
+        }
+
+        record.pitchClasses = notes.getPitchClasses();
+        record.nameOffset = chordNameOffsets[chordOrder[i]];
+        std::memcpy(data + header.chordsOffset + i * sizeof(ChordRecord), &record, sizeof(ChordRecord));
+
+        notesIndex.push_back({ record.pitchClasses, 0, static_cast<juce::uint32>(i) });
+    }
+
+    std::stable_sort(notesIndex.begin(), notesIndex.end(), [](const ChordNotesEntry& a, const ChordNotesEntry& b)
+    {
+        return a.pitchClasses < b.pitchClasses;
+    });
+    if (!notesIndex.empty())
+        std::memcpy(data + header.chordNotesOffset, notesIndex.data(), notesIndex.size() * sizeof(ChordNotesEntry));
+
+    juce::uint32 firstNote = 0;
+    for (size_t i = 0; i < scaleOrder.size(); ++i)
+    {
+        const auto& scale = scales[scaleOrder[i]];
+
+        ScaleRecord record {};
+        record.root = static_cast<juce::uint8>(PitchModel::pitchClassOf(scale.root));
+        record.type = static_cast<juce::uint8>(scale.type);
+        record.numNotes = static_cast<juce::uint16>(scale.notes.size());
+        record.firstNote = firstNote;
+        record.nameOffset = scaleNameOffsets[scaleOrder[i]];
+        std::memcpy(data + header.scalesOffset + i * sizeof(ScaleRecord), &record, sizeof(ScaleRecord));
+
+        for (const auto& note : scale.notes)
+        {
+            ScaleNoteRecord noteRecord {};
+            noteRecord.midiNote = static_cast<juce::uint8>(juce::jlimit(0, 127, note.midiNote));
+            noteRecord.stringNumber = static_cast<juce::uint8>(juce::jlimit(1, numStrings, note.stringNumber));
+            noteRecord.fret = static_cast<juce::uint8>(juce::jlimit(0, 255, note.fret));
+            std::memcpy(data + header.scaleNotesOffset + firstNote * sizeof(ScaleNoteRecord), &noteRecord, sizeof(ScaleNoteRecord));
+            ++firstNote;
+        }
+    }
+
+    return block;
+}
+
+bool MusicLibrary::Builder::writeTo(const juce::File& file) const
+{
+    const auto block = build();
+    return file.replaceWithData(block.getData(), block.getSize());
+}
+
+//MusicLibrary
+MusicLibrary::MusicLibrary(const juce::File& file)
+{
+    mappedFile = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+
+    if (mappedFile->getData() == nullptr || !openFromMemory(mappedFile->getData(), mappedFile->getSize()))
+        mappedFile.reset();
+}
+
+//checks the header describes sections that fit the data, the records themselves are not read
+bool MusicLibrary::openFromMemory(const void* data, size_t size)
+{
+    //the records are read straight from the data, their layout is the file format
+    static_assert(sizeof(FileHeader) == 56, "file header layout");
+    static_assert(sizeof(ChordRecord) == 16, "chord record layout");
+    static_assert(sizeof(ChordNotesEntry) == 8, "chord index layout");
+    static_assert(sizeof(ScaleRecord) == 12, "scale record layout");
+    static_assert(sizeof(ScaleNoteRecord) == 4, "scale note layout");
+
+    header = nullptr;
+
+    if (data == nullptr || size < sizeof(FileHeader) || reinterpret_cast<juce::pointer_sized_uint>(data) % 4 != 0)
+        return false;
+
+    const auto* bytes = static_cast<const char*>(data);
+    const auto* newHeader = reinterpret_cast<const FileHeader*>(bytes);
+
+    if (newHeader->magic != libraryMagic || newHeader->version != libraryVersion
+        || newHeader->headerSize != sizeof(FileHeader) || newHeader->totalSize > size)
+        return false;
+
+    if (!isSectionValid(newHeader->chordsOffset, newHeader->numChords, sizeof(ChordRecord), size)
+        || !isSectionValid(newHeader->chordNotesOffset, newHeader->numChords, sizeof(ChordNotesEntry), size)
+        || !isSectionValid(newHeader->scalesOffset, newHeader->numScales, sizeof(ScaleRecord), size)
+        || !isSectionValid(newHeader->scaleNotesOffset, newHeader->numScaleNotes, sizeof(ScaleNoteRecord), size)
+        || !isSectionValid(newHeader->namesOffset, newHeader->namesSize, 1, size)
+        || !isSectionValid(newHeader->chordDisplayOffset, newHeader->numChords, sizeof(juce::uint32), size)
+        || !isSectionValid(newHeader->scaleDisplayOffset, newHeader->numScales, sizeof(juce::uint32), size)
+        || newHeader->namesSize == 0 || bytes[newHeader->namesOffset + newHeader->namesSize - 1] != '\0')
+        return false;
+
+    header = newHeader;
+    chordRecords = reinterpret_cast<const ChordRecord*>(bytes + header->chordsOffset);
+    chordNotesIndex = reinterpret_cast<const ChordNotesEntry*>(bytes + header->chordNotesOffset);
+    scaleRecords = reinterpret_cast<const ScaleRecord*>(bytes + header->scalesOffset);
+    scaleNoteRecords = reinterpret_cast<const ScaleNoteRecord*>(bytes + header->scaleNotesOffset);
+    names = bytes + header->namesOffset;
+    chordDisplayOrder = reinterpret_cast<const juce::uint32*>(bytes + header->chordDisplayOffset);
+    scaleDisplayOrder = reinterpret_cast<const juce::uint32*>(bytes + header->scaleDisplayOffset);
+    return true;
+}
+
+const char* MusicLibrary::getName(juce::uint32 offset) const
+{
+    return offset < header->namesSize ? names + offset : "";
+}
+
+int MusicLibrary::getNumChords() const
+{
+    return isOpen() ? static_cast<int>(header->numChords) : 0;
+}
+
+MusicLibrary::Chord MusicLibrary::getChord(int index) const
+{
+    Chord chord;
+    if (index < 0 || index >= getNumChords())
+        return chord;
+
+    const auto& record = chordRecords[index];
+    chord.root = record.root;
+    chord.quality = static_cast<ChordQuality>(record.quality);
+    for (int string = 0; string < numStrings; ++string)
+        chord.frets[static_cast<size_t>(string)] = record.frets[string];
+    chord.pitchClasses = record.pitchClasses;
+    chord.name = getName(record.nameOffset);
+    return chord;
+}
+
+//records are sorted by root then quality, so the matches are one run
+MusicLibrary::IndexRange MusicLibrary::findChords(int root, ChordQuality quality) const
+{
+    return findRun(chordRecords, getNumChords(), chordKey(root, static_cast<int>(quality)),
+                   [](const ChordRecord& record) { return chordKey(record.root, record.quality); });
+}
+
+MusicLibrary::IndexRange MusicLibrary::findChordsWithPitchClasses(juce::uint16 pitchClasses) const
+{
+    return findRun(chordNotesIndex, getNumChords(), pitchClasses,
+                   [](const ChordNotesEntry& entry) { return static_cast<int>(entry.pitchClasses); });
+}
+
+int MusicLibrary::getChordInPitchClassOrder(int position) const
+{
+    return position >= 0 && position < getNumChords() ? static_cast<int>(chordNotesIndex[position].chordIndex) : -1;
+}
+
+//an out of range entry in a damaged file gives -1 rather than a record past the end
+int MusicLibrary::getChordInDisplayOrder(int position) const
+{
+    if (position < 0 || position >= getNumChords())
+        return -1;
+
+    const auto index = chordDisplayOrder[position];
+    return index < header->numChords ? static_cast<int>(index) : -1;
+}
+
+int MusicLibrary::getNumScales() const
+{
+    return isOpen() ? static_cast<int>(header->numScales) : 0;
+}
+
+//a scale whose notes run past the note section is cut short rather than read out of bounds
+MusicLibrary::Scale MusicLibrary::getScale(int index) const
+{
+    Scale scale;
+    if (index < 0 || index >= getNumScales())
+        return scale;
+
+    const auto& record = scaleRecords[index];
+    scale.root = record.root;
+    scale.type = static_cast<ScaleType>(record.type);
+    scale.name = getName(record.nameOffset);
+    scale.firstNote = static_cast<int>(juce::jmin(record.firstNote, header->numScaleNotes));
+    scale.numNotes = juce::jmin(static_cast<int>(record.numNotes), static_cast<int>(header->numScaleNotes) - scale.firstNote);
+    return scale;
+}
+
+MusicLibrary::ScaleNote MusicLibrary::getScaleNote(const Scale& scale, int noteIndex) const
+{
+    ScaleNote note;
+    if (!isOpen() || noteIndex < 0 || noteIndex >= scale.numNotes
+        || scale.firstNote + noteIndex >= static_cast<int>(header->numScaleNotes))
+        return note;
+
+    const auto& record = scaleNoteRecords[scale.firstNote + noteIndex];
+    note.midiNote = record.midiNote;
+    note.stringNumber = record.stringNumber;
+    note.fret = record.fret;
+    return note;
+}
+
+int MusicLibrary::getScaleInDisplayOrder(int position) const
+{
+    if (position < 0 || position >= getNumScales())
+        return -1;
+
+    const auto index = scaleDisplayOrder[position];
+    return index < header->numScales ? static_cast<int>(index) : -1;
+}
+
+MusicLibrary::IndexRange MusicLibrary::findScales(int root, ScaleType type) const
+{
+    return findRun(scaleRecords, getNumScales(), scaleKey(root, static_cast<int>(type)),
+                   [](const ScaleRecord& record) { return scaleKey(record.root, record.type); });
+}
+
+//the chords and scales the Chords and Scales tabs started with
+//frets run from the high e string to the low E, scale notes are given with their fingering
+MusicLibrary::Builder MusicLibrary::getBuiltInDefinitions()
+{
+    Builder builder;
+
+    builder.addChord("C Major", 0, ChordQuality::major, { 0, 1, 0, 2, 3, mutedFret });
+    builder.addChord("G Major", 7, ChordQuality::major, { 3, 0, 0, 0, 2, 3 });
+    builder.addChord("D Major", 2, ChordQuality::major, { 2, 3, 2, 0, mutedFret, mutedFret });
+    builder.addChord("A Major", 9, ChordQuality::major, { 0, 2, 2, 2, 0, mutedFret });
+    builder.addChord("E Major", 4, ChordQuality::major, { 0, 0, 1, 2, 2, 0 });
+    builder.addChord("A Minor", 9, ChordQuality::minor, { 0, 1, 2, 2, 0, mutedFret });
+    builder.addChord("E Minor", 4, ChordQuality::minor, { 0, 0, 0, 2, 2, 0 });
+
+    //{ MIDI note, string number, fret }
+    builder.addScale("C Major", 0, ScaleType::major,
+                     { { 48, 5, 3 }, { 50, 4, 0 }, { 52, 4, 2 }, { 53, 4, 3 }, { 55, 3, 0 }, { 57, 3, 2 }, { 59, 2, 0 } });
+    builder.addScale("A Minor", 9, ScaleType::naturalMinor,
+                     { { 45, 5, 0 }, { 47, 5, 2 }, { 48, 5, 3 }, { 50, 4, 0 }, { 52, 4, 2 }, { 53, 4, 3 }, { 55, 3, 0 } });
+    builder.addScale("C Major Pentatonic", 0, ScaleType::majorPentatonic,
+                     { { 48, 5, 3 }, { 50, 4, 0 }, { 52, 4, 2 }, { 55, 3, 0 }, { 57, 3, 2 } });
+    builder.addScale("A Minor Pentatonic", 9, ScaleType::minorPentatonic,
+                     { { 45, 5, 0 }, { 48, 5, 3 }, { 50, 4, 0 }, { 52, 4, 2 }, { 55, 3, 0 } });
+    builder.addScale("E Blues", 4, ScaleType::blues,
+                     { { 40, 6, 0 }, { 43, 6, 3 }, { 45, 5, 0 }, { 46, 5, 1 }, { 47, 5, 2 }, { 50, 4, 0 } });
+
+    return builder;
+}
+
+juce::File MusicLibrary::getDefaultFile()
+{
+    const auto bundled = juce::File::getSpecialLocation(juce::File::currentApplicationFile).getChildFile(libraryFileName);
+    if (bundled.existsAsFile())
+        return bundled;
+
+    //written once, and again if a later version of the app changes the format
+    const auto written = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                             .getChildFile("GuitarLearningApp")
+                             .getChildFile(libraryFileName);
+
+    if (!MusicLibrary(written).isOpen())
+    {
+        written.getParentDirectory().createDirectory();
+        getBuiltInDefinitions().writeTo(written);
+    }
+
+    return written;
+}
+
+#if JUCE_UNIT_TESTS
+
+class MusicLibraryTests : public juce::UnitTest
+{
+public:
+    MusicLibraryTests() : juce::UnitTest("Music library", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        beginTest("Built-in chords and scales read back from the binary format");
+        {
+            const auto block = MusicLibrary::getBuiltInDefinitions().build();
+            MusicLibrary library;
+            expect(library.openFromMemory(block.getData(), block.getSize()));
+            expectEquals(library.getNumChords(), 7);
+            expectEquals(library.getNumScales(), 5);
+
+            const auto cMajor = library.findChords(0, MusicLibrary::ChordQuality::major);
+            expectEquals(cMajor.size(), 1);
+
+            const auto chord = library.getChord(cMajor.begin);
+            expectEquals(juce::String(chord.name), juce::String("C Major"));
+            expectEquals(static_cast<int>(chord.pitchClasses), (1 << 0) | (1 << 4) | (1 << 7));
+            expectEquals(chord.frets[5], static_cast<int>(MusicLibrary::mutedFret));
+            expectEquals(chord.frets[4], 3);
+
+            const auto eChords = library.findChords(4, MusicLibrary::ChordQuality::minor);
+            expectEquals(eChords.size(), 1);
+            expectEquals(juce::String(library.getChord(eChords.begin).name), juce::String("E Minor"));
+            expect(library.findChords(1, MusicLibrary::ChordQuality::major).isEmpty());
+
+            //A minor sounds A C E, as does nothing else in the set
+            const auto byNotes = library.findChordsWithPitchClasses((1 << 9) | (1 << 0) | (1 << 4));
+            expectEquals(byNotes.size(), 1);
+            expectEquals(juce::String(library.getChord(library.getChordInPitchClassOrder(byNotes.begin)).name), juce::String("A Minor"));
+
+            const auto blues = library.findScales(4, MusicLibrary::ScaleType::blues);
+            expectEquals(blues.size(), 1);
+            const auto scale = library.getScale(blues.begin);
+            expectEquals(juce::String(scale.name), juce::String("E Blues"));
+            expectEquals(scale.numNotes, 6);
+            expectEquals(library.getScaleNote(scale, 3).midiNote, 46);
+            expectEquals(library.getScaleNote(scale, 3).stringNumber, 5);
+            expectEquals(library.getScaleNote(scale, 3).fret, 1);
+        }
+
+        beginTest("Menus list the chords and scales in the order they were added");
+        {
+            const auto block = MusicLibrary::getBuiltInDefinitions().build();
+            MusicLibrary library;
+            expect(library.openFromMemory(block.getData(), block.getSize()));
+
+            const char* chordNames[] = { "C Major", "G Major", "D Major", "A Major", "E Major", "A Minor", "E Minor" };
+            for (int position = 0; position < 7; ++position)
+                expectEquals(juce::String(library.getChord(library.getChordInDisplayOrder(position)).name), juce::String(chordNames[position]));
+
+            const char* scaleNames[] = { "C Major", "A Minor", "C Major Pentatonic", "A Minor Pentatonic", "E Blues" };
+            for (int position = 0; position < 5; ++position)
+                expectEquals(juce::String(library.getScale(library.getScaleInDisplayOrder(position)).name), juce::String(scaleNames[position]));
+
+            expectEquals(library.getChordInDisplayOrder(7), -1);
+            expectEquals(library.getScaleInDisplayOrder(-1), -1);
+        }
+
+        beginTest("Lookups in a large library");
+        {
+            MusicLibrary::Builder builder;
+            juce::Random random(7);
+            const int numChords = 5000;
+            int expectedGMinor = 0;
+
+            for (int i = 0; i < numChords; ++i)
+            {
+                const int root = random.nextInt(12);
+                const auto quality = static_cast<MusicLibrary::ChordQuality>(random.nextInt(10));
+                if (root == 7 && quality == MusicLibrary::ChordQuality::minor)
+                    ++expectedGMinor;
+
+                std::array<int, MusicLibrary::numStrings> frets;
+                for (auto& fret : frets)
+                    fret = random.nextInt(13) - 1;
+
+                builder.addChord("Chord " + juce::String(i), root, quality, frets);
+            }
+
+            const auto block = builder.build();
+            MusicLibrary library;
+            expect(library.openFromMemory(block.getData(), block.getSize()));
+            expectEquals(library.getNumChords(), numChords);
+
+            const auto gMinor = library.findChords(7, MusicLibrary::ChordQuality::minor);
+            expectEquals(gMinor.size(), expectedGMinor);
+            for (int i = gMinor.begin; i < gMinor.end; ++i)
+                expect(library.getChord(i).root == 7 && library.getChord(i).quality == MusicLibrary::ChordQuality::minor);
+
+            //every chord is found again through the pitch class index
+            int found = 0;
+            for (int i = 0; i < numChords; i += 97)
+            {
+                const auto range = library.findChordsWithPitchClasses(library.getChord(i).pitchClasses);
+                for (int position = range.begin; position < range.end; ++position)
+                    found += library.getChordInPitchClassOrder(position) == i ? 1 : 0;
+            }
+            expectEquals(found, (numChords + 96) / 97);
+        }
+
+        beginTest("Malformed data is rejected");
+        {
+            auto block = MusicLibrary::getBuiltInDefinitions().build();
+            MusicLibrary library;
+
+            expect(!library.openFromMemory(block.getData(), block.getSize() - 8));
+            expect(!library.isOpen());
+            expectEquals(library.getNumChords(), 0);
+            expect(library.findChords(0, MusicLibrary::ChordQuality::major).isEmpty());
+
+            static_cast<char*>(block.getData())[0] = 'X';
+            expect(!library.openFromMemory(block.getData(), block.getSize()));
+        }
+
+        beginTest("Memory mapped file");
+        {
+            const auto file = juce::File::createTempFile(".bin");
+            expect(MusicLibrary::getBuiltInDefinitions().writeTo(file));
+
+            MusicLibrary library(file);
+            expect(library.isOpen());
+            expectEquals(library.getNumScales(), 5);
+            expectEquals(juce::String(library.getScale(0).name), juce::String("C Major"));
+
+            file.deleteFile();
+            expect(!MusicLibrary(file).isOpen());
+        }
+    }
+};
+
+static MusicLibraryTests musicLibraryTests;
+
+#endif
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <juce_core/juce_core.h>
+
+//chord voicings and scale positions for the Chords and Scales tabs
+//the library is a compact binary file that is memory mapped and read in place, opening it
+//only checks the header so startup costs the same for seven chords or seven thousand
+//chords are stored sorted by root and quality with a second index by pitch classes, scales by
+//root and type, so every lookup is a binary search over the mapped records
+//
+//layout, little endian, every section aligned to 4 bytes:
+//  FileHeader
+//  ChordRecord[numChords]          sorted by root, quality, then the order they were added
+//  ChordNotesEntry[numChords]      sorted by pitch classes, then chord index
+//  ScaleRecord[numScales]          sorted by root, type, then the order they were added
+//  ScaleNoteRecord[numScaleNotes]  each scale's notes in playing order
+//  names, zero terminated UTF-8
+//  uint32[numChords]               chord indices in the order they were added, the menu order
+//  uint32[numScales]               scale indices in the order they were added
+class MusicLibrary
+{
+public:
+    enum class ChordQuality : juce::uint8
+    {
+        major, minor, dominant7, major7, minor7, sus2, sus4, diminished, augmented, power
+    };
+
+    enum class ScaleType : juce::uint8
+    {
+        major, naturalMinor, majorPentatonic, minorPentatonic, blues
+    };
+
+    static constexpr int numStrings = 6;   //index 0 is the high e string, as in ChordVerifier
+    static constexpr int mutedFret = -1;
+
+    struct Chord
+    {
+        int root = 0;                                //pitch class, 0 is C
+        ChordQuality quality = ChordQuality::major;
+        std::array<int, numStrings> frets {};        //0 open, mutedFret for strings not played
+        juce::uint16 pitchClasses = 0;               //bit per pitch class the voicing sounds
+        const char* name = "";                       //points into the library
+    };
+
+    struct Scale
+    {
+        int root = 0;
+        ScaleType type = ScaleType::major;
+        int numNotes = 0;
+        const char* name = "";
+
+        int firstNote = 0;   //index of the first note record, for getScaleNote
+    };
+
+    struct ScaleNote
+    {
+        int midiNote = 0;
+        int stringNumber = 1;   //1 is the high e string, 6 the low E
+        int fret = 0;
+    };
+
+    //records [begin, end) matching a lookup
+    struct IndexRange
+    {
+        int begin = 0;
+        int end = 0;
+
+        int size() const { return end - begin; }
+        bool isEmpty() const { return end <= begin; }
+    };
+
+    //writes the binary format, for the built-in library and tools that make larger ones
+    class Builder
+    {
+    public:
+        void addChord(const juce::String& name, int root, ChordQuality quality, const std::array<int, numStrings>& frets);
+        void addScale(const juce::String& name, int root, ScaleType type, const std::vector<ScaleNote>& notes);
+
+        juce::MemoryBlock build() const;
+        bool writeTo(const juce::File& file) const;
+
+    private:
+        struct PendingChord { juce::String name; int root; ChordQuality quality; std::array<int, numStrings> frets; };
+        struct PendingScale { juce::String name; int root; ScaleType type; std::vector<ScaleNote> notes; };
+
+        std::vector<PendingChord> chords;
+        std::vector<PendingScale> scales;
+    };
+
+    MusicLibrary() = default;
+
+    //maps the file, an unreadable or malformed file leaves the library empty
+    explicit MusicLibrary(const juce::File& file);
+
+    //reads a library already in memory, the memory must outlive this object
+    bool openFromMemory(const void* data, size_t size);
+    bool isOpen() const { return header != nullptr; }
+
+    int getNumChords() const;
+    Chord getChord(int index) const;
+
+    //chords of a root and quality, as chord indices
+    IndexRange findChords(int root, ChordQuality quality) const;
+
+    //chords sounding exactly these pitch classes, as positions in the pitch class index
+    //getChordInPitchClassOrder turns a position into a chord index
+    IndexRange findChordsWithPitchClasses(juce::uint16 pitchClasses) const;
+    int getChordInPitchClassOrder(int position) const;
+
+    //chord index at a position of the order the chords were added, the order menus list them in
+    int getChordInDisplayOrder(int position) const;
+
+    int getNumScales() const;
+    Scale getScale(int index) const;
+    ScaleNote getScaleNote(const Scale& scale, int noteIndex) const;
+    IndexRange findScales(int root, ScaleType type) const;
+    int getScaleInDisplayOrder(int position) const;
+
+    //the chords and scales the app has always shipped with
+    static Builder getBuiltInDefinitions();
+
+    //the library bundled with the app, or one written from the built-in definitions to the
+    //user's application data the first time the app runs without it
+    static juce::File getDefaultFile();
+
+private:
+    struct FileHeader;
+    struct ChordRecord;
+    struct ChordNotesEntry;
+    struct ScaleRecord;
+    struct ScaleNoteRecord;
+
+    const char* getName(juce::uint32 offset) const;
+
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+
+    const FileHeader* header = nullptr;
+    const ChordRecord* chordRecords = nullptr;
+    const ChordNotesEntry* chordNotesIndex = nullptr;
+    const ScaleRecord* scaleRecords = nullptr;
+    const ScaleNoteRecord* scaleNoteRecords = nullptr;
+    const char* names = nullptr;
+    const juce::uint32* chordDisplayOrder = nullptr;
+    const juce::uint32* scaleDisplayOrder = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MusicLibrary)
+};
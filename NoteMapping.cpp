@@ -0,0 +1,60 @@
+#include "NoteMapping.hpp"
+#include "PitchModel.hpp"
+#include <array>
+#include <cmath>
+
+namespace NoteMapping
+{
+    //a detected pitch further than this from the nearest note is not named
+    //a fixed window in cents is as strict on the high e string as on the low E
+    const float noteNameToleranceCents = 30.0f;
+
+    constexpr std::array<const char*, 12> noteNames = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+
+    //takes the detected pitch and matches it to the nearest note
+    //returns note plus the octave, or "Unknown" when the pitch is too far from any note to name
+    juce::String getNoteNameFromFrequencyWithTolerance(float frequency)
+    {
+        const int midiNote = getMidiNoteFromFrequencyWithTolerance(frequency);
+        return midiNote >= 0 ? getNoteNameForMidiNote(midiNote) : juce::String("Unknown");
+    }
+
+    //nearest note within the tolerance, -1 when there is none
+    int getMidiNoteFromFrequencyWithTolerance(float frequency)
+    {
+        const auto estimate = PitchModel::Tuning().estimate(frequency);
+        return estimate.isValid() && std::abs(estimate.cents) <= noteNameToleranceCents ? estimate.midiNote : -1;
+    }
+
+    //name and octave of a MIDI note, e.g. 40 -> "E2"
+    juce::String getNoteNameForMidiNote(int midiNote)
+    {
+        return juce::String(noteNames[static_cast<size_t>(PitchModel::pitchClassOf(midiNote))]) + juce::String(PitchModel::octaveOf(midiNote));
+    }
+
+    //inverse of getNoteNameForMidiNote, "A#2" -> 46, -1 for anything that is not a note name
+    int getMidiNoteForNoteName(const juce::String& noteName)
+    {
+        //longest match first so "C#" is not read as "C"
+        for (int length = 2; length >= 1; --length)
+        {
+            auto name = noteName.substring(0, length);
+            auto octave = noteName.substring(length);
+
+            if (octave.isEmpty() || !octave.containsOnly("-0123456789"))
+                continue;
+
+            for (size_t i = 0; i < noteNames.size(); ++i)
+                if (name == noteNames[i])
+                    return (octave.getIntValue() + 1) * 12 + static_cast<int>(i);
+        }
+
+        return -1;
+    }
+
+    //equal tempered frequency of a MIDI note for A4 = 440 Hz
+    float getFrequencyForMidiNote(int midiNote)
+    {
+        return PitchModel::Tuning().getFrequency(midiNote);
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//conversions between detected frequencies and note names
+//shared by the Scales tab and the pitch accuracy bench
+namespace NoteMapping
+{
+    //note name plus octave for a frequency within 30 cents of an equal tempered note, otherwise "Unknown"
+    juce::String getNoteNameFromFrequencyWithTolerance(float frequency);
+
+    //the same match as a MIDI note, -1 for "Unknown", nothing is allocated
+    int getMidiNoteFromFrequencyWithTolerance(float frequency);
+
+    juce::String getNoteNameForMidiNote(int midiNote);
+
+    //inverse of getNoteNameForMidiNote, "A#2" -> 46, -1 for anything that is not a note name
+    int getMidiNoteForNoteName(const juce::String& noteName);
+    float getFrequencyForMidiNote(int midiNote);
+}
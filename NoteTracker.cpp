@@ -0,0 +1,239 @@
+#include "NoteTracker.hpp"
+#include "PitchModel.hpp"
+#include <cmath>
+
+const float minimumConfidence = 0.5f;      //frames below this count as no pitch
+const float holdSemitones = 0.8f;          //distance from the sounding note a frame may stray and still belong to it
+const double minimumNoteSeconds = 0.02;    //a new note has to be heard this long before it is reported
+const double minimumGapSeconds = 0.05;     //no pitch for this long stops the sounding note
+const int minimumFrames = 2;               //and in at least this many frames, whatever the hop
+
+
+//sets the frame timing rules for the sample rate
+void NoteTracker::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 48000.0;
+    reset();
+}
+
+//forgets the sounding note without reporting it
+void NoteTracker::reset()
+{
+    currentNote = -1;
+    candidateNote = -1;
+    candidateFrames = 0;
+    candidateStart = 0;
+    candidateConfidenceSum = 0.0f;
+    unvoicedFrames = 0;
+    unvoicedStart = 0;
+}
+
+//a run of unvoiced frames already under way marks where the note really ended
+bool NoteTracker::stop(juce::int64 samplePosition, NoteEvent& event)
+{
+    const int note = currentNote;
+    const juce::int64 endPosition = unvoicedFrames > 0 ? juce::jmin(unvoicedStart, samplePosition) : samplePosition;
+    reset();
+
+    if (note < 0)
+        return false;
+
+    event = NoteEvent();
+    event.type = NoteEvent::Type::noteOff;
+    event.midiNote = note;
+    event.samplePosition = endPosition;
+    return true;
+}
+
+//frames without a confident pitch count towards a noteOff, the rest towards holding the sounding
+//note or confirming a new one
+bool NoteTracker::process(float frequency, float confidence, juce::int64 samplePosition, NoteEvent& event)
+{
+    const auto estimate = PitchModel::Tuning().estimate(frequency);
+
+    if (!estimate.isValid() || confidence < minimumConfidence)
+    {
+        candidateNote = -1;
+
+        if (currentNote < 0)
+            return false;
+
+        if (unvoicedFrames++ == 0)
+            unvoicedStart = samplePosition;
+
+        if (unvoicedFrames >= minimumFrames && samplePosition - unvoicedStart >= static_cast<juce::int64>(minimumGapSeconds * sampleRate))
+        {
+            event = NoteEvent();
+            event.type = NoteEvent::Type::noteOff;
+            event.midiNote = currentNote;
+            event.samplePosition = unvoicedStart;
+
+            currentNote = -1;
+            return true;
+        }
+
+        return false;
+    }
+
+    unvoicedFrames = 0;
+
+    //frames near the sounding note belong to it, a candidate for another note is dropped
+    if (currentNote >= 0 && std::abs(estimate.getExactNote() - static_cast<float>(currentNote)) <= holdSemitones)
+    {
+        candidateNote = -1;
+        return false;
+    }
+
+    const int note = estimate.midiNote;
+    if (note != candidateNote)
+    {
+        candidateNote = note;
+        candidateFrames = 0;
+        candidateStart = samplePosition;
+        candidateConfidenceSum = 0.0f;
+    }
+
+    ++candidateFrames;
+    candidateConfidenceSum += confidence;
+
+    if (candidateFrames >= minimumFrames && samplePosition - candidateStart >= static_cast<juce::int64>(minimumNoteSeconds * sampleRate))
+    {
+        event = NoteEvent();
+        event.type = currentNote >= 0 ? NoteEvent::Type::pitchChange : NoteEvent::Type::noteOn;
+        event.midiNote = note;
+        event.frequency = frequency;
+        event.cents = estimate.cents;
+        event.confidence = candidateConfidenceSum / static_cast<float>(candidateFrames);
+        event.samplePosition = candidateStart;
+
+        currentNote = note;
+        candidateNote = -1;
+        return true;
+    }
+
+    return false;
+}
+
+#if JUCE_UNIT_TESTS
+
+class NoteTrackerTests : public juce::UnitTest
+{
+public:
+    NoteTrackerTests() : juce::UnitTest("Note tracker", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        beginTest("A clean note gives one noteOn and one noteOff at its edges");
+        {
+            std::vector<float> frames(10, 0.0f);
+            frames.insert(frames.end(), 40, 110.0f);
+            frames.insert(frames.end(), 20, 0.0f);
+
+            auto events = track(frames);
+            expectEquals(static_cast<int>(events.size()), 2);
+
+            if (events.size() == 2)
+            {
+                expect(events[0].type == NoteEvent::Type::noteOn);
+                expectEquals(events[0].midiNote, 45);
+                expectEquals(static_cast<int>(events[0].samplePosition), 10 * hop);
+                expectWithinAbsoluteError(events[0].confidence, 0.9f, 1.0e-6f);
+
+                expect(events[1].type == NoteEvent::Type::noteOff);
+                expectEquals(events[1].midiNote, 45);
+                expectEquals(static_cast<int>(events[1].samplePosition), 50 * hop);
+            }
+        }
+
+        beginTest("A single stray octave frame is ignored");
+        {
+            std::vector<float> frames(30, 196.0f);
+            frames[15] = 392.0f;
+            frames[22] = 0.0f;
+
+            auto events = track(frames);
+            expectEquals(static_cast<int>(events.size()), 1);
+            expect(!events.empty() && events[0].type == NoteEvent::Type::noteOn && events[0].midiNote == 55);
+        }
+
+        beginTest("Vibrato within the hold range keeps the note");
+        {
+            std::vector<float> frames;
+            for (int i = 0; i < 100; ++i)
+                frames.push_back(220.0f * std::pow(2.0f, 0.6f * std::sin(0.3f * static_cast<float>(i)) / 12.0f));
+
+            auto events = track(frames);
+            expectEquals(static_cast<int>(events.size()), 1);
+            expect(!events.empty() && events[0].midiNote == 57);
+        }
+
+        beginTest("Legato moves give a pitchChange at the new note");
+        {
+            std::vector<float> frames(20, 220.0f);
+            frames.insert(frames.end(), 20, 246.94f);
+
+            auto events = track(frames);
+            expectEquals(static_cast<int>(events.size()), 2);
+
+            if (events.size() == 2)
+            {
+                expect(events[1].type == NoteEvent::Type::pitchChange);
+                expectEquals(events[1].midiNote, 59);
+                expectEquals(static_cast<int>(events[1].samplePosition), 20 * hop);
+            }
+        }
+
+        beginTest("Low confidence frames do not start a note");
+        {
+            std::vector<float> frames(30, 110.0f);
+            expect(track(frames, 0.3f).empty());
+        }
+
+        beginTest("Stopping the input ends the note at once and forgets the candidate");
+        {
+            NoteTracker tracker;
+            tracker.prepare(48000.0);
+            NoteEvent event;
+
+            for (int frame = 0; frame < 10; ++frame)
+                tracker.process(110.0f, 0.9f, frame * hop, event);
+
+            expectEquals(tracker.getCurrentNote(), 45);
+            tracker.process(220.0f, 0.9f, 10 * hop, event);
+
+            expect(tracker.stop(11 * hop, event));
+            expect(event.type == NoteEvent::Type::noteOff);
+            expectEquals(event.midiNote, 45);
+            expectEquals(static_cast<int>(event.samplePosition), 11 * hop);
+            expectEquals(tracker.getCurrentNote(), -1);
+
+            //the candidate from before the stop does not carry over
+            expect(!tracker.process(220.0f, 0.9f, 20 * hop, event));
+            expect(!tracker.stop(21 * hop, event));
+        }
+    }
+
+private:
+    static constexpr int hop = 512;
+
+    //one frame every hop at 48 kHz, frequency 0 for a frame without a pitch
+    static std::vector<NoteEvent> track(const std::vector<float>& frames, float confidence = 0.9f)
+    {
+        NoteTracker tracker;
+        tracker.prepare(48000.0);
+
+        std::vector<NoteEvent> events;
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            NoteEvent event;
+            if (tracker.process(frames[i], frames[i] > 0.0f ? confidence : 0.0f, static_cast<juce::int64>(i) * hop, event))
+                events.push_back(event);
+        }
+
+        return events;
+    }
+};
+
+static NoteTrackerTests noteTrackerTests;
+
+#endif
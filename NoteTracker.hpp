@@ -0,0 +1,61 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//a change in the note being played, found from the stream of pitch frames
+struct NoteEvent
+{
+    enum class Type
+    {
+        noteOn,       //a note started after silence
+        noteOff,      //the sounding note stopped
+        pitchChange   //the sounding note moved to another without a gap, a slide or legato
+    };
+
+    Type type = Type::noteOn;
+    int midiNote = -1;              //for noteOff the note that stopped
+    float frequency = 0.0f;         //latest frequency heard for the note, 0 for noteOff
+    float cents = 0.0f;             //how far that frequency is from the note
+    float confidence = 0.0f;        //mean confidence of the frames that confirmed it
+    juce::int64 samplePosition = 0; //stream position of the first frame the change was heard in
+};
+
+//note segmentation for the pitch analysis thread
+//each analysis frame is mapped to the nearest note, a new note has to hold for a minimum time
+//before it is reported and the sounding note is kept until a frame strays well past the
+//semitone boundary, so vibrato and single stray frames do not produce events
+//a note stops after a minimum run of frames without a confident pitch
+class NoteTracker
+{
+public:
+    NoteTracker() = default;
+
+    void prepare(double sampleRate);
+    void reset();
+
+    //the input stopped at samplePosition, ends the sounding note there rather than waiting for
+    //unvoiced frames and forgets any candidate, returns true with the noteOff in event when a note was sounding
+    bool stop(juce::int64 samplePosition, NoteEvent& event);
+
+    //feeds one analysis frame, frequency 0 or below when no pitch was found
+    //returns true when the frame completed an event, which is written to event
+    bool process(float frequency, float confidence, juce::int64 samplePosition, NoteEvent& event);
+
+    //note sounding now, -1 when none
+    int getCurrentNote() const { return currentNote; }
+
+private:
+    double sampleRate = 48000.0;
+
+    int currentNote = -1;
+
+    int candidateNote = -1;
+    int candidateFrames = 0;
+    juce::int64 candidateStart = 0;
+    float candidateConfidenceSum = 0.0f;
+
+    int unvoicedFrames = 0;
+    juce::int64 unvoicedStart = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoteTracker)
+};
@@ -0,0 +1,295 @@
+#include "OnsetDetector.hpp"
+#include "DSPKernels.hpp"
+#include <cmath>
+
+const double hopSeconds = 0.0025;              //detection hop, rounded up to a power of two (128 samples at 48 kHz)
+const double energyWindowSeconds = 0.02;       //energy is summed over this long so it does not ripple with the waveform of low notes
+const double historySeconds = 0.1;             //detection function history behind the adaptive threshold
+const float minOnsetLevel = 0.01f;             //RMS a hop needs to be taken as an attack
+const float detectionDelta = 0.25f;            //fixed part of the threshold, in log10 energy (about 2.5 dB)
+const float detectionScale = 1.5f;             //multiple of the recent mean detection added to the threshold
+const double refractoryBeatFraction = 0.5;     //refractory period as a share of the target beat
+const double minRefractorySeconds = 0.05;
+const double maxRefractorySeconds = 0.5;
+const float attackOverLevelBefore = 1.5f;      //an attack sample stands this far above the peak level ahead of it
+const float energyFloor = 1.0e-10f;            //keeps the log finite in digital silence
+
+
+//sizes the hop, history and downmix buffers for the device settings
+void OnsetDetector::prepare(double newSampleRate, int maximumBlockSize)
+{
+    sampleRate = newSampleRate > 0.0 ? newSampleRate : 48000.0;
+    hopSize = juce::nextPowerOfTwo(juce::jmax(16, static_cast<int>(sampleRate * hopSeconds)));
+
+    monoBuffer.assign(static_cast<size_t>(juce::jmax(1, maximumBlockSize)), 0.0f);
+    currentHop.assign(static_cast<size_t>(hopSize), 0.0f);
+    recentHops.assign(static_cast<size_t>(hopSize) * 2, 0.0f);
+    hopEnergies.assign(static_cast<size_t>(juce::jmax(4, static_cast<int>(std::ceil(sampleRate * energyWindowSeconds / hopSize)))), 0.0f);
+    hopPeaks.assign(hopEnergies.size(), 0.0f);
+    detectionHistory.assign(static_cast<size_t>(juce::jmax(8, static_cast<int>(sampleRate * historySeconds / hopSize))), 0.0f);
+
+    reset();
+}
+
+//clears the detection state and restarts the sample counter
+void OnsetDetector::reset()
+{
+    std::fill(currentHop.begin(), currentHop.end(), 0.0f);
+    std::fill(recentHops.begin(), recentHops.end(), 0.0f);
+    std::fill(detectionHistory.begin(), detectionHistory.end(), 0.0f);
+    std::fill(hopEnergies.begin(), hopEnergies.end(), 0.0f);
+    std::fill(hopPeaks.begin(), hopPeaks.end(), 0.0f);
+
+    hopFill = 0;
+    samplePosition = 0;
+    candidateHopStart = 0;
+    previousLogEnergy = std::log10(energyFloor);
+    previousDetection = 0.0f;
+    candidateDetection = 0.0f;
+    candidateAboveGate = false;
+    historyPosition = 0;
+    historySum = 0.0f;
+    energyPosition = 0;
+    windowEnergy = 0.0;
+    lastOnsetSample = -1;
+    numOnsets = 0;
+}
+
+//half the target beat, kept between 50 and 500 ms so 240 BPM and above still register
+double OnsetDetector::getRefractorySeconds() const
+{
+    const double bpm = juce::jmax(1.0, targetTempo.load());
+    return juce::jlimit(minRefractorySeconds, maxRefractorySeconds, refractoryBeatFraction * 60.0 / bpm);
+}
+
+//splits the block into detection hops, onsets are reported with their sample position
+int OnsetDetector::processBlock(const float* const* channels, int numChannels, int startSample, int numSamples)
+{
+    numOnsets = 0;
+
+    if (channels == nullptr || numChannels <= 0 || numSamples <= 0 || currentHop.empty())
+        return 0;
+
+    const int chunkCapacity = static_cast<int>(monoBuffer.size());
+
+    for (int chunkStart = 0; chunkStart < numSamples; chunkStart += chunkCapacity)
+    {
+        const int chunkSize = juce::jmin(chunkCapacity, numSamples - chunkStart);
+        DSPKernels::downmixToMono(monoBuffer.data(), channels, numChannels, startSample + chunkStart, chunkSize);
+        addSamples(monoBuffer.data(), chunkSize);
+    }
+
+    return numOnsets;
+}
+
+int OnsetDetector::processBlock(const float* samples, int numSamples)
+{
+    numOnsets = 0;
+
+    if (samples == nullptr || numSamples <= 0 || currentHop.empty())
+        return 0;
+
+    addSamples(samples, numSamples);
+    return numOnsets;
+}
+
+//fills the current hop from mono samples and analyses each hop as it completes
+void OnsetDetector::addSamples(const float* samples, int numSamples)
+{
+    int samplesRead = 0;
+    while (samplesRead < numSamples)
+    {
+        const int toCopy = juce::jmin(numSamples - samplesRead, hopSize - hopFill);
+        std::copy(samples + samplesRead, samples + samplesRead + toCopy, currentHop.data() + hopFill);
+
+        samplesRead += toCopy;
+        hopFill += toCopy;
+        samplePosition += toCopy;
+
+        if (hopFill == hopSize)
+        {
+            analyseHop();
+            hopFill = 0;
+        }
+    }
+}
+
+//detection function for the hop just filled, then peak picking on the hop before it
+//a peak needs the following hop to confirm it, so onsets are reported one hop late
+//but placed at their true sample position
+void OnsetDetector::analyseHop()
+{
+    float hopEnergy = 0.0f, hopPeak = 0.0f;
+    for (float sample : currentHop)
+    {
+        hopEnergy += sample * sample;
+        hopPeak = juce::jmax(hopPeak, std::abs(sample));
+    }
+
+    //energy of the window ending with this hop, a new attack raises it most on the hop it arrives in
+    windowEnergy += hopEnergy - hopEnergies[static_cast<size_t>(energyPosition)];
+    windowEnergy = juce::jmax(0.0, windowEnergy);
+    hopEnergies[static_cast<size_t>(energyPosition)] = hopEnergy;
+    hopPeaks[static_cast<size_t>(energyPosition)] = hopPeak;
+    energyPosition = (energyPosition + 1) % static_cast<int>(hopEnergies.size());
+
+    const float energy = static_cast<float>(windowEnergy / (static_cast<double>(hopSize) * hopEnergies.size()));
+    const float logEnergy = std::log10(energy + energyFloor);
+    const float detection = juce::jmax(0.0f, logEnergy - previousLogEnergy);
+
+    const float historyMean = historySum / static_cast<float>(detectionHistory.size());
+    const float threshold = detectionDelta + detectionScale * historyMean;
+
+    if (candidateAboveGate
+        && candidateDetection > threshold
+        && candidateDetection >= previousDetection
+        && candidateDetection > detection)
+    {
+        //an attack late in the earlier hop only shows fully in the candidate, so both are searched
+        //against the loudest hop ahead of them in the energy window
+        const int numHops = static_cast<int>(hopPeaks.size());
+        float levelBefore = 0.0f;
+        for (int age = 3; age < numHops; ++age)
+            levelBefore = juce::jmax(levelBefore, hopPeaks[static_cast<size_t>((energyPosition - 1 - age + 2 * numHops) % numHops)]);
+
+        const juce::int64 onsetSample = juce::jmax(static_cast<juce::int64>(0), candidateHopStart - hopSize + findAttackStart(recentHops.data(), 2 * hopSize, levelBefore));
+        const auto refractorySamples = static_cast<juce::int64>(getRefractorySeconds() * sampleRate);
+
+        if ((lastOnsetSample < 0 || onsetSample - lastOnsetSample >= refractorySamples) && numOnsets < maxOnsetsPerBlock)
+        {
+            onsets[static_cast<size_t>(numOnsets++)] = onsetSample;
+            lastOnsetSample = onsetSample;
+        }
+    }
+
+    //running mean of the detection function
+    historySum += candidateDetection - detectionHistory[static_cast<size_t>(historyPosition)];
+    detectionHistory[static_cast<size_t>(historyPosition)] = candidateDetection;
+    historyPosition = (historyPosition + 1) % static_cast<int>(detectionHistory.size());
+
+    //the hop just analysed becomes the next candidate
+    previousDetection = candidateDetection;
+    candidateDetection = detection;
+    candidateAboveGate = std::sqrt(hopEnergy / static_cast<float>(hopSize)) > minOnsetLevel;
+    candidateHopStart = samplePosition - hopSize;
+    previousLogEnergy = logEnergy;
+
+    std::copy(recentHops.begin() + hopSize, recentHops.end(), recentHops.begin());
+    std::copy(currentHop.begin(), currentHop.end(), recentHops.begin() + hopSize);
+}
+
+//first sample of the attack, where the level clearly leaves that before the searched hops
+//or passes halfway to their peak, whichever comes first
+int OnsetDetector::findAttackStart(const float* samples, int numSamples, float levelBefore) const
+{
+    float peak = 0.0f;
+    for (int i = 0; i < numSamples; ++i)
+        peak = juce::jmax(peak, std::abs(samples[i]));
+
+    const float attackLevel = juce::jmin(0.5f * peak, juce::jmax(attackOverLevelBefore * levelBefore, minOnsetLevel));
+
+    for (int i = 0; i < numSamples; ++i)
+        if (std::abs(samples[i]) >= attackLevel)
+            return i;
+
+    return 0;
+}
+
+#if JUCE_UNIT_TESTS
+
+#include "SyntheticGuitarSignal.hpp"
+
+class OnsetDetectorTests : public juce::UnitTest
+{
+public:
+    OnsetDetectorTests() : juce::UnitTest("Onset detector", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        const double sampleRate = 48000.0;
+
+        for (double bpm : { 60.0, 200.0, 240.0 })
+        {
+            beginTest("Plucks at " + juce::String(bpm, 0) + " BPM");
+
+            const int beatSamples = static_cast<int>(sampleRate * 60.0 / bpm);
+            const int firstOnset = 1000;
+            const int numBeats = 8;
+            auto input = renderPlucks(sampleRate, firstOnset, beatSamples, numBeats);
+
+            OnsetDetector detector;
+            detector.prepare(sampleRate, 256);
+            detector.setTargetTempo(bpm);
+
+            std::vector<juce::int64> detected;
+            const float* channels[] = { input.data() };
+            for (int start = 0; start < static_cast<int>(input.size()); start += 256)
+            {
+                detector.processBlock(channels, 1, start, juce::jmin(256, static_cast<int>(input.size()) - start));
+                for (int i = 0; i < detector.getNumOnsets(); ++i)
+                    detected.push_back(detector.getOnsetSample(i));
+            }
+
+            expectEquals(static_cast<int>(detected.size()), numBeats);
+
+            //sample accurate, well inside one 256 sample block
+            for (size_t i = 0; i < juce::jmin(detected.size(), static_cast<size_t>(numBeats)); ++i)
+                expectWithinAbsoluteError(static_cast<int>(detected[i]), firstOnset + static_cast<int>(i) * beatSamples, 16);
+        }
+
+        beginTest("A mono block finds the same onsets as a one channel block");
+        {
+            auto input = renderPlucks(sampleRate, 1000, static_cast<int>(sampleRate * 60.0 / 200.0), 8);
+
+            OnsetDetector channelDetector, monoDetector;
+            channelDetector.prepare(sampleRate, 256);
+            monoDetector.prepare(sampleRate, 256);
+
+            const float* channels[] = { input.data() };
+            int numOnsets = 0, numMatching = 0;
+            for (int start = 0; start < static_cast<int>(input.size()); start += 300)
+            {
+                const int numSamples = juce::jmin(300, static_cast<int>(input.size()) - start);
+                const int fromChannels = channelDetector.processBlock(channels, 1, start, numSamples);
+                expectEquals(monoDetector.processBlock(input.data() + start, numSamples), fromChannels);
+
+                for (int i = 0; i < juce::jmin(fromChannels, monoDetector.getNumOnsets()); ++i)
+                    numMatching += monoDetector.getOnsetSample(i) == channelDetector.getOnsetSample(i) ? 1 : 0;
+                numOnsets += fromChannels;
+            }
+
+            expectEquals(numOnsets, 8);
+            expectEquals(numMatching, numOnsets);
+            expectEquals(monoDetector.getSamplePosition(), static_cast<juce::int64>(input.size()));
+        }
+
+        beginTest("Refractory period follows the target tempo");
+        OnsetDetector detector;
+        detector.prepare(sampleRate, 256);
+        detector.setTargetTempo(240.0);
+        expectWithinAbsoluteError(detector.getRefractorySeconds(), 0.125, 1.0e-9);
+        detector.setTargetTempo(60.0);
+        expectWithinAbsoluteError(detector.getRefractorySeconds(), 0.5, 1.0e-9);
+    }
+
+private:
+    static std::vector<float> renderPlucks(double sampleRate, int firstOnset, int beatSamples, int numBeats)
+    {
+        std::vector<float> output(static_cast<size_t>(firstOnset + beatSamples * (numBeats + 1)), 0.0f);
+
+        for (int beat = 0; beat < numBeats; ++beat)
+        {
+            const int onset = firstOnset + beat * beatSamples;
+            auto pluck = SyntheticGuitarSignal::renderNote(sampleRate, beat % 2 == 0 ? 110.0f : 146.83f, 0.4f,
+                                                           static_cast<int>(output.size()) - onset, beat + 1);
+            for (size_t i = 0; i < pluck.size(); ++i)
+                output[static_cast<size_t>(onset) + i] += pluck[i];
+        }
+
+        return output;
+    }
+};
+
+static OnsetDetectorTests onsetDetectorTests;
+
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <vector>
+#include <juce_core/juce_core.h>
+
+//note onset detection for the Tempo tab and the batch analyser
+//the detection function is the rise in log energy between short hops, peaks above an adaptive
+//threshold are onsets, and each onset is placed at the first sample of its attack within the hop
+//onsets are counted in samples from a running counter, not from the time a block arrived,
+//and the refractory period between onsets follows the target tempo
+class OnsetDetector
+{
+public:
+    static constexpr int maxOnsetsPerBlock = 16;
+
+    OnsetDetector() = default;
+
+    void prepare(double sampleRate, int maximumBlockSize);
+    void reset();
+
+    //tempo the player is aiming for, sets the refractory period, safe from the message thread
+    void setTargetTempo(double bpm) { targetTempo.store(bpm); }
+
+    //downmixes and analyses the block, returns the number of onsets found in it
+    int processBlock(const float* const* channels, int numChannels, int startSample, int numSamples);
+
+    //a block that is already mono, read in place, as the AnalyserRegistry hands it out
+    int processBlock(const float* samples, int numSamples);
+
+    //onsets found by the last processBlock call, as sample positions since prepare or reset
+    int getNumOnsets() const { return numOnsets; }
+    juce::int64 getOnsetSample(int index) const { return onsets[static_cast<size_t>(index)]; }
+
+    //samples analysed since prepare or reset
+    juce::int64 getSamplePosition() const { return samplePosition; }
+
+    //samples still needed to complete the current hop, callers that follow the detection
+    //function slice their blocks at this boundary
+    int getSamplesUntilNextHop() const { return hopSize - hopFill; }
+
+    //detection function of the last completed hop, the onset strength envelope
+    float getOnsetStrength() const { return candidateDetection; }
+
+    double getSampleRate() const { return sampleRate; }
+    int getHopSize() const { return hopSize; }
+    double getRefractorySeconds() const;
+
+private:
+    void addSamples(const float* samples, int numSamples);
+    void analyseHop();
+    int findAttackStart(const float* samples, int numSamples, float levelBefore) const;
+
+    std::vector<float> monoBuffer;
+    std::vector<float> currentHop;    //hop being filled
+    std::vector<float> recentHops;    //the two hops before currentHop, the later is the onset candidate
+    std::vector<float> hopEnergies;   //energy of each hop in the energy window
+    std::vector<float> hopPeaks;      //and its peak level
+    std::vector<float> detectionHistory;
+
+    double sampleRate = 48000.0;
+    int hopSize = 128;
+    int hopFill = 0;
+    juce::int64 samplePosition = 0;      //samples analysed, including the partly filled hop
+    juce::int64 candidateHopStart = 0;   //sample position of the candidate hop
+
+    float previousLogEnergy = 0.0f;
+    float previousDetection = 0.0f;
+    float candidateDetection = 0.0f;
+    bool candidateAboveGate = false;
+    int historyPosition = 0;
+    int energyPosition = 0;
+    double windowEnergy = 0.0;
+    float historySum = 0.0f;
+    juce::int64 lastOnsetSample = -1;
+
+    std::atomic<double> targetTempo { 120.0 };
+
+    std::array<juce::int64, maxOnsetsPerBlock> onsets {};
+    int numOnsets = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OnsetDetector)
+};
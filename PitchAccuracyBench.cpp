@@ -0,0 +1,251 @@
+#include "PitchAccuracyBench.hpp"
+#include "DSPKernels.hpp"
+#include "NoteMapping.hpp"
+#include "SyntheticGuitarSignal.hpp"
+#include <cmath>
+
+namespace PitchAccuracyBench
+{
+    NoteResult measureNote(const Settings& settings, int midiNote)
+    {
+        NoteResult result;
+        result.midiNote = midiNote;
+        result.frequency = NoteMapping::getFrequencyForMidiNote(midiNote);
+
+        //renders the note with its pre-roll
+        SyntheticGuitarSignal::Settings signalSettings;
+        signalSettings.sampleRate = settings.sampleRate;
+        signalSettings.frequency = result.frequency;
+        signalSettings.amplitude = settings.amplitude;
+        signalSettings.decaySeconds = settings.decaySeconds;
+        signalSettings.noiseLevel = settings.noiseLevel;
+        signalSettings.numChannels = settings.numChannels;
+        signalSettings.stereoOffsetSamples = settings.stereoOffsetSamples;
+        signalSettings.seed = midiNote;
+
+        const int onsetSample = static_cast<int>(settings.preRollSeconds * settings.sampleRate);
+        const int totalSamples = onsetSample + static_cast<int>(settings.noteSeconds * settings.sampleRate);
+
+        juce::AudioBuffer<float> input(settings.numChannels, totalSamples);
+        SyntheticGuitarSignal::render(signalSettings, input, onsetSample);
+
+        auto detector = PitchDetector::create(settings.engine);
+        detector->initialize(static_cast<float>(settings.sampleRate), settings.blockSize);
+        detector->setHopSize(settings.hopSize);
+        if (auto* yin = dynamic_cast<YINAudioComponent*>(detector.get()))
+            yin->setDifferenceEngine(settings.differenceEngine);
+
+        const int windowSize = detector->getWindowSize();
+        const int decodingDelay = detector->getDecodingDelay();
+
+        std::vector<float> monoBuffer(static_cast<size_t>(settings.blockSize));
+        double sumAbsCents = 0.0;
+        int centsFrames = 0;
+
+        for (int blockStart = 0; blockStart < totalSamples; blockStart += settings.blockSize)
+        {
+            const int numSamples = juce::jmin(settings.blockSize, totalSamples - blockStart);
+            DSPKernels::downmixToMono(monoBuffer.data(), input.getArrayOfReadPointers(), input.getNumChannels(), blockStart, numSamples);
+
+            //split at analysis boundaries so every frame is seen with its end position
+            int offset = 0;
+            while (offset < numSamples)
+            {
+                const int samplesUntilAnalysis = detector->getSamplesUntilNextAnalysis();
+                const int sliceSize = juce::jmin(numSamples - offset, samplesUntilAnalysis);
+                const float pitch = detector->analyseBlock(monoBuffer.data() + offset, sliceSize).frequency;
+                offset += sliceSize;
+
+                if (sliceSize != samplesUntilAnalysis)
+                    continue;
+
+                //a decoded result describes the window that ended the decoding delay before this one
+                const int frameEnd = blockStart + offset - decodingDelay;
+                if (frameEnd <= onsetSample)
+                    continue;
+
+                const bool voiced = pitch > 0.0f;
+                const double cents = voiced ? 1200.0 * std::log2(pitch / result.frequency) : 0.0;
+
+                if (voiced && result.latencySamples < 0 && std::abs(cents) <= settings.correctCentsWindow)
+                    result.latencySamples = frameEnd - onsetSample;
+
+                //accuracy is only judged once the window holds nothing but the note
+                if (frameEnd - windowSize < onsetSample)
+                    continue;
+
+                ++result.steadyFrames;
+                if (!voiced)
+                    continue;
+
+                ++result.voicedFrames;
+
+                if (std::lround(cents / 1200.0) != 0)
+                {
+                    ++result.octaveErrors;
+                }
+                else
+                {
+                    sumAbsCents += std::abs(cents);
+                    ++centsFrames;
+                }
+
+                if (NoteMapping::getMidiNoteFromFrequencyWithTolerance(pitch) == midiNote)
+                    ++result.noteNameMatches;
+            }
+        }
+
+        result.meanAbsCentsError = centsFrames > 0 ? sumAbsCents / centsFrames : 0.0;
+        return result;
+    }
+
+    Summary run(const Settings& settings)
+    {
+        Summary summary;
+        summary.sampleRate = settings.sampleRate;
+        summary.engineName = PitchDetector::getEngineName(settings.engine);
+
+        {
+            auto detector = PitchDetector::create(settings.engine);
+            detector->initialize(static_cast<float>(settings.sampleRate), settings.blockSize);
+            detector->setHopSize(settings.hopSize);
+            summary.decodingDelaySamples = detector->getDecodingDelay();
+        }
+
+        int detectedNotes = 0, steadyFrames = 0, voicedFrames = 0, octaveErrors = 0, nameMatches = 0;
+        double latencySum = 0.0, centsSum = 0.0;
+        int centsNotes = 0;
+
+        for (int midiNote = settings.lowestMidiNote; midiNote <= settings.highestMidiNote; ++midiNote)
+        {
+            auto note = measureNote(settings, midiNote);
+            summary.notes.push_back(note);
+
+            if (note.latencySamples >= 0)
+            {
+                ++detectedNotes;
+                latencySum += note.latencySamples;
+                summary.maxLatencySamples = juce::jmax(summary.maxLatencySamples, static_cast<double>(note.latencySamples));
+            }
+            else
+            {
+                ++summary.notesNeverDetected;
+            }
+
+            if (note.voicedFrames > note.octaveErrors)
+            {
+                centsSum += note.meanAbsCentsError;
+                ++centsNotes;
+            }
+
+            steadyFrames += note.steadyFrames;
+            voicedFrames += note.voicedFrames;
+            octaveErrors += note.octaveErrors;
+            nameMatches += note.noteNameMatches;
+        }
+
+        summary.meanLatencySamples = detectedNotes > 0 ? latencySum / detectedNotes : 0.0;
+        summary.meanAbsCentsError = centsNotes > 0 ? centsSum / centsNotes : 0.0;
+        summary.detectionRate = steadyFrames > 0 ? static_cast<double>(voicedFrames) / steadyFrames : 0.0;
+        summary.octaveErrorRate = voicedFrames > 0 ? static_cast<double>(octaveErrors) / voicedFrames : 0.0;
+        summary.noteNameMatchRate = voicedFrames > 0 ? static_cast<double>(nameMatches) / voicedFrames : 0.0;
+
+        return summary;
+    }
+
+    juce::String formatSummary(const Summary& summary, bool includeNotes)
+    {
+        juce::String text;
+        const double samplesPerMs = summary.sampleRate / 1000.0;
+
+        if (includeNotes)
+        {
+            text << "note   freq Hz   latency ms   cents   voiced   octave err   name match\n";
+            for (const auto& note : summary.notes)
+            {
+                text << NoteMapping::getNoteNameForMidiNote(note.midiNote).paddedRight(' ', 5)
+                     << juce::String(note.frequency, 2).paddedLeft(' ', 9)
+                     << (note.latencySamples >= 0 ? juce::String(note.latencySamples / samplesPerMs, 1) : juce::String("-")).paddedLeft(' ', 13)
+                     << juce::String(note.meanAbsCentsError, 2).paddedLeft(' ', 8)
+                     << (juce::String(note.voicedFrames) + "/" + juce::String(note.steadyFrames)).paddedLeft(' ', 9)
+                     << juce::String(note.octaveErrors).paddedLeft(' ', 13)
+                     << juce::String(note.noteNameMatches).paddedLeft(' ', 13) << "\n";
+            }
+        }
+
+        text << summary.engineName << ", mean latency " << juce::String(summary.meanLatencySamples, 0) << " samples ("
+             << juce::String(summary.meanLatencySamples / samplesPerMs, 1) << " ms), max "
+             << juce::String(summary.maxLatencySamples / samplesPerMs, 1) << " ms, results "
+             << juce::String(summary.decodingDelaySamples / samplesPerMs, 1) << " ms later for decoding\n"
+             << "mean |error| " << juce::String(summary.meanAbsCentsError, 2) << " cents\n"
+             << "detection rate " << juce::String(summary.detectionRate * 100.0, 1) << "%, "
+             << "octave errors " << juce::String(summary.octaveErrorRate * 100.0, 2) << "%, "
+             << "note name matches " << juce::String(summary.noteNameMatchRate * 100.0, 1) << "%, "
+             << summary.notesNeverDetected << " notes never detected\n";
+
+        return text;
+    }
+}
+
+#if JUCE_UNIT_TESTS
+
+//baseline bars for the pitch path, any optimisation that trades accuracy or latency shows up here
+class PitchAccuracyBenchTests : public juce::UnitTest
+{
+public:
+    PitchAccuracyBenchTests() : juce::UnitTest("Pitch accuracy bench", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        PitchAccuracyBench::Settings settings;
+
+        //above C5 the synthetic pluck falls under the input magnitude gate before the window
+        //fills, the full E2 to E6 report keeps those notes visible
+        beginTest("E2 to C5 through the FFT engine");
+        settings.highestMidiNote = 72;
+        auto summary = PitchAccuracyBench::run(settings);
+        logMessage(PitchAccuracyBench::formatSummary(summary, false));
+
+        expectEquals(summary.notesNeverDetected, 0);
+        expectLessThan(summary.meanAbsCentsError, 5.0);
+        expectLessThan(summary.octaveErrorRate, 0.02);
+        expectGreaterThan(summary.noteNameMatchRate, 0.95);
+        expectLessThan(summary.maxLatencySamples, settings.sampleRate * 0.25);
+
+        beginTest("Direct and FFT engines agree");
+        settings.lowestMidiNote = 40;
+        settings.highestMidiNote = 64;
+        settings.differenceEngine = YINAudioComponent::DifferenceEngine::Direct;
+        auto direct = PitchAccuracyBench::run(settings);
+        settings.differenceEngine = YINAudioComponent::DifferenceEngine::FFT;
+        auto fft = PitchAccuracyBench::run(settings);
+
+        for (size_t i = 0; i < direct.notes.size(); ++i)
+        {
+            expectWithinAbsoluteError(direct.notes[i].voicedFrames, fft.notes[i].voicedFrames, 1);
+            expectWithinAbsoluteError(direct.notes[i].meanAbsCentsError, fft.notes[i].meanAbsCentsError, 0.2);
+        }
+
+        //the engines calibration picks between, each measured through the PitchDetector interface
+        for (auto engine : { PitchDetector::Engine::probabilisticYin, PitchDetector::Engine::decimatedYin, PitchDetector::Engine::mpm })
+        {
+            beginTest("E2 to C5 through " + PitchDetector::getEngineName(engine));
+            settings.engine = engine;
+            settings.highestMidiNote = 72;
+            auto engineSummary = PitchAccuracyBench::run(settings);
+            logMessage(PitchAccuracyBench::formatSummary(engineSummary, true));
+
+            //the stereo offset partly cancels B4 in the downmix, leaving it at the level gate, where
+            //the tracker can stay unvoiced for the whole note
+            expectLessOrEqual(engineSummary.notesNeverDetected, 1);
+            expectLessThan(engineSummary.meanAbsCentsError, 5.0);
+            expectLessThan(engineSummary.octaveErrorRate, 0.02);
+            expectGreaterThan(engineSummary.noteNameMatchRate, 0.95);
+            expectLessThan(engineSummary.maxLatencySamples, settings.sampleRate * 0.25);
+        }
+    }
+};
+
+static PitchAccuracyBenchTests pitchAccuracyBenchTests;
+
+#endif
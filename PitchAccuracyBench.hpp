@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <juce_core/juce_core.h>
+#include "PitchDetector.hpp"
+#include "YINAudioComponent.hpp"
+
+//accuracy and latency harness for the pitch path
+//plays synthetic plucked notes from E2 to E6 through any PitchDetector engine the way the
+//pitch analysis thread feeds it (stereo blocks, mono downmix, a slice per analysis) and through
+//the note mapping, and measures detection latency, pitch error in cents and the octave error rate
+namespace PitchAccuracyBench
+{
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        int hopSize = 512;
+        PitchDetector::Engine engine = PitchDetector::Engine::yin;   //any engine calibrate can pick
+        YINAudioComponent::DifferenceEngine differenceEngine = YINAudioComponent::DifferenceEngine::FFT;   //YIN engines only
+        int lowestMidiNote = 40;     //E2
+        int highestMidiNote = 88;    //E6
+        float amplitude = 0.5f;
+        float decaySeconds = 4.0f;
+        float noiseLevel = 0.005f;
+        int numChannels = 2;
+        int stereoOffsetSamples = 12;
+        double preRollSeconds = 0.25;
+        double noteSeconds = 0.5;
+        float correctCentsWindow = 50.0f;  //an estimate within this many cents counts as the right note
+    };
+
+    struct NoteResult
+    {
+        int midiNote = 0;
+        float frequency = 0.0f;
+        int latencySamples = -1;      //onset to the end of the window the first correct estimate describes, -1 if never detected
+        int steadyFrames = 0;         //frames whose window lies wholly inside the note
+        int voicedFrames = 0;
+        int octaveErrors = 0;
+        int noteNameMatches = 0;
+        double meanAbsCentsError = 0.0;  //over voiced steady frames without octave errors
+    };
+
+    struct Summary
+    {
+        std::vector<NoteResult> notes;
+        double sampleRate = 0.0;
+        juce::String engineName;
+        int decodingDelaySamples = 0;    //results arrive this much later than the latency, the engine's decoding lag
+        double meanLatencySamples = 0.0;
+        double maxLatencySamples = 0.0;
+        double meanAbsCentsError = 0.0;
+        double octaveErrorRate = 0.0;
+        double detectionRate = 0.0;
+        double noteNameMatchRate = 0.0;
+        int notesNeverDetected = 0;
+    };
+
+    NoteResult measureNote(const Settings& settings, int midiNote);
+    Summary run(const Settings& settings);
+
+    juce::String formatSummary(const Summary& summary, bool includeNotes);
+}
@@ -0,0 +1,345 @@
+#include "PitchAnalysisThread.hpp"
+
+const int analysisHopSize = 512;          //samples between pitch estimates, sets the detection latency
+const double fifoLengthSeconds = 1.0;     //audio the FIFO can hold before the analysis falls behind
+const int analysisPollIntervalMs = 2;     //sleep between FIFO checks when no audio is waiting
+const int analysisStopTimeoutMs = 1000;   //time allowed for the thread to finish its current frame
+
+PitchAnalysisThread::PitchAnalysisThread()
+    : juce::Thread("Pitch Analysis")
+{
+}
+
+PitchAnalysisThread::~PitchAnalysisThread()
+{
+    stop();
+}
+
+//sizes the FIFO for the device settings, the detector is made when the thread starts
+void PitchAnalysisThread::prepare(double sampleRate, int samplesPerBlockExpected)
+{
+    jassert(!isThreadRunning());
+
+    preparedSampleRate = sampleRate;
+    preparedBlockSize = samplesPerBlockExpected;
+    detector.reset();
+
+    int fifoSize = juce::jmax(samplesPerBlockExpected * 4, static_cast<int>(sampleRate * fifoLengthSeconds));
+    fifoBuffer.assign(static_cast<size_t>(fifoSize), 0.0f);
+    fifo.setTotalSize(fifoSize);
+
+    noteTracker.prepare(sampleRate);
+    clearQueues();
+
+    publishedResult = {};
+    latestResult.publish(publishedResult);
+    droppedSamples.store(0, std::memory_order_relaxed);
+}
+
+//empties the sample, mark and event FIFOs and restarts the stream position mapping
+void PitchAnalysisThread::clearQueues()
+{
+    fifo.reset();
+    markFifo.reset();
+    eventFifo.reset();
+    samplesWritten = 0;
+    nextStreamPosition = -1;
+    samplesRead = 0;
+    streamOffset = 0;
+}
+
+//a fixed engine, call while the thread is stopped
+void PitchAnalysisThread::selectEngine(PitchDetector::Engine engine)
+{
+    jassert(!isThreadRunning());
+
+    automaticEngine = false;
+    selectedEngine = engine;
+    detector.reset();
+}
+
+//calibrates at the next start for settings it has not calibrated yet, call while the thread is stopped
+void PitchAnalysisThread::selectEngineAutomatically()
+{
+    jassert(!isThreadRunning());
+
+    automaticEngine = true;
+    detector.reset();
+}
+
+//analysis thread, before the first block after prepare or a change of engine
+//the calibration runs here rather than in prepare so the audio device starts straight away,
+//blocks arriving meanwhile wait in the FIFO
+void PitchAnalysisThread::createDetector()
+{
+    if (automaticEngine && (preparedSampleRate != calibratedSampleRate || preparedBlockSize != calibratedBlockSize))
+    {
+        selectedEngine = PitchDetector::calibrate(preparedSampleRate, preparedBlockSize, analysisHopSize).engine;
+        calibratedSampleRate = preparedSampleRate;
+        calibratedBlockSize = preparedBlockSize;
+    }
+
+    detector = PitchDetector::create(selectedEngine);
+    detector->initialize(static_cast<float>(preparedSampleRate), preparedBlockSize);
+
+    //sliding window analysis so a note registers within one hop of the window filling
+    detector->setHopSize(analysisHopSize);
+
+    //the targets go to the new detector
+    appliedTargetSequence = 0;
+    engineInUse.store(static_cast<int>(selectedEngine), std::memory_order_relaxed);
+}
+
+//starts the analysis thread
+void PitchAnalysisThread::start()
+{
+    if (!isThreadRunning() && !fifoBuffer.empty())
+        startThread();
+}
+
+//stops the analysis thread and throws away any unanalysed audio
+void PitchAnalysisThread::stop()
+{
+    stopThread(analysisStopTimeoutMs);
+    clearQueues();
+    noteTracker.reset();
+}
+
+//copies a block of mono samples into the FIFO
+//a block that does not follow on from the last one leaves a mark so the analysis thread
+//can keep the stream position of its frames, a full mark FIFO drops the block instead
+void PitchAnalysisThread::pushSamples(const float* samples, int numSamples, juce::int64 streamPosition)
+{
+    if (streamPosition != nextStreamPosition)
+    {
+        int markStart1, markSize1, markStart2, markSize2;
+        markFifo.prepareToWrite(1, markStart1, markSize1, markStart2, markSize2);
+
+        if (markSize1 == 0)
+        {
+            droppedSamples.fetch_add(numSamples, std::memory_order_relaxed);
+            return;
+        }
+
+        streamMarks[static_cast<size_t>(markStart1)] = { samplesWritten, streamPosition };
+        markFifo.finishedWrite(1);
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    if (size1 > 0)
+        std::copy(samples, samples + size1, fifoBuffer.begin() + start1);
+    if (size2 > 0)
+        std::copy(samples + size1, samples + size1 + size2, fifoBuffer.begin() + start2);
+
+    fifo.finishedWrite(size1 + size2);
+    samplesWritten += size1 + size2;
+    nextStreamPosition = streamPosition + size1 + size2;
+
+    //keeps count of anything that did not fit so overruns can be spotted
+    if (size1 + size2 < numSamples)
+        droppedSamples.fetch_add(numSamples - size1 - size2, std::memory_order_relaxed);
+}
+
+//stores the targets for the analysis thread to pick up before its next block
+void PitchAnalysisThread::setTargetFrequencies(const std::vector<float>& frequencies)
+{
+    const int count = juce::jmin(static_cast<int>(frequencies.size()), YINAudioComponent::MAX_CANDIDATES);
+
+    targetSequence.fetch_add(1);
+    for (int i = 0; i < count; ++i)
+        targetFrequencies[static_cast<size_t>(i)].store(frequencies[static_cast<size_t>(i)]);
+    numTargets.store(count);
+    targetSequence.fetch_add(1);
+}
+
+//copies new targets into the detector, a read that overlaps a write is retried on the next pass
+void PitchAnalysisThread::applyPendingTargets()
+{
+    const auto sequence = targetSequence.load();
+    if (sequence == appliedTargetSequence || (sequence & 1u) != 0)
+        return;
+
+    std::array<float, YINAudioComponent::MAX_CANDIDATES> frequencies;
+    const int count = numTargets.load();
+    for (int i = 0; i < count; ++i)
+        frequencies[static_cast<size_t>(i)] = targetFrequencies[static_cast<size_t>(i)].load();
+
+    if (targetSequence.load() != sequence)
+        return;
+
+    detector->setCandidateFrequencies(frequencies.data(), count);
+    appliedTargetSequence = sequence;
+}
+
+//marks the end of the input, audio thread only
+//the analysis thread ends the sounding note here instead of waiting for the next block to show the gap
+void PitchAnalysisThread::pushInputStopped()
+{
+    if (nextStreamPosition < 0)
+        return;
+
+    int markStart1, markSize1, markStart2, markSize2;
+    markFifo.prepareToWrite(1, markStart1, markSize1, markStart2, markSize2);
+    if (markSize1 == 0)
+        return;
+
+    streamMarks[static_cast<size_t>(markStart1)] = { samplesWritten, inputStopped };
+    markFifo.finishedWrite(1);
+
+    //the next block leaves a mark of its own
+    nextStreamPosition = -1;
+}
+
+//analysis loop, drains the FIFO straight into the detector
+void PitchAnalysisThread::run()
+{
+    if (detector == nullptr)
+        createDetector();
+
+    while (!threadShouldExit())
+    {
+        applyPendingTargets();
+
+        int samplesReady = fifo.getNumReady();
+        if (samplesReady == 0)
+        {
+            //a stop mark can follow the last samples with nothing behind it
+            applyStreamMarks();
+            wait(analysisPollIntervalMs);
+            continue;
+        }
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(samplesReady, start1, size1, start2, size2);
+
+        if (size1 > 0)
+            analyseSamples(fifoBuffer.data() + start1, size1);
+        if (size2 > 0)
+            analyseSamples(fifoBuffer.data() + start2, size2);
+
+        fifo.finishedRead(size1 + size2);
+    }
+}
+
+//feeds the detector one analysis at a time so every frame can be given its stream position
+void PitchAnalysisThread::analyseSamples(const float* samples, int numSamples)
+{
+    while (numSamples > 0)
+    {
+        const auto nextMark = applyStreamMarks();
+
+        const int samplesUntilAnalysis = detector->getSamplesUntilNextAnalysis();
+        int sliceSize = juce::jmin(numSamples, samplesUntilAnalysis);
+
+        if (nextMark >= 0)
+            sliceSize = juce::jmin(sliceSize, static_cast<int>(nextMark - samplesRead));
+
+        const auto result = detector->analyseBlock(samples, sliceSize);
+
+        samples += sliceSize;
+        numSamples -= sliceSize;
+        samplesRead += sliceSize;
+
+        if (sliceSize == samplesUntilAnalysis)
+        {
+            //a smoothed result describes a window that ended a few hops back
+            trackFrame(result, streamOffset + samplesRead - 1 - detector->getDecodingDelay());
+            publishResult(result);
+        }
+    }
+}
+
+//picks up the marks reached by the samples read so far, returns the FIFO sample of the next
+//mark still ahead or -1 when there is none
+//a block that does not follow on from the last, or the end of the input, would join unrelated
+//audio in one window, so the detector starts again and the sounding note ends where the input broke off
+juce::int64 PitchAnalysisThread::applyStreamMarks()
+{
+    for (;;)
+    {
+        int markStart1, markSize1, markStart2, markSize2;
+        markFifo.prepareToRead(1, markStart1, markSize1, markStart2, markSize2);
+
+        if (markSize1 == 0)
+            return -1;
+
+        const auto& mark = streamMarks[static_cast<size_t>(markStart1)];
+        if (mark.fifoSample > samplesRead)
+            return mark.fifoSample;
+
+        const auto endOfInput = streamOffset + samplesRead;
+        if (mark.streamPosition != endOfInput)
+            restartAnalysis(endOfInput);
+
+        if (mark.streamPosition != inputStopped)
+            streamOffset = mark.streamPosition - mark.fifoSample;
+
+        markFifo.finishedRead(1);
+    }
+}
+
+//empties the detector's window and ends the sounding note at streamPosition
+void PitchAnalysisThread::restartAnalysis(juce::int64 streamPosition)
+{
+    detector->reset();
+
+    NoteEvent event;
+    if (noteTracker.stop(streamPosition, event))
+        queueNoteEvent(event);
+
+    publishResult({});
+}
+
+//runs the frame through the note tracker and queues any event it completes
+void PitchAnalysisThread::trackFrame(const PitchDetector::Result& result, juce::int64 streamPosition)
+{
+    NoteEvent event;
+    if (noteTracker.process(result.frequency, result.confidence, streamPosition, event))
+        queueNoteEvent(event);
+}
+
+//the queue is left alone when the message thread has fallen behind by a full FIFO of events
+void PitchAnalysisThread::queueNoteEvent(const NoteEvent& event)
+{
+    int start1, size1, start2, size2;
+    eventFifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 == 0)
+        return;
+
+    noteEvents[static_cast<size_t>(start1)] = event;
+    eventFifo.finishedWrite(1);
+}
+
+//copies queued note events out for the message thread
+int PitchAnalysisThread::popNoteEvents(NoteEvent* events, int maxEvents)
+{
+    int start1, size1, start2, size2;
+    eventFifo.prepareToRead(maxEvents, start1, size1, start2, size2);
+
+    std::copy(noteEvents.begin() + start1, noteEvents.begin() + start1 + size1, events);
+    std::copy(noteEvents.begin() + start2, noteEvents.begin() + start2 + size2, events + size1);
+
+    eventFifo.finishedRead(size1 + size2);
+    return size1 + size2;
+}
+
+//hands the frame to the display, frames that find no pitch and leave the note as it was are not published
+void PitchAnalysisThread::publishResult(const PitchDetector::Result& result)
+{
+    const int midiNote = noteTracker.getCurrentNote();
+
+    if (result.frequency <= 0.0f && midiNote == publishedResult.midiNote)
+        return;
+
+    if (result.frequency > 0.0f)
+    {
+        publishedResult.pitch = result.frequency;
+        publishedResult.confidence = result.confidence;
+    }
+
+    publishedResult.midiNote = midiNote;
+    ++publishedResult.frameCount;
+    latestResult.publish(publishedResult);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <juce_core/juce_core.h>
+#include "AnalysisSnapshot.hpp"
+#include "PitchDetector.hpp"
+#include "YINAudioComponent.hpp"
+#include "NoteTracker.hpp"
+
+//runs pitch detection on its own thread
+//the audio callback only pushes mono samples into a wait-free single producer,
+//single consumer FIFO, the analysis thread drains it and publishes the latest result as a snapshot
+//every analysis frame goes through a NoteTracker, the note events it produces are queued for
+//the message thread, a frame is stamped with the stream position of the last sample in its window
+//the message thread pulls both once per display frame, nothing is posted to it
+class PitchAnalysisThread : public juce::Thread
+{
+public:
+    //the latest analysis frame
+    struct Result
+    {
+        float pitch = -1.0f;          //Hz of the last frame with a pitch, -1 before the first
+        float confidence = 0.0f;      //of that pitch
+        int midiNote = -1;            //note the tracker has sounding, -1 when none
+        juce::uint32 frameCount = 0;  //results published since prepare
+    };
+
+    PitchAnalysisThread();
+    ~PitchAnalysisThread() override;
+
+    //configures the detector and FIFO, call while the thread is stopped
+    void prepare(double sampleRate, int samplesPerBlockExpected);
+
+    void start();
+    void stop();
+
+    //the detection engine, by default the fastest that passes a calibration run at the first start
+    //for each device setting, call while the thread is stopped
+    void selectEngine(PitchDetector::Engine engine);
+    void selectEngineAutomatically();
+
+    //engine of the running detector, safe from any thread
+    PitchDetector::Engine getEngine() const { return static_cast<PitchDetector::Engine>(engineInUse.load(std::memory_order_relaxed)); }
+
+    //audio thread only, never blocks or allocates, drops samples when the FIFO is full
+    //streamPosition is the position of samples[0] in the input, blocks need not be contiguous
+    void pushSamples(const float* samples, int numSamples, juce::int64 streamPosition);
+
+    //audio thread only, the input stops after the last pushed block until pushSamples is called again
+    //the sounding note ends there and the next block starts a fresh window
+    void pushInputStopped();
+
+    //candidate notes for the scale challenge, message thread only
+    //while set the detector only checks these pitches and their octaves, an empty list returns to the full search
+    void setTargetFrequencies(const std::vector<float>& frequencies);
+
+    //message thread only, copies out up to maxEvents queued note events, oldest first
+    int popNoteEvents(NoteEvent* events, int maxEvents);
+
+    //message thread only, copies out the latest result, returns true when it is newer than the last read
+    bool readLatestResult(Result& result) { return latestResult.read(result); }
+    int getDroppedSampleCount() const { return droppedSamples.load(std::memory_order_relaxed); }
+
+    void run() override;
+
+private:
+    static constexpr int maxStreamMarks = 32;
+    static constexpr int maxQueuedNoteEvents = 64;
+
+    static constexpr juce::int64 inputStopped = -1;   //stream position of a mark left by pushInputStopped
+
+    //the FIFO sample at which the input jumps to a new stream position
+    struct StreamMark
+    {
+        juce::int64 fifoSample = 0;
+        juce::int64 streamPosition = 0;
+    };
+
+    void analyseSamples(const float* samples, int numSamples);
+    void createDetector();
+    juce::int64 applyStreamMarks();
+    void restartAnalysis(juce::int64 streamPosition);
+    void trackFrame(const PitchDetector::Result& result, juce::int64 streamPosition);
+    void queueNoteEvent(const NoteEvent& event);
+    void publishResult(const PitchDetector::Result& result);
+    void applyPendingTargets();
+    void clearQueues();
+
+    std::unique_ptr<PitchDetector> detector;   //analysis thread once started
+    bool automaticEngine = true;
+    PitchDetector::Engine selectedEngine = PitchDetector::Engine::probabilisticYin;
+    std::atomic<int> engineInUse { static_cast<int>(PitchDetector::Engine::probabilisticYin) };
+    double preparedSampleRate = 0.0;
+    int preparedBlockSize = 0;
+    double calibratedSampleRate = 0.0;   //settings of the last calibration
+    int calibratedBlockSize = 0;
+
+    juce::AbstractFifo fifo { 1 };
+    std::vector<float> fifoBuffer;
+
+    //stream positions of the FIFO samples, written by the audio thread only where they jump
+    juce::AbstractFifo markFifo { maxStreamMarks };
+    std::array<StreamMark, maxStreamMarks> streamMarks;
+    juce::int64 samplesWritten { 0 };        //audio thread
+    juce::int64 nextStreamPosition { -1 };   //audio thread
+    juce::int64 samplesRead { 0 };           //analysis thread
+    juce::int64 streamOffset { 0 };          //analysis thread, stream position minus FIFO sample
+
+    NoteTracker noteTracker;
+    juce::AbstractFifo eventFifo { maxQueuedNoteEvents };
+    std::array<NoteEvent, maxQueuedNoteEvents> noteEvents;
+
+    Result publishedResult;   //analysis thread
+    AnalysisSnapshot<Result> latestResult;
+
+    //targets handed over with a sequence counter, odd while the message thread is writing
+    std::array<std::atomic<float>, YINAudioComponent::MAX_CANDIDATES> targetFrequencies {};
+    std::atomic<int> numTargets { 0 };
+    std::atomic<juce::uint32> targetSequence { 0 };
+    juce::uint32 appliedTargetSequence { 0 };
+    std::atomic<int> droppedSamples { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PitchAnalysisThread)
+};
@@ -0,0 +1,182 @@
+#include "PitchDetector.hpp"
+#include "McLeodPitchDetector.hpp"
+#include "NoteMapping.hpp"
+#include "SyntheticGuitarSignal.hpp"
+#include "YINAudioComponent.hpp"
+#include <cmath>
+
+//calibration workload, a few settled analyses of each note keep it well under a second on a phone
+const int calibrationNotes[] = { 40, 45, 50, 55, 59, 64, 69, 76 };   //low E to E5
+const int calibrationAnalysesPerNote = 12;
+
+std::unique_ptr<PitchDetector> PitchDetector::create(Engine engine)
+{
+    switch (engine)
+    {
+        case Engine::mpm:
+            return std::make_unique<McLeodPitchDetector>();
+
+        case Engine::probabilisticYin:
+        case Engine::decimatedYin:
+        {
+            auto yin = std::make_unique<YINAudioComponent>();
+            yin->setProbabilistic(true);
+            if (engine == Engine::decimatedYin)
+                yin->setDecimationFactor(YINAudioComponent::automaticDecimation);
+            return yin;
+        }
+
+        case Engine::yin:
+        default:
+            return std::make_unique<YINAudioComponent>();
+    }
+}
+
+juce::String PitchDetector::getEngineName(Engine engine)
+{
+    switch (engine)
+    {
+        case Engine::mpm:               return "MPM";
+        case Engine::probabilisticYin:  return "pYIN";
+        case Engine::decimatedYin:      return "pYIN decimated";
+        case Engine::yin:
+        default:                        return "YIN";
+    }
+}
+
+//each engine is fed the plucks the way the pitch analysis thread feeds it, a slice per analysis,
+//and only the calls that complete an analysis are timed
+PitchDetector::Calibration PitchDetector::calibrate(double sampleRate, int blockSize, int hopSize)
+{
+    Calibration calibration;
+    const auto ticksPerSecond = static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+
+    for (auto engine : { Engine::yin, Engine::probabilisticYin, Engine::decimatedYin, Engine::mpm })
+    {
+        EngineScore score;
+        score.engine = engine;
+
+        juce::int64 analysisTicks = 0;
+        int numAnalyses = 0, numSettled = 0, numHits = 0;
+
+        for (int midiNote : calibrationNotes)
+        {
+            auto detector = create(engine);
+            detector->initialize(static_cast<float>(sampleRate), blockSize);
+            detector->setHopSize(hopSize);
+
+            //results before the window has settled past the decoding delay are not judged
+            const int windowSize = detector->getSamplesUntilNextAnalysis();
+            const int interval = hopSize > 0 ? juce::jmin(hopSize, windowSize) : windowSize;
+            const int unsettledAnalyses = detector->getDecodingDelay() / interval + 1;
+            const int analysesToRun = unsettledAnalyses + calibrationAnalysesPerNote;
+
+            const float frequency = NoteMapping::getFrequencyForMidiNote(midiNote);
+            const auto signal = SyntheticGuitarSignal::renderNote(sampleRate, frequency, 0.5f, windowSize + analysesToRun * interval);
+
+            int position = 0;
+            for (int analysis = 0; analysis < analysesToRun; ++analysis)
+            {
+                const int sliceSize = detector->getSamplesUntilNextAnalysis();
+                if (position + sliceSize > static_cast<int>(signal.size()))
+                    break;
+
+                const auto startTicks = juce::Time::getHighResolutionTicks();
+                const auto result = detector->analyseBlock(signal.data() + position, sliceSize);
+                analysisTicks += juce::Time::getHighResolutionTicks() - startTicks;
+                position += sliceSize;
+                ++numAnalyses;
+
+                if (analysis < unsettledAnalyses)
+                    continue;
+
+                ++numSettled;
+                if (result.frequency > 0.0f && std::abs(1200.0f * std::log2(result.frequency / frequency)) <= calibrationToleranceCents)
+                    ++numHits;
+            }
+        }
+
+        score.nanosecondsPerAnalysis = numAnalyses > 0 ? static_cast<double>(analysisTicks) * 1.0e9 / ticksPerSecond / numAnalyses : 0.0;
+        score.accuracy = numSettled > 0 ? static_cast<float>(numHits) / static_cast<float>(numSettled) : 0.0f;
+        calibration.scores.push_back(score);
+    }
+
+    //the fastest engine over the bar, otherwise the most accurate
+    const EngineScore* chosen = nullptr;
+    for (const auto& score : calibration.scores)
+        if (score.accuracy >= calibrationAccuracyBar && (chosen == nullptr || score.nanosecondsPerAnalysis < chosen->nanosecondsPerAnalysis))
+            chosen = &score;
+
+    if (chosen == nullptr)
+        for (const auto& score : calibration.scores)
+            if (chosen == nullptr || score.accuracy > chosen->accuracy)
+                chosen = &score;
+
+    if (chosen != nullptr)
+        calibration.engine = chosen->engine;
+
+    return calibration;
+}
+
+#if JUCE_UNIT_TESTS
+
+class PitchDetectorTests : public juce::UnitTest
+{
+public:
+    PitchDetectorTests() : juce::UnitTest("Pitch detector engines", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        const float sampleRate = 48000.0f;
+        const int hopSize = 512;
+
+        beginTest("Every engine finds a plucked note through the same interface");
+        for (auto engine : { PitchDetector::Engine::yin, PitchDetector::Engine::probabilisticYin, PitchDetector::Engine::decimatedYin, PitchDetector::Engine::mpm })
+        {
+            auto detector = PitchDetector::create(engine);
+            detector->initialize(sampleRate, hopSize);
+            detector->setHopSize(hopSize);
+
+            const float frequency = NoteMapping::getFrequencyForMidiNote(45);
+            auto signal = SyntheticGuitarSignal::renderNote(sampleRate, frequency, 0.6f, 8192 + 16 * hopSize);
+
+            PitchDetector::Result last;
+            for (int offset = 0; offset + hopSize <= static_cast<int>(signal.size()); offset += hopSize)
+            {
+                const auto result = detector->analyseBlock(signal.data() + offset, hopSize);
+                if (result.frequency > 0.0f)
+                    last = result;
+            }
+
+            expectWithinAbsoluteError(last.frequency, frequency, 0.5f, PitchDetector::getEngineName(engine));
+            expectGreaterThan(last.confidence, 0.5f);
+        }
+
+        beginTest("Calibration picks the fastest engine over the accuracy bar");
+        {
+            const auto calibration = PitchDetector::calibrate(sampleRate, hopSize, hopSize);
+            expectEquals(static_cast<int>(calibration.scores.size()), 4);
+
+            const PitchDetector::EngineScore* chosen = nullptr;
+            for (const auto& score : calibration.scores)
+            {
+                expectGreaterThan(score.nanosecondsPerAnalysis, 0.0);
+                if (score.engine == calibration.engine)
+                    chosen = &score;
+            }
+
+            expect(chosen != nullptr);
+            if (chosen == nullptr)
+                return;
+
+            expectGreaterOrEqual(chosen->accuracy, PitchDetector::calibrationAccuracyBar);
+            for (const auto& score : calibration.scores)
+                if (score.accuracy >= PitchDetector::calibrationAccuracyBar)
+                    expectLessOrEqual(chosen->nanosecondsPerAnalysis, score.nanosecondsPerAnalysis);
+        }
+    }
+};
+
+static PitchDetectorTests pitchDetectorTests;
+
+#endif
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <juce_core/juce_core.h>
+
+//a pitch detection engine for the pitch analysis thread
+//every engine takes the same mono blocks, keeps its own analysis window, analyses it each hop
+//once it has filled and reports the same result, so the thread can swap one for another
+class PitchDetector
+{
+public:
+    enum class Engine
+    {
+        yin,                //first dip of the YIN difference function
+        probabilisticYin,   //YIN dips smoothed by the Viterbi tracker
+        decimatedYin,       //probabilistic YIN behind the decimating front end, a window of a quarter or eighth the samples
+        mpm                 //McLeod pitch method, key maxima of the normalised square difference
+    };
+
+    struct Result
+    {
+        float frequency = -1.0f;   //Hz, -1 when the block held no analysis or no pitch was found
+        float confidence = 0.0f;   //0 to 1
+    };
+
+    virtual ~PitchDetector() = default;
+
+    //sizes the analysis window, bufferSize is the largest block the caller will pass
+    virtual void initialize(float sampleRate, int bufferSize) = 0;
+
+    //samples between analyses of the sliding window, 0 analyses each window once
+    virtual void setHopSize(int newHopSize) = 0;
+
+    //empties the window, the next analysis waits for a full window of new samples
+    //for input that does not follow on from the last block, so no window joins the two
+    virtual void reset() = 0;
+
+    //samples still needed before the next analysis
+    virtual int getSamplesUntilNextAnalysis() const = 0;
+
+    //input samples an analysis covers
+    virtual int getWindowSize() const = 0;
+
+    //adds a block, the result is that of the last analysis the block completed
+    virtual Result analyseBlock(const float* samples, int numSamples) = 0;
+
+    //samples between the end of the window just analysed and the end of the window a result describes
+    virtual int getDecodingDelay() const { return 0; }
+
+    //notes the caller expects, engines that can't narrow their search ignore them
+    virtual void setCandidateFrequencies(const float* frequencies, int numCandidates) { juce::ignoreUnused(frequencies, numCandidates); }
+
+    static std::unique_ptr<PitchDetector> create(Engine engine);
+    static juce::String getEngineName(Engine engine);
+
+    //startup calibration, every engine is run over synthetic plucks across the guitar's range at
+    //the device's settings and timed, the fastest that finds enough of the notes is chosen
+    struct EngineScore
+    {
+        Engine engine = Engine::yin;
+        double nanosecondsPerAnalysis = 0.0;
+        float accuracy = 0.0f;   //share of settled analyses within the tolerance of the note
+    };
+
+    struct Calibration
+    {
+        Engine engine = Engine::probabilisticYin;   //the choice, the most accurate engine when none meets the bar
+        std::vector<EngineScore> scores;
+    };
+
+    static constexpr float calibrationAccuracyBar = 0.95f;
+    static constexpr float calibrationToleranceCents = 25.0f;
+
+    static Calibration calibrate(double sampleRate, int blockSize, int hopSize);
+};
@@ -0,0 +1,87 @@
+#include "PitchModel.hpp"
+
+//the tables are built by the compiler, these hold whatever it is asked to build them for
+static_assert(PitchModel::Tuning().estimate(440.0f).midiNote == PitchModel::referenceNote, "A4 maps to MIDI note 69");
+static_assert(PitchModel::Tuning().estimate(82.41f).midiNote == 40, "low E maps to MIDI note 40");
+static_assert(PitchModel::Tuning(432.0f).estimate(432.0f).midiNote == PitchModel::referenceNote, "the reference is A4 whatever its frequency");
+static_assert(!PitchModel::Tuning().estimate(0.0f).isValid(), "no note for silence");
+static_assert(PitchModel::NoteSet { 40, 52, 64 }.getPitchClasses() == (1u << 4), "octaves share a pitch class");
+
+#if JUCE_UNIT_TESTS
+
+#include <cmath>
+
+class PitchModelTests : public juce::UnitTest
+{
+public:
+    PitchModelTests() : juce::UnitTest("Pitch model", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        beginTest("Note frequencies match equal temperament");
+        {
+            const PitchModel::Tuning tuning;
+            for (int note = 0; note < PitchModel::numNotes; ++note)
+                expectWithinAbsoluteError(tuning.getFrequency(note) / exactFrequency(note, 440.0), 1.0, 1.0e-6);
+
+            expectEquals(tuning.getFrequency(-1), 0.0f);
+            expectEquals(tuning.getFrequency(PitchModel::numNotes), 0.0f);
+        }
+
+        beginTest("Estimates give the nearest note and its cents");
+        for (float referenceA4 : { 440.0f, 432.0f, 446.0f })
+        {
+            const PitchModel::Tuning tuning(referenceA4);
+
+            for (int note = 24; note <= 96; ++note)
+            {
+                for (double cents : { -49.0, -20.0, 0.0, 7.5, 49.0 })
+                {
+                    const auto frequency = static_cast<float>(exactFrequency(note, referenceA4) * std::pow(2.0, cents / 1200.0));
+                    const auto estimate = tuning.estimate(frequency);
+
+                    expectEquals(estimate.midiNote, note);
+                    expectWithinAbsoluteError(static_cast<double>(estimate.cents), cents, 0.01);
+                }
+            }
+        }
+
+        beginTest("The note boundary sits half a semitone from each note");
+        {
+            const PitchModel::Tuning tuning;
+            expectEquals(tuning.estimate(static_cast<float>(exactFrequency(45, 440.0) * std::pow(2.0, 0.51 / 12.0))).midiNote, 46);
+            expectEquals(tuning.estimate(static_cast<float>(exactFrequency(45, 440.0) * std::pow(2.0, 0.49 / 12.0))).midiNote, 45);
+            expect(!tuning.estimate(-10.0f).isValid());
+            expect(!tuning.estimate(20000.0f).isValid());
+        }
+
+        beginTest("Note sets");
+        {
+            PitchModel::NoteSet cMajorChord { 48, 52, 55, 60, 64 };
+            expect(cMajorChord.contains(48));
+            expect(cMajorChord.contains(64));
+            expect(!cMajorChord.contains(50));
+            expect(!cMajorChord.contains(-1));
+            expect(!cMajorChord.contains(200));
+            expect(cMajorChord.containsPitchClass(36));
+            expect(!cMajorChord.containsPitchClass(37));
+            expectEquals(static_cast<int>(cMajorChord.getPitchClasses()), (1 << 0) | (1 << 4) | (1 << 7));
+
+            PitchModel::NoteSet built;
+            expect(built.isEmpty());
+            for (int note : { 48, 52, 55, 60, 64 })
+                built.add(note);
+            expect(built == cMajorChord);
+        }
+    }
+
+private:
+    static double exactFrequency(int midiNote, double referenceA4)
+    {
+        return referenceA4 * std::pow(2.0, (midiNote - 69) / 12.0);
+    }
+};
+
+static PitchModelTests pitchModelTests;
+
+#endif
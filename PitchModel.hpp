@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <initializer_list>
+#include <juce_core/juce_core.h>
+
+//integer pitch model shared by the note tracker, the scale challenge and the chord check
+//notes are MIDI note numbers, a detected frequency becomes a note plus its deviation in cents
+//the equal tempered frequency and note boundary tables are built at compile time relative to A4,
+//so a lookup is a binary search and a multiply whatever reference the player tunes to
+namespace PitchModel
+{
+    constexpr int numNotes = 128;
+    constexpr int referenceNote = 69;                 //A4
+    constexpr float defaultReferenceA4 = 440.0f;
+
+    constexpr double semitoneRatio = 1.0594630943592953;    //2^(1/12)
+    constexpr double quarterToneRatio = 1.0293022366434921; //2^(1/24), half a semitone
+    constexpr double centsPerNeper = 1731.2340490667561;    //1200 / ln 2
+
+    namespace detail
+    {
+        constexpr std::array<double, numNotes> makeNoteRatios()
+        {
+            std::array<double, numNotes> ratios {};
+            ratios[referenceNote] = 1.0;
+
+            for (int note = referenceNote + 1; note < numNotes; ++note)
+                ratios[static_cast<size_t>(note)] = ratios[static_cast<size_t>(note - 1)] * semitoneRatio;
+            for (int note = referenceNote - 1; note >= 0; --note)
+                ratios[static_cast<size_t>(note)] = ratios[static_cast<size_t>(note + 1)] / semitoneRatio;
+
+            return ratios;
+        }
+
+        constexpr std::array<double, numNotes + 1> makeBoundaryRatios()
+        {
+            const auto ratios = makeNoteRatios();
+            std::array<double, numNotes + 1> boundaries {};
+
+            for (int note = 0; note < numNotes; ++note)
+                boundaries[static_cast<size_t>(note)] = ratios[static_cast<size_t>(note)] / quarterToneRatio;
+            boundaries[numNotes] = ratios[numNotes - 1] * quarterToneRatio;
+
+            return boundaries;
+        }
+    }
+
+    //frequency of each note as a multiple of A4
+    constexpr auto noteRatios = detail::makeNoteRatios();
+
+    //lower edge of each note half a semitone below it, the last entry is the upper edge of note 127
+    constexpr auto boundaryRatios = detail::makeBoundaryRatios();
+
+    constexpr bool isValidNote(int midiNote) { return midiNote >= 0 && midiNote < numNotes; }
+    constexpr int pitchClassOf(int midiNote) { return ((midiNote % 12) + 12) % 12; }
+    constexpr int octaveOf(int midiNote) { return (midiNote - pitchClassOf(midiNote)) / 12 - 1; }  //60 is C4
+
+    //nearest note to a frequency and how far the frequency is from it
+    struct PitchEstimate
+    {
+        int midiNote = -1;   //-1 when the frequency is outside the MIDI range
+        float cents = 0.0f;  //-50 to +50
+
+        constexpr bool isValid() const { return midiNote >= 0; }
+        constexpr float getExactNote() const { return static_cast<float>(midiNote) + cents * 0.01f; }
+    };
+
+    //maps between notes and frequencies for an A4 reference
+    class Tuning
+    {
+    public:
+        constexpr Tuning() = default;
+        constexpr explicit Tuning(float newReferenceA4)
+            : referenceA4(newReferenceA4 > 0.0f ? newReferenceA4 : defaultReferenceA4) {}
+
+        constexpr float getReferenceA4() const { return referenceA4; }
+
+        //equal tempered frequency of a note, 0 outside the MIDI range
+        constexpr float getFrequency(int midiNote) const
+        {
+            return isValidNote(midiNote) ? static_cast<float>(referenceA4 * noteRatios[static_cast<size_t>(midiNote)]) : 0.0f;
+        }
+
+        //nearest note by binary search of the boundary table, cents from a short series for
+        //ln(r) = 2 atanh((r - 1) / (r + 1)) that is exact to well under a thousandth of a cent
+        //within half a semitone, so no log or pow is needed per frame
+        constexpr PitchEstimate estimate(float frequency) const
+        {
+            const double ratio = static_cast<double>(frequency) / referenceA4;
+
+            if (!(ratio >= boundaryRatios[0] && ratio < boundaryRatios[numNotes]))
+                return {};
+
+            int low = 0, high = numNotes;
+            while (high - low > 1)
+            {
+                const int middle = (low + high) / 2;
+                if (ratio >= boundaryRatios[static_cast<size_t>(middle)])
+                    low = middle;
+                else
+                    high = middle;
+            }
+
+            const double x = (ratio / noteRatios[static_cast<size_t>(low)] - 1.0) / (ratio / noteRatios[static_cast<size_t>(low)] + 1.0);
+            const double x2 = x * x;
+
+            PitchEstimate result;
+            result.midiNote = low;
+            result.cents = static_cast<float>(centsPerNeper * 2.0 * x * (1.0 + x2 * (1.0 / 3.0 + x2 / 5.0)));
+            return result;
+        }
+
+    private:
+        float referenceA4 = defaultReferenceA4;
+    };
+
+    //a set of notes, one bit per MIDI note so building and testing it never allocates
+    class NoteSet
+    {
+    public:
+        constexpr NoteSet() = default;
+
+        constexpr NoteSet(std::initializer_list<int> notes)
+        {
+            for (int note : notes)
+                add(note);
+        }
+
+        constexpr void add(int midiNote)
+        {
+            if (isValidNote(midiNote))
+                bits[static_cast<size_t>(midiNote / 64)] |= juce::uint64 { 1 } << (midiNote % 64);
+        }
+
+        constexpr bool contains(int midiNote) const
+        {
+            return isValidNote(midiNote) && ((bits[static_cast<size_t>(midiNote / 64)] >> (midiNote % 64)) & 1u) != 0;
+        }
+
+        //bit per pitch class, C is bit 0
+        constexpr juce::uint16 getPitchClasses() const
+        {
+            juce::uint16 pitchClasses = 0;
+            for (int note = 0; note < numNotes; ++note)
+                if (contains(note))
+                    pitchClasses = static_cast<juce::uint16>(pitchClasses | (1u << pitchClassOf(note)));
+            return pitchClasses;
+        }
+
+        constexpr bool containsPitchClass(int midiNote) const
+        {
+            return ((getPitchClasses() >> pitchClassOf(midiNote)) & 1u) != 0;
+        }
+
+        constexpr bool isEmpty() const { return bits[0] == 0 && bits[1] == 0; }
+
+        constexpr bool operator== (const NoteSet& other) const { return bits[0] == other.bits[0] && bits[1] == other.bits[1]; }
+        constexpr bool operator!= (const NoteSet& other) const { return !(*this == other); }
+
+    private:
+        std::array<juce::uint64, 2> bits {};
+    };
+}
@@ -0,0 +1,111 @@
+#include "SyntheticGuitarSignal.hpp"
+#include <cmath>
+
+//Karplus-Strong string
+//the loop is a delay line, a two point average (half a sample of delay, the string loss)
+//and a first order allpass that supplies the fractional part of the period so the
+//pitch is exact rather than rounded to whole samples
+std::vector<float> SyntheticGuitarSignal::renderString(const Settings& settings, int numSamples)
+{
+    std::vector<float> output(static_cast<size_t>(juce::jmax(0, numSamples)), 0.0f);
+    if (numSamples <= 0 || settings.frequency <= 0.0f)
+        return output;
+
+    //period split into whole samples plus an allpass delay kept between 0.1 and 1.1 samples
+    const double period = settings.sampleRate / settings.frequency;
+    const int delayLength = juce::jmax(2, static_cast<int>(std::floor(period - 0.5 - 0.1)));
+    const double fractionalDelay = period - 0.5 - delayLength;
+    const double allpassCoefficient = (1.0 - fractionalDelay) / (1.0 + fractionalDelay);
+
+    //loss per trip round the loop for the requested 60 dB decay time of the fundamental
+    //the averaging filter already loses cos(pi f / fs) per trip, which is compensated here
+    //harmonics still decay faster, as on a real string, and the gain stays below 1 at DC
+    const double averagingLoss = std::cos(juce::MathConstants<double>::pi * settings.frequency / settings.sampleRate);
+    const double loopGain = juce::jmin(0.9999, std::pow(10.0, -3.0 / (juce::jmax(0.01f, settings.decaySeconds) * settings.frequency)) / averagingLoss);
+
+    //excitation: noise burst, low passed for darker plucks and comb filtered by the pluck position
+    juce::Random random(settings.seed);
+    std::vector<double> delayLine(static_cast<size_t>(delayLength), 0.0);
+    const double smoothing = 1.0 - juce::jlimit(0.0f, 1.0f, settings.brightness) * 0.9;
+    double filtered = 0.0;
+    for (auto& sample : delayLine)
+    {
+        filtered += (random.nextFloat() * 2.0 - 1.0 - filtered) * (1.0 - smoothing * 0.95);
+        sample = filtered;
+    }
+
+    const int pluckOffset = juce::jlimit(1, delayLength - 1, static_cast<int>(delayLength * settings.pluckPosition));
+    std::vector<double> excitation(delayLine);
+    for (int i = 0; i < delayLength; ++i)
+        delayLine[static_cast<size_t>(i)] = excitation[static_cast<size_t>(i)] - excitation[static_cast<size_t>((i + pluckOffset) % delayLength)];
+
+    //normalise the excitation to the RMS of a sine with the requested amplitude
+    double sumOfSquares = 1.0e-12;
+    for (auto sample : delayLine)
+        sumOfSquares += sample * sample;
+    const double excitationGain = settings.amplitude * std::sqrt(0.5 * delayLength / sumOfSquares);
+    for (auto& sample : delayLine)
+        sample *= excitationGain;
+
+    int readPosition = 0;
+    double previousSample = 0.0;
+    double allpassInput = 0.0, allpassOutput = 0.0;
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        double current = delayLine[static_cast<size_t>(readPosition)];
+        output[static_cast<size_t>(n)] = static_cast<float>(current);
+
+        //string loss and averaging
+        double averaged = loopGain * 0.5 * (current + previousSample);
+        previousSample = current;
+
+        //fractional delay tuning
+        double tuned = allpassCoefficient * averaged + allpassInput - allpassCoefficient * allpassOutput;
+        allpassInput = averaged;
+        allpassOutput = tuned;
+
+        delayLine[static_cast<size_t>(readPosition)] = tuned;
+        readPosition = (readPosition + 1) % delayLength;
+    }
+
+    return output;
+}
+
+std::vector<float> SyntheticGuitarSignal::renderNote(double sampleRate, float frequency, float amplitude, int numSamples, juce::int64 seed)
+{
+    Settings settings;
+    settings.sampleRate = sampleRate;
+    settings.frequency = frequency;
+    settings.amplitude = amplitude;
+    settings.seed = seed;
+    return renderString(settings, numSamples);
+}
+
+//renders the note into every channel of the buffer with noise and the stereo offset applied
+void SyntheticGuitarSignal::render(const Settings& settings, juce::AudioBuffer<float>& buffer, int preRollSamples)
+{
+    const int numChannels = juce::jmax(1, settings.numChannels);
+    const int numSamples = buffer.getNumSamples();
+    buffer.setSize(numChannels, numSamples, false, true, true);
+    buffer.clear();
+
+    preRollSamples = juce::jlimit(0, numSamples, preRollSamples);
+    auto string = renderString(settings, numSamples - preRollSamples);
+
+    juce::Random random(settings.seed + 7919);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* samples = buffer.getWritePointer(channel);
+        const int offset = preRollSamples + (channel > 0 ? settings.stereoOffsetSamples : 0);
+        const float gain = channel > 0 ? settings.stereoGain : 1.0f;
+
+        for (int i = offset; i < numSamples; ++i)
+            samples[i] = gain * string[static_cast<size_t>(i - offset)];
+
+        if (settings.noiseLevel > 0.0f)
+            for (int i = 0; i < numSamples; ++i)
+                samples[i] += settings.noiseLevel * (random.nextFloat() * 2.0f - 1.0f);
+    }
+}
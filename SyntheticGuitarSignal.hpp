@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//plucked string test signal generator (Karplus-Strong with fractional delay tuning)
+//gives known notes with natural harmonics and decay, optional background noise and
+//a delayed, attenuated second channel to mimic a stereo input
+class SyntheticGuitarSignal
+{
+public:
+    struct Settings
+    {
+        double sampleRate = 48000.0;
+        float frequency = 110.0f;
+        float amplitude = 0.5f;
+        float decaySeconds = 2.0f;        //time for the note to fall by 60 dB
+        float brightness = 0.5f;          //0 gives a dark, mostly fundamental pluck, 1 a bright one
+        float pluckPosition = 0.2f;       //fraction of the string length, shapes the harmonic mix
+        float noiseLevel = 0.0f;          //peak level of the background white noise
+        int numChannels = 1;
+        int stereoOffsetSamples = 0;      //extra delay of the second channel
+        float stereoGain = 0.8f;          //level of the second channel relative to the first
+        juce::int64 seed = 1;
+    };
+
+    //renders a note starting after preRollSamples of silence (plus noise)
+    static void render(const Settings& settings, juce::AudioBuffer<float>& buffer, int preRollSamples);
+
+    //the mono plucked string alone, exposed for single channel callers
+    static std::vector<float> renderString(const Settings& settings, int numSamples);
+
+    //renderString with the default tone, the pluck the tests play
+    static std::vector<float> renderNote(double sampleRate, float frequency, float amplitude, int numSamples, juce::int64 seed = 1);
+};
@@ -1,8 +1,23 @@
 #include "TabComponent1.hpp"
 
+const int maxVoicingsListed = 24;   //voicings offered per chord, the library's shape and the easiest alternatives
+
+//fretboard layout
+const juce::Colour boardColour = juce::Colour::fromRGB(240, 230, 200);
+const float stringThickness[MusicLibrary::numStrings] = { 1.0f, 1.25f, 1.5f, 1.75f, 2.0f, 2.5f };
+const int nutX = 80;                //first fret wire shown
+const int boardMarginRight = 60;    //room for the verification dots
+const int wireOverhang = 5;         //half the nut's width, either side of the wires shown
+const int neckTop = 60;             //fret numbers down to the bottom of the fret wires
+const int neckBottom = 262;
+const int minFretWidth = 16;
+const int minFretsShown = 3;
+const int defaultFretsShown = 4;
+const int numNeckFrets = 22;        //the board shows a window of them that is dragged along the neck
 
 //TabComponent1 implementation
-TabComponent1::TabComponent1()
+TabComponent1::TabComponent1(const MusicLibrary& chordLibrary)
+    : library(chordLibrary)
 {
     //UI setup
     addAndMakeVisible(chordLabel);
@@ -10,6 +25,11 @@ TabComponent1::TabComponent1()
     chordLabel.setFont(juce::FontOptions(24.0f, juce::Font::bold));
     chordLabel.setJustificationType(juce::Justification::centred);
     chordLabel.setColour(juce::Label::textColourId, juce::Colours::black);
+
+    addAndMakeVisible(verificationLabel);
+    verificationLabel.setFont(juce::FontOptions(18.0f));
+    verificationLabel.setJustificationType(juce::Justification::centred);
+    verificationLabel.setColour(juce::Label::textColourId, juce::Colours::black);
     
     addAndMakeVisible(infoButton);
     infoButton.setButtonText("Info");
@@ -17,164 +37,323 @@ TabComponent1::TabComponent1()
     addAndMakeVisible(infoOverlay);
     infoOverlay.setVisible(false);
 
-    //combobox for dropdown menuu
-    chordComboBox.addItem("C Major", 1);
-    chordComboBox.addItem("G Major", 2);
-    chordComboBox.addItem("D Major", 3);
-    chordComboBox.addItem("A Major", 4);
-    chordComboBox.addItem("E Major", 5);
-    chordComboBox.addItem("A Minor", 6);
-    chordComboBox.addItem("E Minor", 7);
+    //combobox for dropdown menuu, one item per chord in the library in the order it lists them
+    for (int position = 0; position < library.getNumChords(); ++position)
+    {
+        const int chordIndex = library.getChordInDisplayOrder(position);
+        if (chordIndex >= 0)
+            chordComboBox.addItem(library.getChord(chordIndex).name, chordIndex + 1);
+    }
 
     //loads the chord when selected
     chordComboBox.onChange = [this]() { loadChord(); };
     addAndMakeVisible(chordComboBox);
 
+    //other ways to play the selected chord
+    voicingComboBox.setTextWhenNothingSelected("Voicing");
+    voicingComboBox.onChange = [this]() { loadVoicing(); };
+    addAndMakeVisible(voicingComboBox);
+
     setSize(500, 300);
 }
 
 //this handles the drawing of the frets and the placement
 //of finger positions and muted strings
+//the fretboard itself comes from the cached images so a repaint costs a copy of the board, one
+//of the fret tile per visible fret and the overlay, however long the neck
 void TabComponent1::paint(juce::Graphics& g)
 {
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (!boardImage.isValid() || scale != imageScale)
+    {
+        renderBoard(scale);
+        fretImage = {};
+    }
 
-    g.fillAll(juce::Colour::fromRGB(240, 230, 200));
+    if (!fretImage.isValid())
+        renderFret(scale);
 
-    //drawing fret lines
-    juce::ColourGradient fretGradient(juce::Colours::lightgrey, 0, 0, juce::Colours::darkgrey, getWidth(), 0, false);
-    g.setGradientFill(fretGradient);
+    g.drawImageTransformed(boardImage, juce::AffineTransform::scale(1.0f / imageScale));
 
-   //currently limited to 4 frets, this can be expanded
-    for (int i = 0; i < 4; ++i)
+    //a tile per fret wire shown, the last one clipped to its wire
+    const int fretWidth = getFretWidth();
     {
-        //fret spaceing
-        int fretX = 80 + i * 80;
-        g.setColour(juce::Colours::darkgrey);
+        juce::Graphics::ScopedSaveState state(g);
+        g.reduceClipRegion(nutX - wireOverhang, neckTop, fretsShown * fretWidth + 2 * wireOverhang, neckBottom - neckTop);
 
-        //increased first line thickness to show start of fretboard
-        if (i == 0)
-        {
-            g.drawLine(fretX, 80, fretX, 260, 9.0f);
-        }
-        else
+        for (int i = 0; i <= fretsShown; ++i)
+            g.drawImageTransformed(fretImage, juce::AffineTransform::scale(1.0f / imageScale)
+                                                  .translated(static_cast<float>(nutX - wireOverhang + i * fretWidth),
+                                                              static_cast<float>(neckTop)));
+
+        //the nut is thicker to show the start of the fretboard
+        if (firstFretShown == 1)
         {
-            g.drawLine(fretX, 80, fretX, 260, 3.0f);
+            g.setColour(juce::Colours::darkgrey);
+            g.drawLine(static_cast<float>(nutX), 80.0f, static_cast<float>(nutX), 260.0f, 9.0f);
         }
-
-        //adds fret numbers just above the fret lines
-        g.setColour(juce::Colours::black);
-        g.setFont(juce::FontOptions(14.0f, juce::Font::bold));
-        g.drawText(juce::String(i + 1), fretX - 5, 60, 20, 20, juce::Justification::centred);
     }
 
-    //draws strings with thickness differences
-    juce::Array<float> stringThickness = {1.0f, 1.25f, 1.5f, 1.75f, 2.0f, 2.5f};
-    for (int i = 0; i < 6; ++i)
+    //fret numbers above the middle of each fret
+    g.setColour(juce::Colours::black);
+    g.setFont(juce::FontOptions(14.0f, juce::Font::bold));
+    for (int i = 0; i < fretsShown; ++i)
+        g.drawText(juce::String(firstFretShown + i), nutX + i * fretWidth, neckTop, fretWidth, 20, juce::Justification::centred);
+
+    //adds red dots for finger positions, centred between their fret wires
+    for (const auto& pos : currentChordPositions)
     {
-        g.setColour(juce::Colours::darkslategrey);
-        g.drawLine(50, 100 + i * 30, getWidth() - 50, 100 + i * 30, stringThickness[i]);
+        //assigns values from loadchord to the string and fret positions
+        const int string = pos.first;
+        const int fret = pos.second;
+
+        if (fret < firstFretShown || fret >= firstFretShown + fretsShown)
+            continue;
+
+        const float xPos = nutX + (fret - firstFretShown + 0.5f) * fretWidth - 7.5f;
+        const float yPos = getStringY(string) - 7.5f;
+
+        g.setColour(juce::Colours::red);
+        g.fillEllipse(xPos, yPos, 15, 15);
+
+        g.setColour(juce::Colours::white.withAlpha(0.6f));
+        g.fillEllipse(xPos + 3, yPos + 3, 9, 9);
     }
 
-    //adds red dots for finger positions
-    if (!currentChordPositions.empty())
+   //muted strings implementation, orange when heard ringing
+    g.setFont(juce::FontOptions(16.0f, juce::Font::bold));
+    for (int string : mutedStrings)
     {
-        for (int i = 0; i < currentChordPositions.size(); ++i)
-        {
-            //assigns values from loadchord to the string and fret positions
-            const auto& pos = currentChordPositions[i];
-            int string = pos.first;
-            int fret = pos.second;
-
-            //fret and string psoitions
-            float xPos = 80 + fret * 80 - 40;
-            float yPos = 100 + string * 30 - 10;
-
-            g.setColour(juce::Colours::red);
-            
-           
-            g.fillEllipse(xPos, yPos, 15, 15);
-
-           
-            g.setColour(juce::Colours::white.withAlpha(0.6f));
-            g.fillEllipse(xPos + 3, yPos + 3, 9, 9);
-        }
+        g.setColour(verificationResult.isMutedStringRinging(string - 1) ? juce::Colours::orange : juce::Colours::black);
+
+        //places x beside muted strings
+        g.drawText("X", juce::Rectangle<float>(20.0f, getStringY(string - 1) - 10.0f, 20.0f, 20.0f), juce::Justification::centred);
     }
 
-   //muted strings implementation
-    if (!mutedStrings.empty())
+    //per string result of the chord check at the end of each string, green heard and red missed
+    if (verificationResult.active)
     {
-        g.setColour(juce::Colours::black);
-        for (int string : mutedStrings)
+        for (int i = 0; i < ChordVerifier::numStrings; ++i)
         {
-            float xPos = 50;
-            float yPos = 100 + string * 30;
+            if (!verificationResult.isStringExpected(i))
+                continue;
 
-            //places x beside muted strings
-            g.setFont(juce::FontOptions(16.0f, juce::Font::bold));
-            g.drawText("X", xPos - 30, yPos - 40, 20, 20, juce::Justification::centred);
+            g.setColour(verificationResult.isStringHit(i) ? juce::Colours::green : juce::Colours::red);
+            g.fillEllipse(getWidth() - 45.0f, getStringY(i) - 6.0f, 12.0f, 12.0f);
         }
     }
 }
 
+//background and the strings from edge to edge, at the display's pixel density
+void TabComponent1::renderBoard(float scale)
+{
+    imageScale = scale;
+    boardImage = juce::Image(juce::Image::RGB,
+                             juce::jmax(1, juce::roundToInt(getWidth() * scale)),
+                             juce::jmax(1, juce::roundToInt(getHeight() * scale)), false);
+
+    juce::Graphics g(boardImage);
+    g.addTransform(juce::AffineTransform::scale(scale));
+    g.fillAll(boardColour);
+
+    g.setColour(juce::Colours::darkslategrey);
+    for (int i = 0; i < MusicLibrary::numStrings; ++i)
+        g.drawLine(50.0f, getStringY(i), getWidth() - 50.0f, getStringY(i), stringThickness[i]);
+}
+
+//one fret at the current zoom, its wire and the strings up to the next wire, every fret of the
+//neck looks the same so only the size or zoom changing redraws it
+void TabComponent1::renderFret(float scale)
+{
+    const int fretWidth = getFretWidth();
+
+    fretImage = juce::Image(juce::Image::RGB,
+                            juce::roundToInt(fretWidth * scale),
+                            juce::roundToInt((neckBottom - neckTop) * scale), false);
+
+    juce::Graphics g(fretImage);
+    g.addTransform(juce::AffineTransform::translation(0.0f, static_cast<float>(-neckTop)).scaled(scale));
+    g.fillAll(boardColour);
+
+    g.setColour(juce::Colours::darkgrey);
+    g.drawLine(static_cast<float>(wireOverhang), 80.0f, static_cast<float>(wireOverhang), 260.0f, 3.0f);
+
+    //draws strings with thickness differences
+    g.setColour(juce::Colours::darkslategrey);
+    for (int i = 0; i < MusicLibrary::numStrings; ++i)
+        g.drawLine(0.0f, getStringY(i), static_cast<float>(fretWidth), getStringY(i), stringThickness[i]);
+}
+
+//whole frets between the nut's position and the verification dots, however many are shown
+int TabComponent1::getFretWidth() const
+{
+    return juce::jmax(minFretWidth, (getWidth() - nutX - boardMarginRight) / fretsShown);
+}
+
+//index 0 is the high e string at the top
+float TabComponent1::getStringY(int stringIndex)
+{
+    return 100.0f + stringIndex * 30.0f;
+}
+
+//moves and zooms the window onto the neck, zooming changes the fret width so the tile is redrawn
+//as many frets as fit the board at the narrowest fret, the whole neck when the board is wide enough
+void TabComponent1::setVisibleFrets(int firstFret, int numFrets)
+{
+    const int fretsThatFit = (getWidth() - nutX - boardMarginRight) / minFretWidth;
+    numFrets = juce::jlimit(minFretsShown, juce::jlimit(minFretsShown, numNeckFrets, fretsThatFit), numFrets);
+    firstFret = juce::jlimit(1, numNeckFrets - numFrets + 1, firstFret);
+
+    if (numFrets != fretsShown)
+        fretImage = {};
+
+    if (numFrets != fretsShown || firstFret != firstFretShown)
+    {
+        fretsShown = numFrets;
+        firstFretShown = firstFret;
+        repaint();
+    }
+}
+
+//dragging along the board scrolls the neck a fret at a time
+void TabComponent1::mouseDown(const juce::MouseEvent&)
+{
+    dragStartFret = firstFretShown;
+    pinchFretsShown = static_cast<float>(fretsShown);
+}
+
+void TabComponent1::mouseDrag(const juce::MouseEvent& e)
+{
+    const float fretsDragged = e.getDistanceFromDragStartX() / static_cast<float>(getFretWidth());
+    setVisibleFrets(dragStartFret - juce::roundToInt(fretsDragged), fretsShown);
+}
+
+//double tap switches between the chord sized window and the whole neck
+void TabComponent1::mouseDoubleClick(const juce::MouseEvent&)
+{
+    setVisibleFrets(firstFretShown, fretsShown > defaultFretsShown ? defaultFretsShown : numNeckFrets);
+}
+
+void TabComponent1::mouseWheelMove(const juce::MouseEvent&, const juce::MouseWheelDetails& wheel)
+{
+    const float delta = std::abs(wheel.deltaX) > std::abs(wheel.deltaY) ? wheel.deltaX : wheel.deltaY;
+
+    if (delta != 0.0f)
+        setVisibleFrets(firstFretShown + (delta < 0.0f ? 1 : -1), fretsShown);
+}
+
+void TabComponent1::mouseMagnify(const juce::MouseEvent&, float scaleFactor)
+{
+    if (scaleFactor <= 0.0f)
+        return;
+
+    pinchFretsShown = juce::jlimit(static_cast<float>(minFretsShown), static_cast<float>(numNeckFrets), pinchFretsShown / scaleFactor);
+    setVisibleFrets(firstFretShown, juce::roundToInt(pinchFretsShown));
+}
 
-//chord finger positions and muted strings are stored here, add more here
+
+//lists the selected chord's voicings, the library's shape first and then the generated
+//alternatives easiest first, and shows the first
 void TabComponent1::loadChord()
+{
+    voicingChoices.clear();
+    voicingComboBox.clear(juce::dontSendNotification);
+
+    const int chordIndex = chordComboBox.getSelectedId() - 1;
+
+    if (chordIndex >= 0 && chordIndex < library.getNumChords())
+    {
+        const auto chord = library.getChord(chordIndex);
+        voicingChoices.push_back(chord.frets);
+
+        for (const auto& voicing : voicingGenerator.getVoicings(chord.root, chord.quality))
+        {
+            if (static_cast<int>(voicingChoices.size()) >= maxVoicingsListed)
+                break;
+            if (voicing.frets != chord.frets)
+                voicingChoices.push_back(voicing.frets);
+        }
+
+        for (size_t i = 0; i < voicingChoices.size(); ++i)
+            voicingComboBox.addItem(describeShape(voicingChoices[i]), static_cast<int>(i) + 1);
+        voicingComboBox.setSelectedId(1, juce::dontSendNotification);
+
+        chordLabel.setText(chord.name, juce::dontSendNotification);
+    }
+    else
+    {
+        chordLabel.setText("Select a chord...", juce::dontSendNotification);
+    }
+
+    loadVoicing();
+}
+
+//shows the selected voicing's finger positions and muted strings and checks the strum against it
+void TabComponent1::loadVoicing()
 {
     currentChordPositions.clear();
     mutedStrings.clear();
+    int firstFret = 1;
+
+    const int voicingIndex = voicingComboBox.getSelectedId() - 1;
+    const bool hasShape = voicingIndex >= 0 && voicingIndex < static_cast<int>(voicingChoices.size());
 
-    switch (chordComboBox.getSelectedId())
+    if (hasShape)
     {
-        case 1:
-            currentChordPositions = {{4, 3}, {3, 2}, {1, 1}};
-            mutedStrings = {6};
-            chordLabel.setText("C Major", juce::dontSendNotification);
-            break;
-
-        case 2:
-            currentChordPositions = {{5, 3}, {4, 2}, {0, 3}};
-            mutedStrings = {};
-            chordLabel.setText("G Major", juce::dontSendNotification);
-            break;
-
-        case 3:
-            currentChordPositions = {{2, 2}, {1, 3}, {0, 2}};
-            mutedStrings = {5, 6};
-            chordLabel.setText("D Major", juce::dontSendNotification);
-            break;
-
-        case 4:
-            currentChordPositions = {{3, 2}, {2, 2}, {1, 2}};
-            mutedStrings = {6};
-            chordLabel.setText("A Major", juce::dontSendNotification);
-            break;
-
-        case 5:
-            currentChordPositions = {{4, 2}, {3, 2}, {2, 1}};
-            mutedStrings = {};
-            chordLabel.setText("E Major", juce::dontSendNotification);
-            break;
-
-        case 6:
-            currentChordPositions = {{3, 2}, {2, 2}, {1, 1}};
-            mutedStrings = {6};
-            chordLabel.setText("A Minor", juce::dontSendNotification);
-            break;
-
-        case 7:
-            currentChordPositions = {{4, 2}, {3, 2}};
-            mutedStrings = {};
-            chordLabel.setText("E Minor", juce::dontSendNotification);
-            break;
-
-        default:
-            chordLabel.setText("Select a chord...", juce::dontSendNotification);
-            break;
+        const auto& frets = voicingChoices[static_cast<size_t>(voicingIndex)];
+        int lowestFret = 0, highestFret = 0;
+
+        for (int string = 0; string < MusicLibrary::numStrings; ++string)
+        {
+            const int fret = frets[static_cast<size_t>(string)];
+
+            if (fret == MusicLibrary::mutedFret)
+                mutedStrings.push_back(string + 1);
+            else if (fret > 0)
+            {
+                currentChordPositions.push_back({ string, fret });
+                lowestFret = lowestFret == 0 ? fret : juce::jmin(lowestFret, fret);
+                highestFret = juce::jmax(highestFret, fret);
+            }
+        }
+
+        //shapes up the neck are drawn from their lowest fret
+        if (highestFret > fretsShown)
+            firstFret = lowestFret;
     }
 
+    setVisibleFrets(firstFret, fretsShown);
+
+    //nothing is checked until a chord is picked
+    if (hasShape)
+        chordVerifier.setShape(ChordVerifier::Shape::fromTab(currentChordPositions, mutedStrings));
+    else
+        chordVerifier.setShape(ChordVerifier::Shape());
+
+    verificationResult = {};
+    verificationLabel.setText(hasShape ? "Strum the chord..." : "", juce::dontSendNotification);
+
     repaint();
 }
 
+//frets from the low E string up, x for muted, e.g. "x32010"
+juce::String TabComponent1::describeShape(const std::array<int, MusicLibrary::numStrings>& frets)
+{
+    const bool twoDigitFrets = std::any_of(frets.begin(), frets.end(), [](int fret) { return fret > 9; });
+
+    juce::String text;
+    for (int string = MusicLibrary::numStrings - 1; string >= 0; --string)
+    {
+        const int fret = frets[static_cast<size_t>(string)];
+        text << (fret == MusicLibrary::mutedFret ? juce::String("x") : juce::String(fret));
+        if (twoDigitFrets && string > 0)
+            text << "-";
+    }
+
+    return text;
+}
+
 
 //UI layout
 void TabComponent1::resized()
@@ -189,12 +368,19 @@ void TabComponent1::resized()
     flexBox.alignItems = juce::FlexBox::AlignItems::center;
 
     flexBox.items.add(juce::FlexItem(chordLabel).withMinWidth(300).withMinHeight(40).withMargin(juce::FlexItem::Margin(10)));
+    flexBox.items.add(juce::FlexItem(verificationLabel).withMinWidth(300).withMinHeight(30).withMargin(juce::FlexItem::Margin(10)));
     flexBox.items.add(juce::FlexItem(chordComboBox).withMinWidth(200).withMinHeight(30).withMargin(juce::FlexItem::Margin(10)));
+    flexBox.items.add(juce::FlexItem(voicingComboBox).withMinWidth(200).withMinHeight(30).withMargin(juce::FlexItem::Margin(10)));
     flexBox.items.add(juce::FlexItem(infoButton).withMinWidth(150).withMinHeight(30).withMargin(juce::FlexItem::Margin(10)));
 
     flexBox.performLayout(bounds);
 
     infoOverlay.setBounds(getLocalBounds());
+
+    //the fret width follows the width, both images are redrawn at the next paint
+    boardImage = {};
+    fretImage = {};
+    setVisibleFrets(firstFretShown, fretsShown);
 }
 
 
@@ -215,3 +401,50 @@ void TabComponent1::toggleInfoOverlay()
         }
     });
 }
+
+//shows the latest chord check, runs once per display frame and repaints only when a new one came in
+void TabComponent1::refreshFromAnalysis()
+{
+    ChordVerifier::Result result;
+    if (!latestVerification.read(result))
+        return;
+
+    verificationResult = result;
+
+    if (chordComboBox.getSelectedId() <= 0)
+        verificationLabel.setText("", juce::dontSendNotification);
+    else if (!verificationResult.active)
+        verificationLabel.setText("Strum the chord...", juce::dontSendNotification);
+    else if (verificationResult.isChordCorrect())
+        verificationLabel.setText("Sounds good!", juce::dontSendNotification);
+    else if (verificationResult.ringingMutedStrings != 0)
+        verificationLabel.setText("Mute the strings marked X", juce::dontSendNotification);
+    else
+        verificationLabel.setText("Check the strings marked red", juce::dontSendNotification);
+
+    repaint();
+}
+
+//checks each shared FFT frame against the chord, frames the energy gate skipped count as quiet
+//the registry hands every reader the largest frame asked for, frames of another size are skipped
+void TabComponent1::process(const AudioFeatures& features)
+{
+    if (!features.frameDue || (features.spectrum != nullptr && features.spectrumSize != chordVerifier.getFFTSize()))
+        return;
+
+    //the UI picks the result up on its next frame, nothing is posted to the message thread
+    if (chordVerifier.processSpectrum(features.spectrum, features.frameRms))
+        latestVerification.publish(chordVerifier.getLatestResult());
+}
+
+//sizes the chord check, the registry sizes its frame from it afterwards
+void TabComponent1::prepare(double sampleRate, int maximumBlockSize)
+{
+    chordVerifier.prepare(sampleRate, maximumBlockSize);
+}
+
+//resource releasing
+void TabComponent1::release()
+{
+    chordVerifier.reset();
+}
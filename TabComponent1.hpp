@@ -1,34 +1,91 @@
 #pragma once
 
 #include "JuceHeader.h"
+#include "AnalysisSnapshot.hpp"
 #include "InfoOverlay.hpp"
+#include "ChordVerifier.hpp"
+#include "AnalyserRegistry.hpp"
+#include "MusicLibrary.hpp"
+#include "VoicingGenerator.hpp"
 
-class TabComponent1 : public juce::Component
+class TabComponent1 : public juce::Component,
+                      public AudioAnalyser
 {
 public:
-    TabComponent1();
+    explicit TabComponent1(const MusicLibrary& chordLibrary);
     ~TabComponent1() override = default;
 
 
     void paint(juce::Graphics& g) override;
     void resized() override;
 
+    //the board is dragged along the neck and double tapped or pinched to zoom between a few
+    //frets and the whole neck
+    void mouseDown(const juce::MouseEvent& e) override;
+    void mouseDrag(const juce::MouseEvent& e) override;
+    void mouseDoubleClick(const juce::MouseEvent& e) override;
+    void mouseWheelMove(const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel) override;
+    void mouseMagnify(const juce::MouseEvent& e, float scaleFactor) override;
+
+    //AudioAnalyser, the chord check reads the registry's spectrum
+    void prepare(double sampleRate, int maximumBlockSize) override;
+    void process(const AudioFeatures& features) override;
+    void release() override;
+    int getSpectrumSize() const override { return chordVerifier.getFFTSize(); }
+    int getSpectrumHopSize() const override { return chordVerifier.getHopSize(); }
+
 private:
     
     void loadChord();
+    void loadVoicing();
+    static juce::String describeShape(const std::array<int, MusicLibrary::numStrings>& frets);
+    void refreshFromAnalysis();
+
+    //fretboard geometry and the cached drawing of everything that doesn't change between repaints
+    void setVisibleFrets(int firstFret, int numFrets);
+    int getFretWidth() const;
+    static float getStringY(int stringIndex);
+    void renderBoard(float scale);
+    void renderFret(float scale);
 
     // UI components
     juce::Label chordLabel;
+    juce::Label verificationLabel;
     juce::ComboBox chordComboBox;
+    juce::ComboBox voicingComboBox;
     InfoOverlay infoOverlay;
     juce::TextButton infoButton;
 
+    const MusicLibrary& library;
+
+    //alternative voicings of the selected chord, the library's shape first
+    VoicingGenerator voicingGenerator;
+    std::vector<std::array<int, MusicLibrary::numStrings>> voicingChoices;
+
+    int firstFretShown = 1;
+    int fretsShown = 4;
+    int dragStartFret = 1;
+    float pinchFretsShown = 4.0f;   //zoom while pinching, rounded to whole frets
+
+    //the static fretboard, drawn once per size and display scale, paint copies it and draws the
+    //fingers over the top
+    juce::Image boardImage;   //background and strings across the whole component
+    juce::Image fretImage;    //one fret wire and the strings up to the next, tiled along the visible frets
+    float imageScale = 0.0f;
+
     // Chord positions
     std::vector<std::pair<int, int>> currentChordPositions;
     std::vector<int> mutedStrings; 
+
+    //listens to the strum and checks it against the selected chord
+    ChordVerifier chordVerifier;
+    AnalysisSnapshot<ChordVerifier::Result> latestVerification;   //handed from the audio thread to the UI
+    ChordVerifier::Result verificationResult;  //last result, message thread only
     
     void toggleInfoOverlay();
-    
+
+    //pulls the chord check once per display frame, last so it is destroyed first
+    juce::VBlankAttachment analysisRefresh { this, [this]() { refreshFromAnalysis(); } };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TabComponent1)
 };
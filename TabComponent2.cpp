@@ -1,6 +1,31 @@
 #include "TabComponent2.hpp"
+#include "NoteMapping.hpp"
 
-TabComponent2::TabComponent2()
+namespace
+{
+    //1st, 2nd, 3rd, 4th... for the string and fret in the instructions
+    juce::String ordinal(int number)
+    {
+        const int lastTwoDigits = number % 100;
+        const char* suffix = "th";
+
+        if (lastTwoDigits < 11 || lastTwoDigits > 13)
+        {
+            switch (number % 10)
+            {
+                case 1: suffix = "st"; break;
+                case 2: suffix = "nd"; break;
+                case 3: suffix = "rd"; break;
+                default: break;
+            }
+        }
+
+        return juce::String(number) + suffix;
+    }
+}
+
+TabComponent2::TabComponent2(const MusicLibrary& scaleLibrary)
+    : library(scaleLibrary)
 {
     //set up UI components
     addAndMakeVisible(noteLabel);
@@ -27,13 +52,14 @@ TabComponent2::TabComponent2()
     addAndMakeVisible(infoOverlay);
     infoOverlay.setVisible(false);
     
-    //combobox control for scales
+    //combobox control for scales, one item per scale in the library in the order it lists them
     addAndMakeVisible(scaleComboBox);
-    scaleComboBox.addItem("C Major", 1);
-    scaleComboBox.addItem("A Minor", 2);
-    scaleComboBox.addItem("C Major Pentatonic", 3);
-    scaleComboBox.addItem("A Minor Pentatonic", 4);
-    scaleComboBox.addItem("E Blues", 5);
+    for (int position = 0; position < library.getNumScales(); ++position)
+    {
+        const int scaleIndex = library.getScaleInDisplayOrder(position);
+        if (scaleIndex >= 0)
+            scaleComboBox.addItem(library.getScale(scaleIndex).name, scaleIndex + 1);
+    }
     scaleComboBox.setJustificationType(juce::Justification::centred);
     scaleComboBox.onChange = [this]() { loadScale(); };  //load the selected scale
 
@@ -42,15 +68,13 @@ TabComponent2::TabComponent2()
     resetButton.onClick = [this]() { resetChallenge(); };
 
     //Variables
-    lastFrequency = 0.0f;
     currentNoteIndex = 0;
     isCorrectNote = false;
-    stabilityCounter = 0;
-    requiredStabilityCount = 15;  //number of frames for stability
 }
 
 TabComponent2::~TabComponent2()
 {
+    pitchAnalysis.stop();
 }
 
 //resizes UI components
@@ -83,85 +107,60 @@ void TabComponent2::paint(juce::Graphics& g)
     g.fillAll(juce::Colour::fromRGB(240, 230, 200));
 }
 
-//starts yin processor initializer
-void TabComponent2::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+//restarts the pitch analysis thread for the new device settings
+void TabComponent2::prepare(double sampleRate, int maximumBlockSize)
 {
-    yinProcessor.initialize(sampleRate, samplesPerBlockExpected);
+    pitchAnalysis.stop();
+    pitchAnalysis.prepare(sampleRate, maximumBlockSize);
+    gateWasOpen = false;
+    pitchAnalysis.start();
 }
 
-//audio processing for note detection from YINAudioComponent
-void TabComponent2::processAudioBuffer(const juce::AudioSourceChannelInfo& bufferToFill)
+//audio processing for note detection
+//the registry has already downmixed the block, it is analysed on the pitch analysis thread
+//while the energy gate is closed nothing is pushed and the thread sleeps, when it closes the thread
+//is told the input stopped so the note ends there and the window starts afresh once it opens
+void TabComponent2::process(const AudioFeatures& features)
 {
-    //checks buffers
-    if (bufferToFill.buffer != nullptr && bufferToFill.buffer->getNumChannels() > 0)
-    {
-        //audio sample loop
-        for (int sample = 0; sample < bufferToFill.buffer->getNumSamples(); ++sample)
-        {
-            float sum = 0.0f;
-            //averages signal for mono processing
-            for (int channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
-                sum += bufferToFill.buffer->getReadPointer(channel)[sample];
-
-            float monoSample = sum / bufferToFill.buffer->getNumChannels();
-            
-            //feeding mono sample into yin processor
-            float detectedPitch = yinProcessor.processAudioBuffer(&monoSample, 1);
-
-            //calls checkNoteInScale function for the detected pitch
-            if (detectedPitch > 0.0f)
-            {
-                juce::MessageManager::callAsync([this, detectedPitch]()
-                {
-                    checkNoteInScale(detectedPitch);
-                });
-            }
-        }
-    }
+    if (features.gateOpen)
+        pitchAnalysis.pushSamples(features.mono, features.numSamples, features.startSample);
+    else if (gateWasOpen)
+        pitchAnalysis.pushInputStopped();
+
+    gateWasOpen = features.gateOpen;
 }
 
-//takes the detected pitch and matches it to the correct note
-//returns note plus the octave
-juce::String TabComponent2::getNoteNameFromFrequencyWithTolerance(float frequency)
+//runs once per display frame, shows the note sounding now and calls checkNoteInScale for each
+//note the analysis thread has settled on since the last frame
+//the analysis is only read here, nothing waits on or is posted from the analysis thread
+void TabComponent2::refreshFromAnalysis()
 {
-    static const std::array<juce::String, 12> noteNames = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
-    //reference pitch
-    const float referenceA4 = 440.0f;
-    //frequency tolerance for detected pitches
-    const float tolerance = 5.0f;
-
-    //converts frequency to MIDI note
-    int midiNote = static_cast<int>(std::round(12.0f * std::log2(frequency / referenceA4))) + 69;
-    //finds octave
-    int octave = midiNote / 12 - 1;
-    //maps note name to the MIDI note
-    juce::String noteName = noteNames[midiNote % 12];
-    //checks note for closest frequency to MIDI note
-    float closestNoteFrequency = referenceA4 * std::pow(2.0f, (midiNote - 69) / 12.0f);
-
-    //applies tollerence and returns note name and octave
-    if (std::abs(frequency - closestNoteFrequency) <= tolerance)
-    {
-        return noteName + juce::String(octave);
-    }
-    else
+    PitchAnalysisThread::Result result;
+    if (pitchAnalysis.readLatestResult(result) && result.midiNote >= 0 && isShowing())
+        updateNoteUI("Detected: " + NoteMapping::getNoteNameForMidiNote(result.midiNote));
+
+    std::array<NoteEvent, 16> events;
+    int numEvents = pitchAnalysis.popNoteEvents(events.data(), static_cast<int>(events.size()));
+
+    while (numEvents > 0)
     {
-        return "Unknown";
+        //the analysis keeps running behind other tabs, the challenge only moves while it is shown
+        for (int i = 0; i < numEvents && isShowing(); ++i)
+            if (events[static_cast<size_t>(i)].type != NoteEvent::Type::noteOff)
+                checkNoteInScale(events[static_cast<size_t>(i)].midiNote);
+
+        numEvents = pitchAnalysis.popNoteEvents(events.data(), static_cast<int>(events.size()));
     }
 }
 
-//checks if the detected pitch corresponds to the correct note
-void TabComponent2::checkNoteInScale(float frequency)
+//checks if the detected note is the one the challenge is waiting for
+void TabComponent2::checkNoteInScale(int midiNote)
 {
-    //updates UI with detected note
-    juce::String detectedNote = getNoteNameFromFrequencyWithTolerance(frequency);
-    updateNoteUI("Detected: " + detectedNote);
-
     //checks if there are further notes in the scale
     if (currentNoteIndex >= currentScaleNotes.size()) return;
 
     //cheks if the notes match and calls move to next note if true
-    if (detectedNote == currentRequiredNote)
+    if (midiNote == currentRequiredNote)
     {
         isCorrectNote = true;
         moveToNextNote();
@@ -196,6 +195,7 @@ void TabComponent2::moveToNextNote()
         
             //updates the UI to show the scale is complete
             scaleCompleted = true;
+            updateAnalysisTargets();
             showMessageWithDelay("Scale completed!", 4000, [this]()
             {
                 updateStatusUI("");
@@ -203,30 +203,17 @@ void TabComponent2::moveToNextNote()
         }
 }
 
-//UI update for detected note
+//UI update for detected note, message thread only
+//the label repaints itself and only when the text changes
 void TabComponent2::updateNoteUI(const juce::String& message)
 {
-    if (noteLabel.getText() != message)
-    {
-        juce::MessageManager::callAsync([this, message]()
-        {
-            noteLabel.setText(message, juce::dontSendNotification);
-            repaint();
-        });
-    }
+    noteLabel.setText(message, juce::dontSendNotification);
 }
 
-//UI update for status
+//UI update for status, message thread only
 void TabComponent2::updateStatusUI(const juce::String& message)
 {
-    if (statusLabel.getText() != message)
-    {
-        juce::MessageManager::callAsync([this, message]()
-        {
-            statusLabel.setText(message, juce::dontSendNotification);
-            repaint();
-        });
-    }
+    statusLabel.setText(message, juce::dontSendNotification);
 }
 
 //Reset the scale challenge
@@ -244,86 +231,39 @@ void TabComponent2::resetChallenge()
 }
 
 //handles the loading of the scales with relevent information about the scale
-//add more scales here //////
+//the notes and their fingering come from the library
 void TabComponent2::loadScale()
 {
-    stringAndFret.clear();
     currentScaleNotes.clear();
     currentNoteIndex = 0;
+    scaleCompleted = false;
 
-    switch (scaleComboBox.getSelectedId())
-    {
-        case 1: // C Major Scale
-            currentScaleNotes = { "C3", "D3", "E3", "F3", "G3", "A3", "B3" };
-            stringAndFret = {
-                {"5th string", "3rd fret"}, // C3
-                {"4th string", "open"},     // D3
-                {"4th string", "2nd fret"}, // E3
-                {"4th string", "3rd fret"}, // F3
-                {"3rd string", "open"},     // G3
-                {"3rd string", "2nd fret"}, // A3
-                {"2nd string", "open"}      // B3
-            };
-            break;
-            
-        case 2: // A Minor Scale
-            currentScaleNotes = { "A2", "B2", "C3", "D3", "E3", "F3", "G3" };
-            stringAndFret = {
-                {"5th string", "open"},     // A2
-                {"5th string", "2nd fret"}, // B2
-                {"5th string", "3rd fret"}, // C3
-                {"4th string", "open"},     // D3
-                {"4th string", "2nd fret"}, // E3
-                {"4th string", "3rd fret"}, // F3
-                {"3rd string", "open"}      // G3
-            };
-            break;
-
-        case 3: // C Major Pentatonic Scale
-            currentScaleNotes = { "C3", "D3", "E3", "G3", "A3" };
-            stringAndFret = {
-                {"5th string", "3rd fret"}, // C3
-                {"4th string", "open"},     // D3
-                {"4th string", "2nd fret"}, // E3
-                {"3rd string", "open"},     // G3
-                {"3rd string", "2nd fret"}  // A3
-            };
-            break;
-
-        case 4: // A Minor Pentatonic Scale
-            currentScaleNotes = { "A2", "C3", "D3", "E3", "G3" };
-            stringAndFret = {
-                {"5th string", "open"},     // A2
-                {"5th string", "3rd fret"}, // C3
-                {"4th string", "open"},     // D3
-                {"4th string", "2nd fret"}, // E3
-                {"3rd string", "open"}      // G3
-            };
-            break;
-
-        case 5: // E Blues Scale
-            currentScaleNotes = { "E2", "G2", "A2", "A#2", "B2", "D3" };
-            stringAndFret = {
-                {"6th string", "open"},     // E2
-                {"6th string", "3rd fret"}, // G2
-                {"5th string", "open"},     // A2
-                {"5th string", "1st fret"}, // A#2
-                {"5th string", "2nd fret"}, // B2
-                {"4th string", "open"}      // D3
-            };
-            break;
-
-        default:
-            currentScaleNotes.clear();
-            stringAndFret.clear();
-            break;
-    }
+    currentScale = library.getScale(scaleComboBox.getSelectedId() - 1);
+
+    for (int i = 0; i < currentScale.numNotes; ++i)
+        currentScaleNotes.push_back(library.getScaleNote(currentScale, i).midiNote);
 
     if (!currentScaleNotes.empty())
     {
         currentRequiredNote = currentScaleNotes[currentNoteIndex];
         updateRequiredNote();
     }
+
+    updateAnalysisTargets();
+}
+
+//restricts the pitch detector to the notes of the scale while the challenge runs
+//only those lags and their octaves are searched, a small part of the full search
+//with no scale selected or the scale completed every note is searched again
+void TabComponent2::updateAnalysisTargets()
+{
+    std::vector<float> frequencies;
+
+    if (scaleComboBox.getSelectedId() > 0 && !scaleCompleted)
+        for (int midiNote : currentScaleNotes)
+            frequencies.push_back(NoteMapping::getFrequencyForMidiNote(midiNote));
+
+    pitchAnalysis.setTargetFrequencies(frequencies);
 }
 
 // Updates the required note on the UI
@@ -331,8 +271,11 @@ void TabComponent2::updateRequiredNote()
 {
     if (currentNoteIndex < currentScaleNotes.size())
     {
+        const auto fingering = library.getScaleNote(currentScale, currentNoteIndex);
+
         requiredNoteLabel.setText(
-            "Play: " + currentRequiredNote + " on " + stringAndFret[currentNoteIndex].first + " at " + stringAndFret[currentNoteIndex].second,
+            "Play: " + NoteMapping::getNoteNameForMidiNote(currentRequiredNote) + " on " + ordinal(fingering.stringNumber) + " string at "
+                + (fingering.fret == 0 ? juce::String("open") : ordinal(fingering.fret) + " fret"),
             juce::dontSendNotification
         );
         repaint();  // Repaint when the required note changes
@@ -361,7 +304,8 @@ void TabComponent2::showMessageWithDelay(const juce::String& message, int delay,
     juce::Timer::callAfterDelay(delay, [callback]() { callback(); });
 }
 
-void TabComponent2::releaseResources()
+//stops the analysis thread with the audio device
+void TabComponent2::release()
 {
-
+    pitchAnalysis.stop();
 }
@@ -1,21 +1,26 @@
 #pragma once
 
 #include "JuceHeader.h"
-#include "YINAudioComponent.hpp"
+#include "PitchAnalysisThread.hpp"
+#include "AnalyserRegistry.hpp"
 #include "InfoOverlay.hpp"
+#include "MusicLibrary.hpp"
 
-class TabComponent2 : public juce::Component
+class TabComponent2 : public juce::Component,
+                      public AudioAnalyser
 {
 public:
-    TabComponent2();
+    explicit TabComponent2(const MusicLibrary& scaleLibrary);
     ~TabComponent2() override;
 
     void resized() override;
     void paint(juce::Graphics& g) override;
 
 
-    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
-    void processAudioBuffer(const juce::AudioSourceChannelInfo& bufferToFill);
+    //AudioAnalyser, the shared mono downmix goes to the pitch analysis thread
+    void prepare(double sampleRate, int maximumBlockSize) override;
+    void process(const AudioFeatures& features) override;
+    void release() override;
 
 
     void updateNoteUI(const juce::String& message);
@@ -23,8 +28,6 @@ public:
 
 
     void resetChallenge();
-    
-    void releaseResources();
 
 private:
 
@@ -35,10 +38,10 @@ private:
     juce::Label statusLabel;
 
 
-    YINAudioComponent yinProcessor;
-    float lastFrequency;
+    PitchAnalysisThread pitchAnalysis;
+    bool gateWasOpen = false;   //audio thread, state of the energy gate on the last block
     juce::String currentNote;
-    juce::String currentRequiredNote;
+    int currentRequiredNote = -1;   //MIDI note
     int currentNoteIndex;
     bool isCorrectNote;
     bool scaleCompleted;
@@ -46,23 +49,23 @@ private:
     InfoOverlay infoOverlay;
     juce::TextButton infoButton;
 
-    std::vector<juce::String> currentScaleNotes;
-    std::vector<std::pair<juce::String, juce::String>> stringAndFret;
-
-    int stabilityCounter;
-    int requiredStabilityCount;
-
+    const MusicLibrary& library;
+    MusicLibrary::Scale currentScale;
+    std::vector<int> currentScaleNotes;   //MIDI notes in the order they are played
 
-    juce::String getNoteNameFromFrequencyWithTolerance(float frequency);
-
-    void checkNoteInScale(float frequency);
+    void checkNoteInScale(int midiNote);
     void loadScale();
     void updateRequiredNote();
+    void updateAnalysisTargets();
     void moveToNextNote();
     void toggleInfoOverlay();
+    void refreshFromAnalysis();
 
     void placeComponent(juce::Component& comp, juce::Rectangle<int>& area, int height, int spacing);
     void showMessageWithDelay(const juce::String& message, int delay, std::function<void()> callback);
 
+    //pulls the analysis once per display frame, last so it is destroyed first
+    juce::VBlankAttachment analysisRefresh { this, [this]() { refreshFromAnalysis(); } };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TabComponent2)
 };
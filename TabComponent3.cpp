@@ -1,15 +1,6 @@
 #include "TabComponent3.hpp"
 
 
-const float minMagnitudeThreshold = 0.07f;     //minimum input magnitude for signal detection
-const float debounceDelayMs = 300;             //minimum delay between valid peaks
-const int maxTapTimesSize = 6;                 //maximum number of peaks stored in buffer
-const float initialSmoothingFactor = 0.1f;     //smoothing factor
-const float aggressiveSmoothingFactor = 0.3f;  //higher smoothing factor for large tempo shifts
-const float dynamicThresholdDecay = 0.98f;     //decay rate for dynamic threshold
-const float thresholdScaling = 0.7f;           //scaling for dynamic threshold
-
-
 //constructor
 TabComponent3::TabComponent3()
 {
@@ -67,7 +58,7 @@ void TabComponent3::resized()
 //UI with reaction to tempo matching
 void TabComponent3::paint(juce::Graphics& g)
 {
-    float deviationFactor = std::abs(currentTempo - detectedTempo) / (detectedTempo * 0.1f);
+    float deviationFactor = std::abs(displayedTempo - detectedTempo) / (detectedTempo * 0.1f);
     deviationFactor = juce::jlimit(0.0f, 1.0f, deviationFactor);
 
     juce::Colour backgroundColour = juce::Colours::red.interpolatedWith(juce::Colours::green, 1.0f - deviationFactor);
@@ -79,6 +70,7 @@ void TabComponent3::paint(juce::Graphics& g)
 void TabComponent3::setManualTempo()
 {
     detectedTempo = tempoSlider.getValue();
+    tempoDetector.setTargetTempo(detectedTempo);
     setTempoLabel.setText("Set Tempo: " + juce::String(detectedTempo, 2) + " BPM", juce::dontSendNotification);
     repaint();
 }
@@ -99,108 +91,31 @@ void TabComponent3::toggleInfoOverlay()
 }
 
 
-//peak detection and tempo calculation
-void TabComponent3::detectTempoFromPeaks(float magnitude)
+//UI update for the detected tempo, runs once per display frame and repaints only when the tempo changed
+void TabComponent3::refreshFromAnalysis()
 {
-    adjustThreshold(magnitude);
-    //current time
-    auto now = std::chrono::steady_clock::now();
-
-    //peak detection
-    //checks for threshold and previous peaks
-    if (magnitude > dynamicThreshold && magnitude > previousMagnitude &&
-        std::chrono::duration_cast<std::chrono::milliseconds>(now - lastPeakTime).count() > debounceDelayMs)
-    {
-        lastPeakTime = now;
-
-        //stores the last peak time, erasing old peaks to maintain buffer
-        tapTimes.push_back(now);
-        if (tapTimes.size() > maxTapTimesSize)
-            tapTimes.erase(tapTimes.begin());
-
-        //tempo calculation with at least 2 peaks
-        if (tapTimes.size() >= 2)
-        {
-            double totalDuration = 0.0;
-            for (size_t i = 1; i < tapTimes.size(); ++i)
-            {
-                //time between peaks
-                totalDuration += std::chrono::duration_cast<std::chrono::milliseconds>(tapTimes[i] - tapTimes[i - 1]).count();
-            }
-            
-            //averages time between peaks
-            double averageDuration = totalDuration / (tapTimes.size() - 1);
-            //conversion to bpm
-            float newTempo = 60000.0 / averageDuration;
-
-            //smooths detected tempo
-            float smoothingFactor = std::abs(currentTempo - newTempo) > 20.0f ? aggressiveSmoothingFactor : initialSmoothingFactor;
-            currentTempo = smoothingFactor * newTempo + (1.0f - smoothingFactor) * currentTempo;
-
-            //updates UI with detected tempo
-            juce::MessageManager::callAsync([this]() {
-                detectedTempoLabel.setText("Detected Tempo: " + juce::String(currentTempo, 2) + " BPM", juce::dontSendNotification);
-                repaint();
-            });
-        }
-    }
+    const float tempo = latestTempo.load(std::memory_order_relaxed);
 
-    previousMagnitude = magnitude;
-}
+    if (tempo == displayedTempo)
+        return;
 
-//dynamic threshold implementation
-void TabComponent3::adjustThreshold(float magnitude)
-{
-    //smoothing applied to the threshold sdjustments
-    float smoothingFactor = std::abs(currentTempo - detectedTempo) > 20.0f ? aggressiveSmoothingFactor : initialSmoothingFactor;
-    //average of magnitudes calculated
-    static float runningAverage = 0.0f;
-    runningAverage = smoothingFactor * magnitude + (1.0f - smoothingFactor) * runningAverage;
-    
-    //dynamic threshold calculated
-    dynamicThreshold = std::max(dynamicThreshold * dynamicThresholdDecay, runningAverage * thresholdScaling);
+    displayedTempo = tempo;
+    detectedTempoLabel.setText("Detected Tempo: " + juce::String(displayedTempo, 2) + " BPM", juce::dontSendNotification);
+    repaint();
 }
 
-
-//audio processing buffer
-void TabComponent3::processAudioBuffer(const juce::AudioSourceChannelInfo& bufferToFill)
+//onsets are timed by their sample position within the stream
+void TabComponent3::process(const AudioFeatures& features)
 {
-    //buffer check
-    if (bufferToFill.buffer != nullptr && bufferToFill.buffer->getNumChannels() > 0)
+    if (tempoDetector.processBlock(features.mono, features.numSamples))
     {
-        float magnitude = 0.0f;
-        auto numChannels = bufferToFill.buffer->getNumChannels();
-        auto numSamples = bufferToFill.buffer->getNumSamples();
-
-        
-        for (int channel = 0; channel < numChannels; ++channel)
-        {
-            auto* samples = bufferToFill.buffer->getReadPointer(channel);
-            for (int sample = 0; sample < numSamples; ++sample)
-            {
-                magnitude += std::abs(samples[sample]);
-            }
-        }
-
-        //magnitude calculation with smoothing
-        magnitude /= (numChannels * numSamples);
-
-        
-        if (magnitude > minMagnitudeThreshold)
-        {
-            smoothedMagnitude = 0.1f * magnitude + 0.9f * smoothedMagnitude;
-            detectTempoFromPeaks(smoothedMagnitude);
-        }
+        //the UI picks the tempo up on its next frame, the label text is built on the message thread
+        latestTempo.store(static_cast<float>(tempoDetector.getCurrentTempo()), std::memory_order_relaxed);
     }
 }
 
 //sets sample rate
-void TabComponent3::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
-{
-    this->sampleRate = static_cast<int>(sampleRate);
-}
-
-//resource releasing 
-void TabComponent3::releaseResources()
+void TabComponent3::prepare(double sampleRate, int maximumBlockSize)
 {
+    tempoDetector.prepare(sampleRate, maximumBlockSize);
 }
@@ -2,10 +2,12 @@
 
 #include "JuceHeader.h"
 #include "InfoOverlay.hpp"
-#include <chrono>
-#include <vector>
+#include "TempoDetector.hpp"
+#include "AnalyserRegistry.hpp"
+#include <atomic>
 
-class TabComponent3 : public juce::Component
+class TabComponent3 : public juce::Component,
+                      public AudioAnalyser
 {
 public:
     TabComponent3();
@@ -14,9 +16,9 @@ public:
     void paint(juce::Graphics& g) override;
     void resized() override;
 
-    void processAudioBuffer(const juce::AudioSourceChannelInfo& bufferToFill);
-    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
-    void releaseResources();
+    //AudioAnalyser, onsets and tempo from the shared mono downmix
+    void prepare(double sampleRate, int maximumBlockSize) override;
+    void process(const AudioFeatures& features) override;
 
 private:
     //UI
@@ -25,26 +27,22 @@ private:
     juce::Slider tempoSlider;
 
     //tempo
-    std::vector<std::chrono::steady_clock::time_point> tapTimes;
+    TempoDetector tempoDetector;
     double detectedTempo { 120.0 };
-    double currentTempo { 0.0 };
-    float dynamicThreshold { 0.05f };
-    float smoothedMagnitude { 0.0f };
-    float previousMagnitude { 0.0f };
-    int sampleRate { 44100 };
+    std::atomic<float> latestTempo { 0.0f };     //tempo handed from the audio thread to the UI
+    float displayedTempo { 0.0f };               //message thread
     
     //info button
     InfoOverlay infoOverlay;
     juce::TextButton infoButton;
 
-
-    std::chrono::steady_clock::time_point lastPeakTime;
-
     void setManualTempo();
-    void detectTempoFromPeaks(float magnitude);
-    void adjustThreshold(float magnitude);
+    void refreshFromAnalysis();
     
     void toggleInfoOverlay();
 
+    //pulls the tempo once per display frame, last so it is destroyed first
+    juce::VBlankAttachment analysisRefresh { this, [this]() { refreshFromAnalysis(); } };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TabComponent3)
 };
@@ -0,0 +1,78 @@
+#include "TempoDetector.hpp"
+
+const double minimumTempo = 40.0;          //tempo range searched, matches the Tempo tab slider
+const double maximumTempo = 240.0;
+const float minimumTempoConfidence = 0.5f; //tempogram confidence needed before the tempo is shown, irregular playing stays below it
+
+
+//sets sample rate and sizes the onset detector and tempogram
+void TempoDetector::prepare(double sampleRate, int samplesPerBlockExpected)
+{
+    this->sampleRate = sampleRate;
+    onsetDetector.prepare(sampleRate, samplesPerBlockExpected);
+    tempogram.prepare(sampleRate / onsetDetector.getHopSize(), minimumTempo, maximumTempo);
+    reset();
+}
+
+//clears the detection state
+void TempoDetector::reset()
+{
+    onsetDetector.reset();
+    tempogram.reset();
+    numBlockOnsets = 0;
+    currentTempo = 0.0;
+}
+
+//the block is sliced at detection hop boundaries so every hop's onset strength reaches the tempogram
+template <typename AnalyseSlice>
+bool TempoDetector::processSlices(int numSamples, AnalyseSlice&& analyseSlice)
+{
+    int offset = 0;
+    while (offset < numSamples)
+    {
+        const int samplesUntilHop = onsetDetector.getSamplesUntilNextHop();
+        const int sliceSize = juce::jmin(numSamples - offset, samplesUntilHop);
+
+        const int numOnsets = analyseSlice(offset, sliceSize);
+        offset += sliceSize;
+
+        for (int i = 0; i < numOnsets && numBlockOnsets < OnsetDetector::maxOnsetsPerBlock; ++i)
+            blockOnsets[static_cast<size_t>(numBlockOnsets++)] = onsetDetector.getOnsetSample(i);
+
+        if (sliceSize == samplesUntilHop)
+            tempogram.addFrame(onsetDetector.getOnsetStrength());
+    }
+
+    //the period is picked once per block, the tempo holds while the envelope is not periodic enough
+    tempogram.update();
+    if (tempogram.getConfidence() >= minimumTempoConfidence)
+        currentTempo = tempogram.getTempo();
+
+    return numBlockOnsets > 0 && currentTempo > 0.0;
+}
+
+bool TempoDetector::processBlock(const float* const* channels, int numChannels, int startSample, int numSamples)
+{
+    numBlockOnsets = 0;
+
+    if (channels == nullptr || numChannels <= 0 || numSamples <= 0)
+        return false;
+
+    return processSlices(numSamples, [&](int offset, int sliceSize)
+    {
+        return onsetDetector.processBlock(channels, numChannels, startSample + offset, sliceSize);
+    });
+}
+
+bool TempoDetector::processBlock(const float* samples, int numSamples)
+{
+    numBlockOnsets = 0;
+
+    if (samples == nullptr || numSamples <= 0)
+        return false;
+
+    return processSlices(numSamples, [&](int offset, int sliceSize)
+    {
+        return onsetDetector.processBlock(samples + offset, sliceSize);
+    });
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <juce_core/juce_core.h>
+#include "OnsetDetector.hpp"
+#include "Tempogram.hpp"
+
+//onset based tempo detection used by the Tempo tab and the batch analyser
+//works on raw channel pointers so it has no dependency on the GUI
+//the onset strength of every detection hop feeds a tempogram, the tempo is the period the
+//strength envelope repeats at, and onsets are reported by sample position
+class TempoDetector
+{
+public:
+    TempoDetector() = default;
+
+    void prepare(double sampleRate, int samplesPerBlockExpected);
+    void reset();
+
+    //runs onset detection over the block and updates the tempogram hop by hop
+    //returns true when the block held an onset and the tempo estimate is confident
+    bool processBlock(const float* const* channels, int numChannels, int startSample, int numSamples);
+
+    //the same for a block that is already mono, the registry's downmix is used without another copy
+    bool processBlock(const float* samples, int numSamples);
+
+    //tempo the player is aiming for, sets the onset refractory period, safe from the message thread
+    void setTargetTempo(double bpm) { onsetDetector.setTargetTempo(bpm); }
+
+    double getCurrentTempo() const { return currentTempo; }
+    float getConfidence() const { return tempogram.getConfidence(); }
+    bool wasPeakDetected() const { return numBlockOnsets > 0; }
+
+    //onsets found by the last processBlock call, as sample positions since prepare or reset
+    int getNumOnsets() const { return numBlockOnsets; }
+    juce::int64 getOnsetSample(int index) const { return blockOnsets[static_cast<size_t>(index)]; }
+
+private:
+    template <typename AnalyseSlice>
+    bool processSlices(int numSamples, AnalyseSlice&& analyseSlice);
+
+    OnsetDetector onsetDetector;
+    Tempogram tempogram;
+
+    std::array<juce::int64, OnsetDetector::maxOnsetsPerBlock> blockOnsets {};
+    int numBlockOnsets { 0 };
+
+    double currentTempo { 0.0 };
+    double sampleRate { 44100.0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TempoDetector)
+};
@@ -0,0 +1,246 @@
+#include "Tempogram.hpp"
+#include <cmath>
+
+const double memorySeconds = 4.0;        //time constant of the autocorrelation, about eight beats at 120 BPM
+const float subharmonicRatio = 0.7f;     //a shorter period is taken when it repeats at least this strongly
+const int maxPeriodDivisor = 4;          //shortest period tried is a quarter of the strongest one
+const int peakSearchRadius = 2;          //lags searched either side of a divided period
+const double smoothingSeconds = 0.02;    //envelope low pass so onsets a frame apart still correlate
+const float maximumStrength = 1.0f;      //an attack out of silence rises by many decades, capped so it does not outweigh the beats after it
+const float minimumEnergy = 1.0e-9f;     //envelope energy below this is silence
+
+
+//sizes the envelope ring and the lag range for the envelope frame rate
+void Tempogram::prepare(double newFrameRate, double minimumTempo, double maximumTempo)
+{
+    frameRate = newFrameRate > 0.0 ? newFrameRate : 375.0;
+    minimumLag = juce::jmax(2, static_cast<int>(std::floor(frameRate * 60.0 / maximumTempo)));
+    maximumLag = juce::jmax(minimumLag + 1, static_cast<int>(std::ceil(frameRate * 60.0 / minimumTempo)));
+    decay = static_cast<float>(std::exp(-1.0 / (frameRate * memorySeconds)));
+    smoothing = static_cast<float>(std::exp(-1.0 / (frameRate * smoothingSeconds)));
+
+    //one lag either side of the range is kept for the parabolic refinement
+    envelope.assign(static_cast<size_t>(maximumLag) + 2, 0.0f);
+    autocorrelation.assign(static_cast<size_t>(maximumLag) + 2, 0.0f);
+
+    reset();
+}
+
+//clears the envelope and the autocorrelation
+void Tempogram::reset()
+{
+    std::fill(envelope.begin(), envelope.end(), 0.0f);
+    std::fill(autocorrelation.begin(), autocorrelation.end(), 0.0f);
+    writePosition = 0;
+    framesAdded = 0;
+    envelopeMean = 0.0f;
+    smoothedStrength = 0.0f;
+    tempo = 0.0;
+    confidence = 0.0f;
+}
+
+//the envelope is smoothed so the lag of two onsets is not tied to a single frame,
+//then its mean is removed so a steady level does not correlate at every lag
+void Tempogram::addFrame(float strength)
+{
+    if (envelope.empty())
+        return;
+
+    smoothedStrength += (1.0f - smoothing) * (juce::jlimit(0.0f, maximumStrength, strength) - smoothedStrength);
+    envelopeMean += (1.0f - decay) * (smoothedStrength - envelopeMean);
+    const float value = smoothedStrength - envelopeMean;
+    envelope[static_cast<size_t>(writePosition)] = value;
+
+    autocorrelation[0] = decay * autocorrelation[0] + value * value;
+
+    const int size = static_cast<int>(envelope.size());
+    int readPosition = writePosition - (minimumLag - 1);
+    if (readPosition < 0)
+        readPosition += size;
+
+    for (int lag = minimumLag - 1; lag <= maximumLag + 1; ++lag)
+    {
+        autocorrelation[static_cast<size_t>(lag)] = decay * autocorrelation[static_cast<size_t>(lag)] + value * envelope[static_cast<size_t>(readPosition)];
+        if (--readPosition < 0)
+            readPosition += size;
+    }
+
+    writePosition = (writePosition + 1) % size;
+    ++framesAdded;
+}
+
+//strongest period in the range, moved down to the shortest period that repeats almost as
+//strongly because a pulse train also correlates at every multiple of its beat
+void Tempogram::update()
+{
+    tempo = 0.0;
+    confidence = 0.0f;
+
+    if (autocorrelation.empty() || autocorrelation[0] < minimumEnergy || framesAdded < 2 * minimumLag)
+        return;
+
+    const float energy = autocorrelation[0];
+
+    int bestLag = minimumLag;
+    for (int lag = minimumLag + 1; lag <= maximumLag; ++lag)
+        if (autocorrelation[static_cast<size_t>(lag)] > autocorrelation[static_cast<size_t>(bestLag)])
+            bestLag = lag;
+
+    const float bestValue = autocorrelation[static_cast<size_t>(bestLag)];
+    if (bestValue <= 0.0f)
+        return;
+
+    for (int divisor = maxPeriodDivisor; divisor >= 2; --divisor)
+    {
+        const int centreLag = static_cast<int>(std::lround(static_cast<double>(bestLag) / divisor));
+        if (centreLag < minimumLag)
+            continue;
+
+        int peakLag = centreLag;
+        if (findLocalPeak(centreLag, peakLag) >= subharmonicRatio * bestValue)
+        {
+            bestLag = peakLag;
+            break;
+        }
+    }
+
+    //parabolic refinement between neighbouring lags
+    const float before = autocorrelation[static_cast<size_t>(bestLag - 1)];
+    const float centre = autocorrelation[static_cast<size_t>(bestLag)];
+    const float after = autocorrelation[static_cast<size_t>(bestLag + 1)];
+    const float curvature = before - 2.0f * centre + after;
+    const double offset = curvature < 0.0f ? juce::jlimit(-0.5, 0.5, 0.5 * (before - after) / curvature) : 0.0;
+
+    tempo = 60.0 * frameRate / (bestLag + offset);
+    confidence = juce::jlimit(0.0f, 1.0f, centre / energy);
+}
+
+//largest autocorrelation within the search radius of centreLag, kept inside the lag range
+float Tempogram::findLocalPeak(int centreLag, int& peakLag) const
+{
+    const int start = juce::jmax(minimumLag, centreLag - peakSearchRadius);
+    const int end = juce::jmin(maximumLag, centreLag + peakSearchRadius);
+
+    peakLag = start;
+    for (int lag = start + 1; lag <= end; ++lag)
+        if (autocorrelation[static_cast<size_t>(lag)] > autocorrelation[static_cast<size_t>(peakLag)])
+            peakLag = lag;
+
+    return autocorrelation[static_cast<size_t>(peakLag)];
+}
+
+#if JUCE_UNIT_TESTS
+
+#include "SyntheticGuitarSignal.hpp"
+#include "TempoDetector.hpp"
+
+class TempogramTests : public juce::UnitTest
+{
+public:
+    TempogramTests() : juce::UnitTest("Tempogram", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        const double sampleRate = 48000.0;
+        const int blockSize = 512;
+
+        for (double bpm : { 45.0, 120.0, 200.0, 240.0 })
+        {
+            beginTest("Steady plucks at " + juce::String(bpm, 0) + " BPM with one missed");
+
+            const int beatSamples = static_cast<int>(sampleRate * 60.0 / bpm);
+            const int numBeats = 16;
+            std::vector<int> onsets;
+            for (int beat = 0; beat < numBeats; ++beat)
+                if (beat != 6)
+                    onsets.push_back(beat * beatSamples);
+
+            auto input = renderPlucks(sampleRate, onsets, beatSamples * (numBeats + 1));
+
+            TempoDetector detector;
+            detector.prepare(sampleRate, blockSize);
+            detector.setTargetTempo(bpm);
+
+            //locked from the fourth beat, three intervals in, and held through the missed one
+            int lockedBlocks = 0, blocksFromFourthBeat = 0;
+            const float* channels[] = { input.data() };
+            for (int start = 0; start + blockSize <= static_cast<int>(input.size()); start += blockSize)
+            {
+                detector.processBlock(channels, 1, start, blockSize);
+
+                if (start >= 3 * beatSamples)
+                {
+                    ++blocksFromFourthBeat;
+                    if (std::abs(detector.getCurrentTempo() - bpm) < 0.01 * bpm)
+                        ++lockedBlocks;
+                }
+            }
+
+            expectEquals(lockedBlocks, blocksFromFourthBeat);
+            expectGreaterThan(detector.getConfidence(), 0.7f);
+        }
+
+        beginTest("Irregular plucks give no tempo");
+        {
+            juce::Random random(42);
+            std::vector<int> onsets;
+            for (int i = 0; i < 16; ++i)
+                onsets.push_back(random.nextInt(static_cast<int>(sampleRate * 8.0)));
+
+            auto input = renderPlucks(sampleRate, onsets, static_cast<int>(sampleRate * 9.0));
+
+            TempoDetector detector;
+            detector.prepare(sampleRate, blockSize);
+
+            const float* channels[] = { input.data() };
+            for (int start = 0; start + blockSize <= static_cast<int>(input.size()); start += blockSize)
+                detector.processBlock(channels, 1, start, blockSize);
+
+            expectLessThan(detector.getConfidence(), 0.5f);
+        }
+
+        beginTest("A pulse train picks its own period, not a multiple");
+        {
+            Tempogram tempogram;
+            tempogram.prepare(375.0, 40.0, 240.0);
+
+            //alternating accents make the two beat period correlate more strongly than one beat
+            const double period = 375.0 * 60.0 / 150.0;
+            double nextPulse = 0.0;
+            int pulse = 0;
+            for (int frame = 0; frame < 375 * 8; ++frame)
+            {
+                float strength = 0.0f;
+                if (frame >= nextPulse)
+                {
+                    strength = (pulse++ % 2 == 0) ? 0.6f : 0.35f;
+                    nextPulse += period;
+                }
+                tempogram.addFrame(strength);
+            }
+
+            tempogram.update();
+            expectWithinAbsoluteError(tempogram.getTempo(), 150.0, 1.5);
+        }
+    }
+
+private:
+    static std::vector<float> renderPlucks(double sampleRate, const std::vector<int>& onsets, int totalSamples)
+    {
+        std::vector<float> output(static_cast<size_t>(totalSamples), 0.0f);
+
+        for (size_t i = 0; i < onsets.size(); ++i)
+        {
+            auto pluck = SyntheticGuitarSignal::renderNote(sampleRate, i % 2 == 0 ? 110.0f : 146.83f, 0.4f,
+                                                           totalSamples - onsets[i], static_cast<int>(i) + 1);
+            for (size_t j = 0; j < pluck.size(); ++j)
+                output[static_cast<size_t>(onsets[i]) + j] += pluck[j];
+        }
+
+        return output;
+    }
+};
+
+static TempogramTests tempogramTests;
+
+#endif
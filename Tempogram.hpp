@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <juce_core/juce_core.h>
+
+//tempo estimation from the periodicity of an onset strength envelope
+//each envelope frame updates an exponentially decaying autocorrelation over the lags of the
+//tempo range, so the estimate builds on every beat heard recently rather than a few intervals
+//and a missed strum only weakens it a little
+//all memory is sized in prepare, a frame costs one multiply-add per lag
+class Tempogram
+{
+public:
+    Tempogram() = default;
+
+    //frameRate is envelope frames per second, the tempo range is in BPM
+    void prepare(double frameRate, double minimumTempo, double maximumTempo);
+    void reset();
+
+    //adds one envelope frame to the ring buffer and the autocorrelation
+    void addFrame(float strength);
+
+    //picks the beat period from the autocorrelation, called once per block
+    void update();
+
+    //tempo in BPM, 0 until the first update with enough envelope
+    double getTempo() const { return tempo; }
+
+    //0 to 1, how strongly the envelope repeats at the chosen period
+    float getConfidence() const { return confidence; }
+
+    int getMinimumLag() const { return minimumLag; }
+    int getMaximumLag() const { return maximumLag; }
+
+private:
+    float findLocalPeak(int centreLag, int& peakLag) const;
+
+    std::vector<float> envelope;         //ring of mean removed frames, maximumLag + 2 long, one lag past the range for the refinement
+    std::vector<float> autocorrelation;  //indexed by lag, lag 0 holds the envelope energy
+
+    double frameRate = 375.0;
+    int minimumLag = 1;
+    int maximumLag = 1;
+    int writePosition = 0;
+    juce::int64 framesAdded = 0;
+    float decay = 1.0f;
+    float smoothing = 0.0f;
+    float smoothedStrength = 0.0f;
+    float envelopeMean = 0.0f;
+
+    double tempo = 0.0;
+    float confidence = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Tempogram)
+};
@@ -0,0 +1,324 @@
+#include "ViterbiPitchTracker.hpp"
+#include <cmath>
+
+//transition and observation weights, close to pYIN's
+const float yinTrust = 0.5f;                   //weight of the candidates against the unvoiced state
+const float voicedToUnvoiced = 0.01f;
+const float unvoicedToVoiced = 0.01f;          //shared between every voiced state
+const float noteJumpProbability = 0.002f;      //a voiced state to any other note in one frame, shared the same way
+
+ViterbiPitchTracker::ViterbiPitchTracker()
+{
+    numBins = static_cast<int>(std::ceil(12.0f * binsPerSemitone * std::log2(maxFrequency / minFrequency))) + 1;
+
+    //triangular drift, nearer bins more likely, whatever is left after leaving or jumping
+    float weightSum = 0.0f;
+    for (int distance = -maxStepBins; distance <= maxStepBins; ++distance)
+        weightSum += static_cast<float>(maxStepBins + 1 - std::abs(distance));
+
+    const float driftProbability = 1.0f - voicedToUnvoiced - noteJumpProbability;
+    for (int distance = 0; distance <= maxStepBins; ++distance)
+        stepProbabilities[static_cast<size_t>(distance)] = driftProbability * static_cast<float>(maxStepBins + 1 - distance) / weightSum;
+
+    pathProbabilities.assign(static_cast<size_t>(numBins) + 1, 0.0f);
+    nextProbabilities.assign(static_cast<size_t>(numBins) + 1, 0.0f);
+    observations.assign(static_cast<size_t>(numBins), 0.0f);
+    backPointers.assign(static_cast<size_t>(historySize) * static_cast<size_t>(numBins + 1), 0);
+
+    reset();
+}
+
+void ViterbiPitchTracker::setDecodingLag(int frames)
+{
+    frames = juce::jlimit(0, maxDecodingLag, frames);
+
+    if (frames != decodingLag)
+    {
+        decodingLag = frames;
+        reset();
+    }
+}
+
+//starts from silence
+void ViterbiPitchTracker::reset()
+{
+    std::fill(pathProbabilities.begin(), pathProbabilities.end(), 0.0f);
+    pathProbabilities[static_cast<size_t>(getUnvoicedState())] = 1.0f;
+    framesProcessed = 0;
+    transitionsEvaluated = 0;
+}
+
+int ViterbiPitchTracker::getMaxTransitionsPerFrame() const
+{
+    //each voiced state is reached by drift, a jump or an onset, the unvoiced state by staying or leaving a note
+    return numBins * (2 * maxStepBins + 3) + 2;
+}
+
+float ViterbiPitchTracker::getBinFrequency(int bin) const
+{
+    return minFrequency * std::pow(2.0f, static_cast<float>(bin) / (12.0f * binsPerSemitone));
+}
+
+int ViterbiPitchTracker::getBin(float frequency) const
+{
+    if (frequency < minFrequency || frequency > maxFrequency)
+        return -1;
+
+    const int bin = static_cast<int>(std::lround(12.0f * binsPerSemitone * std::log2(frequency / minFrequency)));
+    return bin < numBins ? bin : -1;
+}
+
+//one step of the Viterbi recursion, then a walk back along the stored pointers to the frame due out
+//only voiced states with a candidate this frame can be on a path, the others are skipped
+ViterbiPitchTracker::Frame ViterbiPitchTracker::processFrame(const Candidate* candidates, int numCandidates)
+{
+    const int slot = static_cast<int>(framesProcessed % historySize);
+    auto& frame = history[static_cast<size_t>(slot)];
+    juce::int16* pointers = backPointers.data() + static_cast<size_t>(slot) * static_cast<size_t>(numBins + 1);
+    const int unvoiced = getUnvoicedState();
+
+    //the strongest candidates are kept for decoding this frame later
+    frame.numCandidates = 0;
+    frame.voicingProbability = 0.0f;
+    std::fill(observations.begin(), observations.end(), 0.0f);
+
+    for (int i = 0; candidates != nullptr && i < numCandidates && frame.numCandidates < maxCandidates; ++i)
+    {
+        const auto& candidate = candidates[i];
+        frame.voicingProbability += candidate.probability;
+
+        const int bin = getBin(candidate.frequency);
+        if (bin < 0 || candidate.probability <= 0.0f)
+            continue;
+
+        observations[static_cast<size_t>(bin)] += yinTrust * candidate.probability;
+        frame.candidates[static_cast<size_t>(frame.numCandidates++)] = candidate;
+    }
+
+    frame.voicingProbability = juce::jlimit(0.0f, 1.0f, frame.voicingProbability);
+
+    //the best voiced path, for jumps to another note and for going quiet
+    int bestVoiced = 0;
+    for (int bin = 1; bin < numBins; ++bin)
+        if (pathProbabilities[static_cast<size_t>(bin)] > pathProbabilities[static_cast<size_t>(bestVoiced)])
+            bestVoiced = bin;
+
+    const float bestVoicedProbability = pathProbabilities[static_cast<size_t>(bestVoiced)];
+    const float onsetScore = pathProbabilities[static_cast<size_t>(unvoiced)] * unvoicedToVoiced / static_cast<float>(numBins);
+    const float jumpScore = bestVoicedProbability * noteJumpProbability / static_cast<float>(numBins);
+
+    transitionsEvaluated = 2;
+    float maximum = 0.0f;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        const float observation = observations[static_cast<size_t>(bin)];
+
+        if (observation <= 0.0f)
+        {
+            nextProbabilities[static_cast<size_t>(bin)] = 0.0f;
+            pointers[bin] = static_cast<juce::int16>(unvoiced);
+            continue;
+        }
+
+        float best = onsetScore;
+        int from = unvoiced;
+
+        if (jumpScore > best)
+        {
+            best = jumpScore;
+            from = bestVoiced;
+        }
+
+        const int first = juce::jmax(0, bin - maxStepBins);
+        const int last = juce::jmin(numBins - 1, bin + maxStepBins);
+
+        for (int previous = first; previous <= last; ++previous)
+        {
+            const float score = pathProbabilities[static_cast<size_t>(previous)] * stepProbabilities[static_cast<size_t>(std::abs(bin - previous))];
+            if (score > best)
+            {
+                best = score;
+                from = previous;
+            }
+        }
+
+        transitionsEvaluated += last - first + 3;
+        nextProbabilities[static_cast<size_t>(bin)] = best * observation;
+        pointers[bin] = static_cast<juce::int16>(from);
+        maximum = juce::jmax(maximum, best * observation);
+    }
+
+    //the unvoiced state, staying quiet or leaving the best note
+    {
+        const float stay = pathProbabilities[static_cast<size_t>(unvoiced)] * (1.0f - unvoicedToVoiced);
+        const float leave = bestVoicedProbability * voicedToUnvoiced;
+        //pYIN spreads this over an unvoiced copy of every bin, one state takes the share of one
+        const float observation = (1.0f - yinTrust * frame.voicingProbability) / static_cast<float>(numBins);
+
+        nextProbabilities[static_cast<size_t>(unvoiced)] = juce::jmax(stay, leave) * observation;
+        pointers[unvoiced] = static_cast<juce::int16>(stay >= leave ? unvoiced : bestVoiced);
+        maximum = juce::jmax(maximum, nextProbabilities[static_cast<size_t>(unvoiced)]);
+    }
+
+    //rescaled so the products never underflow, the path choice is unchanged
+    int bestState = unvoiced;
+    for (int state = 0; state <= unvoiced; ++state)
+    {
+        auto& probability = nextProbabilities[static_cast<size_t>(state)];
+        probability = maximum > 0.0f ? probability / maximum : (state == unvoiced ? 1.0f : 0.0f);
+
+        if (probability >= 1.0f)
+            bestState = state;
+    }
+
+    std::swap(pathProbabilities, nextProbabilities);
+    ++framesProcessed;
+
+    if (framesProcessed <= decodingLag)
+        return {};
+
+    //back along the best path to the frame due out
+    int state = bestState;
+    for (int step = 0; step < decodingLag; ++step)
+    {
+        const int stepSlot = static_cast<int>((framesProcessed - 1 - step) % historySize);
+        state = backPointers[static_cast<size_t>(stepSlot) * static_cast<size_t>(numBins + 1) + static_cast<size_t>(state)];
+    }
+
+    const int decodedSlot = static_cast<int>((framesProcessed - 1 - decodingLag) % historySize);
+    return decodeFrame(state, history[static_cast<size_t>(decodedSlot)]);
+}
+
+//the most probable candidate of the frame in the decoded bin, its refined pitch rather than the bin centre
+ViterbiPitchTracker::Frame ViterbiPitchTracker::decodeFrame(int state, const FrameHistory& frame) const
+{
+    Frame result;
+    result.voicingProbability = frame.voicingProbability;
+
+    if (state == getUnvoicedState())
+        return result;
+
+    const Candidate* best = nullptr;
+    for (int i = 0; i < frame.numCandidates; ++i)
+    {
+        const auto& candidate = frame.candidates[static_cast<size_t>(i)];
+        if (getBin(candidate.frequency) == state && (best == nullptr || candidate.probability > best->probability))
+            best = &candidate;
+    }
+
+    result.frequency = best != nullptr ? best->frequency : getBinFrequency(state);
+    result.confidence = best != nullptr ? best->confidence : 0.0f;
+    return result;
+}
+
+#if JUCE_UNIT_TESTS
+
+class ViterbiPitchTrackerTests : public juce::UnitTest
+{
+public:
+    ViterbiPitchTrackerTests() : juce::UnitTest("Viterbi pitch tracker", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        beginTest("Bins cover the guitar's range");
+        {
+            ViterbiPitchTracker tracker;
+            expectEquals(tracker.getBin(ViterbiPitchTracker::minFrequency), 0);
+            expectEquals(tracker.getBin(ViterbiPitchTracker::maxFrequency), tracker.getNumBins() - 1);
+            expectEquals(tracker.getBin(50.0f), -1);
+            expectEquals(tracker.getBin(2000.0f), -1);
+            expectEquals(tracker.getBin(tracker.getBinFrequency(137)), 137);
+        }
+
+        beginTest("Decisions come out the decoding lag late");
+        {
+            ViterbiPitchTracker tracker;
+            tracker.setDecodingLag(3);
+
+            for (int i = 0; i < 3; ++i)
+                expectLessThan(tracker.processFrame(single(110.0f, 0.9f).data(), 1).frequency, 0.0f);
+
+            expectWithinAbsoluteError(tracker.processFrame(single(110.0f, 0.9f).data(), 1).frequency, 110.0f, 0.01f);
+        }
+
+        beginTest("A frame whose strongest dip is an octave up is kept on the note");
+        {
+            ViterbiPitchTracker tracker;
+            int octaveErrors = 0, unvoiced = 0;
+
+            for (int i = 0; i < 30; ++i)
+            {
+                auto candidates = single(110.0f, 0.9f);
+                int numCandidates = 1;
+
+                //first dip YIN would report 220 Hz on these frames
+                if (i == 12 || i == 13 || i == 20)
+                {
+                    candidates[0] = { 220.0f, 0.6f, 0.92f };
+                    candidates[1] = { 110.0f, 0.3f, 0.95f };
+                    numCandidates = 2;
+                }
+
+                const auto frame = tracker.processFrame(candidates.data(), numCandidates);
+                if (frame.frequency > 200.0f)
+                    ++octaveErrors;
+                if (i >= ViterbiPitchTracker::defaultDecodingLag + 2 && frame.frequency < 0.0f)
+                    ++unvoiced;
+            }
+
+            expectEquals(octaveErrors, 0);
+            expectEquals(unvoiced, 0);
+        }
+
+        beginTest("A new note and silence are followed");
+        {
+            ViterbiPitchTracker tracker;
+            tracker.setDecodingLag(0);
+
+            for (int i = 0; i < 10; ++i)
+                tracker.processFrame(single(110.0f, 0.9f).data(), 1);
+
+            float frequency = 0.0f;
+            for (int i = 0; i < 3; ++i)
+                frequency = tracker.processFrame(single(146.8f, 0.9f).data(), 1).frequency;
+            expectWithinAbsoluteError(frequency, 146.8f, 0.01f);
+
+            ViterbiPitchTracker::Frame frame;
+            for (int i = 0; i < 3; ++i)
+                frame = tracker.processFrame(nullptr, 0);
+            expectLessThan(frame.frequency, 0.0f);
+            expectEquals(frame.voicingProbability, 0.0f);
+        }
+
+        beginTest("Each frame's cost is bounded");
+        {
+            ViterbiPitchTracker tracker;
+            juce::Random random(7);
+
+            for (int i = 0; i < 200; ++i)
+            {
+                std::array<ViterbiPitchTracker::Candidate, ViterbiPitchTracker::maxCandidates> candidates;
+                for (auto& candidate : candidates)
+                    candidate = { 60.0f + random.nextFloat() * 1400.0f, random.nextFloat() / ViterbiPitchTracker::maxCandidates, 0.9f };
+
+                tracker.processFrame(candidates.data(), ViterbiPitchTracker::maxCandidates);
+                expectLessOrEqual(tracker.getTransitionsEvaluated(), tracker.getMaxTransitionsPerFrame());
+            }
+
+            expectLessThan(tracker.getMaxTransitionsPerFrame(), 5000);
+        }
+    }
+
+private:
+    static std::array<ViterbiPitchTracker::Candidate, ViterbiPitchTracker::maxCandidates> single(float frequency, float probability)
+    {
+        std::array<ViterbiPitchTracker::Candidate, ViterbiPitchTracker::maxCandidates> candidates;
+        candidates[0] = { frequency, probability, 0.95f };
+        return candidates;
+    }
+};
+
+static ViterbiPitchTrackerTests viterbiPitchTrackerTests;
+
+#endif
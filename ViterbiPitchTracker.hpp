@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <juce_core/juce_core.h>
+
+//hidden Markov model smoothing for the probabilistic YIN mode, after pYIN
+//the states are pitch bins a fifth of a semitone wide over the guitar's range plus one unvoiced
+//state, a voiced state drifts at most a semitone per frame and only rarely jumps to another
+//note, so a frame whose strongest dip is an octave out is carried by the frames either side
+//the path is decoded with a fixed lag, each frame returns the decision for the frame that many
+//frames back from a trellis sized in the constructor, nothing is allocated per frame and a
+//frame never costs more than getMaxTransitionsPerFrame()
+class ViterbiPitchTracker
+{
+public:
+    static constexpr int maxCandidates = 8;       //pitch candidates per frame
+    static constexpr int maxDecodingLag = 16;     //frames
+    static constexpr int defaultDecodingLag = 4;
+    static constexpr int binsPerSemitone = 5;
+    static constexpr int maxStepBins = binsPerSemitone;   //furthest a voiced state drifts in a frame
+    static constexpr float minFrequency = 60.0f;
+    static constexpr float maxFrequency = 1500.0f;
+
+    struct Candidate
+    {
+        float frequency = 0.0f;
+        float probability = 0.0f;   //share of the threshold prior for which this dip is the first
+        float confidence = 0.0f;    //1 - d'(tau) at the dip
+    };
+
+    struct Frame
+    {
+        float frequency = -1.0f;           //-1 when decoded as unvoiced, or before the first decision
+        float confidence = 0.0f;           //of the candidate the path went through
+        float voicingProbability = 0.0f;   //sum of the frame's candidate probabilities
+    };
+
+    ViterbiPitchTracker();
+
+    //frames between a frame going in and its decision coming out, changing it restarts the path
+    void setDecodingLag(int frames);
+    int getDecodingLag() const { return decodingLag; }
+
+    void reset();
+
+    //adds a frame and returns the decision for the frame getDecodingLag() frames back
+    //candidates outside the tracked range only count towards the voicing probability
+    Frame processFrame(const Candidate* candidates, int numCandidates);
+
+    //transitions scored for the last frame, and the most any frame can take
+    int getTransitionsEvaluated() const { return transitionsEvaluated; }
+    int getMaxTransitionsPerFrame() const;
+
+    int getNumBins() const { return numBins; }
+    float getBinFrequency(int bin) const;
+    int getBin(float frequency) const;   //-1 outside the tracked range
+
+private:
+    static constexpr int historySize = maxDecodingLag + 1;
+
+    struct FrameHistory
+    {
+        std::array<Candidate, maxCandidates> candidates;
+        int numCandidates = 0;
+        float voicingProbability = 0.0f;
+    };
+
+    int getUnvoicedState() const { return numBins; }
+    Frame decodeFrame(int state, const FrameHistory& frame) const;
+
+    int numBins = 0;
+    int decodingLag = defaultDecodingLag;
+    std::array<float, maxStepBins + 1> stepProbabilities {};   //by distance in bins
+
+    std::vector<float> pathProbabilities;      //best path into each state, scaled to a maximum of 1
+    std::vector<float> nextProbabilities;
+    std::vector<float> observations;           //voiced states only
+    std::vector<juce::int16> backPointers;     //historySize rows of numBins + 1 states
+    std::array<FrameHistory, historySize> history;
+
+    juce::int64 framesProcessed = 0;
+    int transitionsEvaluated = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ViterbiPitchTracker)
+};
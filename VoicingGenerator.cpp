@@ -0,0 +1,440 @@
+#include "VoicingGenerator.hpp"
+#include "ChordVerifier.hpp"
+#include <algorithm>
+
+const float fingerCost = 1.0f;          //each finger down
+const float stretchCost = 0.5f;         //each fret between the lowest and highest fretted notes
+const float positionCost = 0.25f;       //each fret the hand moves up the neck
+const float barreCost = 1.5f;
+const float mutedStringCost = 0.5f;
+
+namespace
+{
+    //chord tones above the root in semitones, by MusicLibrary::ChordQuality
+    const std::array<std::vector<int>, 10> qualityIntervals = { {
+        { 0, 4, 7 },        //major
+        { 0, 3, 7 },        //minor
+        { 0, 4, 7, 10 },    //dominant7
+        { 0, 4, 7, 11 },    //major7
+        { 0, 3, 7, 10 },    //minor7
+        { 0, 2, 7 },        //sus2
+        { 0, 5, 7 },        //sus4
+        { 0, 3, 6 },        //diminished
+        { 0, 4, 8 },        //augmented
+        { 0, 7 }            //power
+    } };
+
+    //suffixes after the root, longest first so "maj7" is not read as "m"
+    const std::array<std::pair<const char*, MusicLibrary::ChordQuality>, 13> qualitySuffixes = { {
+        { "maj7", MusicLibrary::ChordQuality::major7 },
+        { "sus2", MusicLibrary::ChordQuality::sus2 },
+        { "sus4", MusicLibrary::ChordQuality::sus4 },
+        { "min", MusicLibrary::ChordQuality::minor },
+        { "dim", MusicLibrary::ChordQuality::diminished },
+        { "aug", MusicLibrary::ChordQuality::augmented },
+        { "M7", MusicLibrary::ChordQuality::major7 },
+        { "m7", MusicLibrary::ChordQuality::minor7 },
+        { "m", MusicLibrary::ChordQuality::minor },
+        { "7", MusicLibrary::ChordQuality::dominant7 },
+        { "5", MusicLibrary::ChordQuality::power },
+        { "+", MusicLibrary::ChordQuality::augmented },
+        { "", MusicLibrary::ChordQuality::major }
+    } };
+
+    bool containsPitchClass(juce::uint16 pitchClasses, int midiNote)
+    {
+        return ((pitchClasses >> PitchModel::pitchClassOf(midiNote)) & 1u) != 0;
+    }
+
+    int cacheKey(int root, MusicLibrary::ChordQuality quality)
+    {
+        return PitchModel::pitchClassOf(root) * 16 + static_cast<int>(quality);
+    }
+}
+
+//voicing being built string by string from the low E up, and the voicings found so far
+struct VoicingGenerator::SearchState
+{
+    int root = 0;
+    juce::uint16 chordPitchClasses = 0;
+    juce::uint16 requiredPitchClasses = 0;
+    int windowStart = 1;
+
+    //frets on each string that sound a chord tone, lowest first
+    std::array<std::vector<int>, numStrings> chordFrets;
+
+    std::array<int, numStrings> frets {};
+    juce::uint16 soundingPitchClasses = 0;
+    int soundingStrings = 0;
+
+    std::vector<Voicing>* results = nullptr;
+};
+
+//indexes every note on the neck by where it can be played
+VoicingGenerator::VoicingGenerator()
+{
+    for (int stringIndex = 0; stringIndex < numStrings; ++stringIndex)
+        for (int fret = 0; fret <= numFrets; ++fret)
+            positionsByNote[static_cast<size_t>(ChordVerifier::getOpenStringMidiNote(stringIndex) + fret)].push_back({ stringIndex, fret });
+}
+
+const std::vector<VoicingGenerator::Position>& VoicingGenerator::getPositions(int midiNote) const
+{
+    static const std::vector<Position> offTheNeck;
+    return PitchModel::isValidNote(midiNote) ? positionsByNote[static_cast<size_t>(midiNote)] : offTheNeck;
+}
+
+bool VoicingGenerator::parseChordSymbol(const juce::String& symbol, int& root, MusicLibrary::ChordQuality& quality)
+{
+    static const int naturalPitchClasses[] = { 9, 11, 0, 2, 4, 5, 7 };   //A to G
+
+    const auto text = symbol.trim();
+    if (text.isEmpty() || text[0] < 'A' || text[0] > 'G')
+        return false;
+
+    int pitchClass = naturalPitchClasses[text[0] - 'A'];
+    int suffixStart = 1;
+
+    if (text.length() > 1 && (text[1] == '#' || text[1] == 'b'))
+    {
+        pitchClass += text[1] == '#' ? 1 : -1;
+        suffixStart = 2;
+    }
+
+    const auto suffix = text.substring(suffixStart);
+    for (const auto& entry : qualitySuffixes)
+    {
+        if (suffix == entry.first)
+        {
+            root = PitchModel::pitchClassOf(pitchClass);
+            quality = entry.second;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+juce::uint16 VoicingGenerator::getPitchClasses(int root, MusicLibrary::ChordQuality quality)
+{
+    juce::uint16 pitchClasses = 0;
+    for (int interval : qualityIntervals[static_cast<size_t>(quality)])
+        pitchClasses = static_cast<juce::uint16>(pitchClasses | (1u << PitchModel::pitchClassOf(root + interval)));
+    return pitchClasses;
+}
+
+//cached voicings move to the front, a miss generates them and evicts the least recently used chord
+const std::vector<VoicingGenerator::Voicing>& VoicingGenerator::getVoicings(int root, MusicLibrary::ChordQuality quality)
+{
+    if (static_cast<size_t>(quality) >= qualityIntervals.size())
+        return noVoicings;
+
+    const int key = cacheKey(root, quality);
+    const auto found = cacheIndex.find(key);
+
+    if (found != cacheIndex.end())
+    {
+        ++cacheHits;
+        cache.splice(cache.begin(), cache, found->second);
+        return cache.front().voicings;
+    }
+
+    ++cacheMisses;
+
+    if (static_cast<int>(cache.size()) >= cacheCapacity)
+    {
+        cacheIndex.erase(cache.back().key);
+        cache.pop_back();
+    }
+
+    cache.push_front({ key, generate(root, quality) });
+    cacheIndex[key] = cache.begin();
+    return cache.front().voicings;
+}
+
+const std::vector<VoicingGenerator::Voicing>& VoicingGenerator::getVoicings(const juce::String& symbol)
+{
+    int root = 0;
+    auto quality = MusicLibrary::ChordQuality::major;
+    return parseChordSymbol(symbol, root, quality) ? getVoicings(root, quality) : noVoicings;
+}
+
+//searches each hand position in turn, open strings are allowed in all of them
+std::vector<VoicingGenerator::Voicing> VoicingGenerator::generate(int root, MusicLibrary::ChordQuality quality) const
+{
+    std::vector<Voicing> voicings;
+
+    SearchState state;
+    state.root = PitchModel::pitchClassOf(root);
+    state.chordPitchClasses = getPitchClasses(root, quality);
+    state.requiredPitchClasses = state.chordPitchClasses;
+    state.results = &voicings;
+
+    //four note chords are still complete without their fifth
+    if (qualityIntervals[static_cast<size_t>(quality)].size() >= 4)
+        state.requiredPitchClasses = static_cast<juce::uint16>(state.requiredPitchClasses & ~(1u << PitchModel::pitchClassOf(root + 7)));
+
+    //where each chord tone lies on the neck, from the note index, so the search only visits those frets
+    for (int note = 0; note < PitchModel::numNotes; ++note)
+        if (containsPitchClass(state.chordPitchClasses, note))
+            for (const auto& position : positionsByNote[static_cast<size_t>(note)])
+                state.chordFrets[static_cast<size_t>(position.stringIndex)].push_back(position.fret);
+
+    for (int windowStart = 1; windowStart <= numFrets; ++windowStart)
+    {
+        state.windowStart = windowStart;
+        search(state, numStrings - 1);
+    }
+
+    std::sort(voicings.begin(), voicings.end(), [](const Voicing& a, const Voicing& b)
+    {
+        if (a.difficulty != b.difficulty)
+            return a.difficulty < b.difficulty;
+        return a.frets < b.frets;
+    });
+
+    return voicings;
+}
+
+//tries muting, the open string and each chord tone under the hand on this string, then the next
+//string up, only the lowest strings may be muted and the lowest string sounding plays the root
+void VoicingGenerator::search(SearchState& state, int stringIndex) const
+{
+    if (stringIndex < 0)
+    {
+        Voicing voicing;
+        if (finishVoicing(state, voicing))
+            state.results->push_back(voicing);
+        return;
+    }
+
+    auto& fret = state.frets[static_cast<size_t>(stringIndex)];
+    const int openNote = ChordVerifier::getOpenStringMidiNote(stringIndex);
+
+    if (state.soundingStrings == 0 && stringIndex >= minSoundingStrings)
+    {
+        fret = mutedFret;
+        search(state, stringIndex - 1);
+    }
+
+    const int lastFret = juce::jmin(numFrets, state.windowStart + maxHandSpan - 1);
+
+    for (int candidate : state.chordFrets[static_cast<size_t>(stringIndex)])
+    {
+        if (candidate > lastFret)
+            break;
+        if (candidate != 0 && candidate < state.windowStart)
+            continue;
+
+        const int note = openNote + candidate;
+        if (state.soundingStrings == 0 && PitchModel::pitchClassOf(note) != state.root)
+            continue;
+
+        const auto previousPitchClasses = state.soundingPitchClasses;
+        fret = candidate;
+        state.soundingPitchClasses = static_cast<juce::uint16>(state.soundingPitchClasses | (1u << PitchModel::pitchClassOf(note)));
+        ++state.soundingStrings;
+
+        search(state, stringIndex - 1);
+
+        --state.soundingStrings;
+        state.soundingPitchClasses = previousPitchClasses;
+    }
+}
+
+//checks a complete voicing is whole and playable and rates it
+//each voicing is kept only for the hand position of its lowest fretted note, so none repeats
+bool VoicingGenerator::finishVoicing(const SearchState& state, Voicing& voicing) const
+{
+    if (state.soundingStrings < minSoundingStrings
+        || (state.soundingPitchClasses & state.requiredPitchClasses) != state.requiredPitchClasses)
+        return false;
+
+    int lowestFret = numFrets + 1, highestFret = 0, fretted = 0, muted = 0;
+    for (int fret : state.frets)
+    {
+        if (fret == mutedFret)
+            ++muted;
+        else if (fret > 0)
+        {
+            lowestFret = juce::jmin(lowestFret, fret);
+            highestFret = juce::jmax(highestFret, fret);
+            ++fretted;
+        }
+    }
+
+    if (fretted == 0 ? state.windowStart != 1 : lowestFret != state.windowStart)
+        return false;
+
+    //strings at the lowest fret share a barre when nothing open or muted lies between them
+    int firstAtLowest = -1, lastAtLowest = -1, atLowest = 0;
+    for (int stringIndex = 0; stringIndex < numStrings; ++stringIndex)
+    {
+        if (state.frets[static_cast<size_t>(stringIndex)] == lowestFret)
+        {
+            if (firstAtLowest < 0)
+                firstAtLowest = stringIndex;
+            lastAtLowest = stringIndex;
+            ++atLowest;
+        }
+    }
+
+    bool barre = atLowest > 1;
+    for (int stringIndex = firstAtLowest + 1; barre && stringIndex < lastAtLowest; ++stringIndex)
+        barre = state.frets[static_cast<size_t>(stringIndex)] > 0;
+
+    const int fingers = barre ? fretted - atLowest + 1 : fretted;
+    if (fingers > maxFingers)
+        return false;
+
+    voicing.frets = state.frets;
+    voicing.lowestFret = fretted > 0 ? lowestFret : 0;
+    voicing.fingers = fingers;
+    voicing.barre = barre;
+    voicing.difficulty = fingerCost * static_cast<float>(fingers)
+                       + stretchCost * static_cast<float>(fretted > 0 ? highestFret - lowestFret : 0)
+                       + positionCost * static_cast<float>(voicing.lowestFret)
+                       + (barre ? barreCost : 0.0f)
+                       + mutedStringCost * static_cast<float>(muted);
+    return true;
+}
+
+#if JUCE_UNIT_TESTS
+
+class VoicingGeneratorTests : public juce::UnitTest
+{
+public:
+    VoicingGeneratorTests() : juce::UnitTest("Voicing generator", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        VoicingGenerator generator;
+
+        beginTest("Fretboard index");
+        {
+            expectEquals(static_cast<int>(generator.getPositions(40).size()), 1);   //low E, open only
+            expectEquals(static_cast<int>(generator.getPositions(45).size()), 2);   //A2, 5th fret and open A
+            expectEquals(static_cast<int>(generator.getPositions(64).size()), 4);   //E4, open e and on the B, G and D strings
+            expect(generator.getPositions(30).empty());
+
+            for (int note = 40; note < 100; ++note)
+                for (const auto& position : generator.getPositions(note))
+                    expectEquals(ChordVerifier::getOpenStringMidiNote(position.stringIndex) + position.fret, note);
+        }
+
+        beginTest("Chord symbols");
+        {
+            int root = -1;
+            auto quality = MusicLibrary::ChordQuality::major;
+
+            expect(VoicingGenerator::parseChordSymbol("F#m", root, quality));
+            expect(root == 6 && quality == MusicLibrary::ChordQuality::minor);
+            expect(VoicingGenerator::parseChordSymbol("Bb7", root, quality));
+            expect(root == 10 && quality == MusicLibrary::ChordQuality::dominant7);
+            expect(VoicingGenerator::parseChordSymbol("Cmaj7", root, quality));
+            expect(root == 0 && quality == MusicLibrary::ChordQuality::major7);
+            expect(VoicingGenerator::parseChordSymbol("Am7", root, quality));
+            expect(root == 9 && quality == MusicLibrary::ChordQuality::minor7);
+            expect(VoicingGenerator::parseChordSymbol("G", root, quality));
+            expect(root == 7 && quality == MusicLibrary::ChordQuality::major);
+            expect(!VoicingGenerator::parseChordSymbol("H", root, quality));
+            expect(!VoicingGenerator::parseChordSymbol("Cwhatever", root, quality));
+        }
+
+        beginTest("The library's shapes are generated");
+        {
+            const auto library = MusicLibrary::getBuiltInDefinitions().build();
+            MusicLibrary chords;
+            chords.openFromMemory(library.getData(), library.getSize());
+
+            for (int i = 0; i < chords.getNumChords(); ++i)
+            {
+                const auto chord = chords.getChord(i);
+                const auto& voicings = generator.getVoicings(chord.root, chord.quality);
+
+                const bool found = std::any_of(voicings.begin(), voicings.end(), [&chord](const VoicingGenerator::Voicing& voicing)
+                {
+                    return voicing.frets == chord.frets;
+                });
+                expect(found, juce::String(chord.name) + " is among the generated voicings");
+            }
+        }
+
+        beginTest("Every voicing is complete and playable");
+        for (const auto* symbol : { "C", "Am", "G7", "Dmaj7", "F#m7", "Bdim", "Esus4" })
+        {
+            int root = 0;
+            auto quality = MusicLibrary::ChordQuality::major;
+            VoicingGenerator::parseChordSymbol(symbol, root, quality);
+
+            const auto& voicings = generator.getVoicings(symbol);
+            expectGreaterThan(static_cast<int>(voicings.size()), 10);
+
+            const auto chordPitchClasses = VoicingGenerator::getPitchClasses(root, quality);
+            for (const auto& voicing : voicings)
+            {
+                int lowest = 99, highest = 0, bass = -1;
+                bool sounding = false, mutedAboveSounding = false;
+
+                for (int stringIndex = VoicingGenerator::numStrings - 1; stringIndex >= 0; --stringIndex)
+                {
+                    const int fret = voicing.frets[static_cast<size_t>(stringIndex)];
+                    if (fret == VoicingGenerator::mutedFret)
+                    {
+                        mutedAboveSounding |= sounding;
+                        continue;
+                    }
+
+                    const int note = ChordVerifier::getOpenStringMidiNote(stringIndex) + fret;
+                    expect(((chordPitchClasses >> PitchModel::pitchClassOf(note)) & 1u) != 0);
+                    if (!sounding)
+                        bass = note;
+                    sounding = true;
+
+                    if (fret > 0)
+                    {
+                        lowest = juce::jmin(lowest, fret);
+                        highest = juce::jmax(highest, fret);
+                    }
+                }
+
+                expect(!mutedAboveSounding);
+                expectEquals(PitchModel::pitchClassOf(bass), root);
+                expect(highest == 0 || highest - lowest < VoicingGenerator::maxHandSpan);
+                expect(voicing.fingers <= VoicingGenerator::maxFingers);
+            }
+
+            for (size_t i = 1; i < voicings.size(); ++i)
+                expect(voicings[i - 1].difficulty <= voicings[i].difficulty);
+        }
+
+        beginTest("Least recently used chords are evicted");
+        {
+            VoicingGenerator cached;
+            const auto* first = &cached.getVoicings("C");
+            expect(&cached.getVoicings("C") == first);
+            expectEquals(cached.getCacheHits(), 1);
+            expectEquals(cached.getCacheMisses(), 1);
+
+            //fills the cache with other chords, touching C so it stays
+            for (int root = 1; root < 12; ++root)
+                for (auto quality : { MusicLibrary::ChordQuality::major, MusicLibrary::ChordQuality::minor, MusicLibrary::ChordQuality::dominant7 })
+                {
+                    cached.getVoicings(root, quality);
+                    cached.getVoicings("C");
+                }
+
+            const int misses = cached.getCacheMisses();
+            cached.getVoicings("C");
+            expectEquals(cached.getCacheMisses(), misses);
+
+            //the first chord added after C has long been evicted
+            cached.getVoicings(1, MusicLibrary::ChordQuality::major);
+            expectEquals(cached.getCacheMisses(), misses + 1);
+        }
+    }
+};
+
+static VoicingGeneratorTests voicingGeneratorTests;
+
+#endif
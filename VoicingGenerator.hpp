@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <juce_core/juce_core.h>
+#include "MusicLibrary.hpp"
+#include "PitchModel.hpp"
+
+//generates playable voicings of a chord anywhere on the neck for the Chords tab
+//a voicing puts the root in the bass, sounds every note of the chord (the fifth may be left out
+//of four note chords), fits the fretting hand and mutes only a run of the lowest strings, the
+//same shapes the library's chords use
+//the search only visits the frets of the chord tones, looked up in an index of every note's
+//positions built once, and the voicings of the most recently used chords are kept in an LRU
+//cache so switching between them costs nothing
+//message thread only
+class VoicingGenerator
+{
+public:
+    static constexpr int numStrings = MusicLibrary::numStrings;
+    static constexpr int mutedFret = MusicLibrary::mutedFret;
+    static constexpr int numFrets = 15;           //highest fret a voicing may use
+    static constexpr int maxHandSpan = 4;         //frets the hand covers, first to last inclusive
+    static constexpr int maxFingers = 4;          //a barre counts as one
+    static constexpr int minSoundingStrings = 3;
+    static constexpr int cacheCapacity = 32;      //chords whose voicings are kept
+
+    struct Position
+    {
+        int stringIndex = 0;   //0 is the high e string
+        int fret = 0;
+    };
+
+    struct Voicing
+    {
+        std::array<int, numStrings> frets {};   //as MusicLibrary::Chord, index 0 is the high e string
+        int lowestFret = 0;                     //lowest fretted position, 0 when every string is open
+        int fingers = 0;
+        bool barre = false;
+        float difficulty = 0.0f;                //lower is easier, voicings are sorted by it
+    };
+
+    VoicingGenerator();
+
+    //every place a MIDI note can be played up to numFrets, empty for notes off the neck
+    const std::vector<Position>& getPositions(int midiNote) const;
+
+    //"C", "F#m", "Bb7", "Cmaj7", "Am7", "Dsus4", "Bdim", "Caug", "E5"
+    static bool parseChordSymbol(const juce::String& symbol, int& root, MusicLibrary::ChordQuality& quality);
+    static juce::uint16 getPitchClasses(int root, MusicLibrary::ChordQuality quality);
+
+    //voicings easiest first, the reference stays valid until the chord is evicted from the cache
+    const std::vector<Voicing>& getVoicings(int root, MusicLibrary::ChordQuality quality);
+
+    //as above for a chord symbol, empty when the symbol is not understood
+    const std::vector<Voicing>& getVoicings(const juce::String& symbol);
+
+    int getCacheHits() const { return cacheHits; }
+    int getCacheMisses() const { return cacheMisses; }
+
+private:
+    struct CacheEntry
+    {
+        int key = 0;
+        std::vector<Voicing> voicings;
+    };
+
+    struct SearchState;
+
+    std::vector<Voicing> generate(int root, MusicLibrary::ChordQuality quality) const;
+    void search(SearchState& state, int stringIndex) const;
+    bool finishVoicing(const SearchState& state, Voicing& voicing) const;
+
+    std::array<std::vector<Position>, PitchModel::numNotes> positionsByNote;
+
+    std::list<CacheEntry> cache;   //most recently used first
+    std::unordered_map<int, std::list<CacheEntry>::iterator> cacheIndex;
+    const std::vector<Voicing> noVoicings;
+    int cacheHits = 0;
+    int cacheMisses = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicingGenerator)
+};
@@ -1,4 +1,5 @@
 #include "YINAudioComponent.hpp"
+#include "DSPKernels.hpp"
 #include <cmath>
 #include <juce_core/juce_core.h>
 
@@ -9,11 +10,45 @@ const float DEFAULT_INPUT_MAGNITUDE_THRESHOLD = 0.05f;
 const float DEFAULT_DYNAMIC_THRESHOLD_MULTIPLIER = 0.005f;
 const float FIXED_DYNAMIC_TOLERANCE = 0.05f;  // Static tolerance for low-frequency detection
 const int MIN_BUFFER_SIZE = 8192;  // Minimum buffer size for accurate low-frequency detection
+const float CANDIDATE_SEARCH_SEMITONES = 0.5f;  //lag neighbourhood searched either side of a candidate
+const float OCTAVE_BELOW_MARGIN = 0.1f;  //confidence gain at twice the lag before the octave below wins
+const float OCTAVE_ABOVE_MARGIN = 0.05f;  //confidence at half the lag this close to the candidate means the octave above
+const int NUM_THRESHOLDS = 100;  //probabilistic mode, thresholds 0.01 to 1 under the prior
+const float THRESHOLD_PRIOR_ALPHA = 2.0f;  //beta distribution with a mean of 0.15, pYIN's default prior
+const float THRESHOLD_PRIOR_BETA = 34.0f / 3.0f;
+
+//cumulative prior mass of the thresholds below each index, the mass of thresholds k / 100 for k in [a, b) is cdf[b] - cdf[a]
+static std::array<float, NUM_THRESHOLDS + 1> makeThresholdPrior()
+{
+    std::array<float, NUM_THRESHOLDS + 1> cdf {};
+    double total = 0.0;
+
+    for (int k = 0; k < NUM_THRESHOLDS; ++k)
+    {
+        const double threshold = (k + 1) / static_cast<double>(NUM_THRESHOLDS);
+        total += std::pow(threshold, THRESHOLD_PRIOR_ALPHA - 1.0) * std::pow(1.0 - threshold + 1e-9, THRESHOLD_PRIOR_BETA - 1.0);
+        cdf[static_cast<size_t>(k) + 1] = static_cast<float>(total);
+    }
+
+    for (auto& mass : cdf)
+        mass /= static_cast<float>(total);
+
+    return cdf;
+}
+
+static const std::array<float, NUM_THRESHOLDS + 1> thresholdPrior = makeThresholdPrior();
 
 YINAudioComponent::YINAudioComponent()
-    : tolerance(DEFAULT_TOLERANCE),
+    : writePosition(0),
+      samplesUntilAnalysis(0),
+      hopSize(0),
+      differenceEngine(DifferenceEngine::FFT),
+      tolerance(DEFAULT_TOLERANCE),
       sampleRate(DEFAULT_SAMPLE_RATE),
-      inputMagnitudeThreshold(DEFAULT_INPUT_MAGNITUDE_THRESHOLD) {}
+      inputMagnitudeThreshold(DEFAULT_INPUT_MAGNITUDE_THRESHOLD)
+{
+    decimator.prepare(1);
+}
 
 
 //initializer for the YIN processor
@@ -28,129 +63,902 @@ void YINAudioComponent::initialize(float sampleRate, int bufferSize)
         return;
     }
 
-    this->sampleRate = sampleRate;
+    //the window and the lags are at the decimated rate, a window covers the same time at any factor
+    decimator.prepare(requestedDecimation == automaticDecimation ? Decimator::getFactorForSampleRate(sampleRate) : requestedDecimation);
+    const int factor = decimator.getFactor();
+    this->sampleRate = sampleRate / factor;
 
     //allocate buffer sizes
-    int detectionBufferSize = bufferSize < MIN_BUFFER_SIZE ? MIN_BUFFER_SIZE : bufferSize;
+    int detectionBufferSize = (bufferSize < MIN_BUFFER_SIZE ? MIN_BUFFER_SIZE : bufferSize) / factor;
+    decimatedBlock.assign(static_cast<size_t>(detectionBufferSize) + 1, 0.0f);
+    decimatedMagnitudes.assign(decimatedBlock.size(), 0.0f);
+    magnitudeRing.assign(factor > 1 ? static_cast<size_t>(detectionBufferSize) : 0, 0.0f);
     yinBuffer.resize(detectionBufferSize / 2);
-    accumulatedBuffer.reserve(detectionBufferSize);
+    windowedBuffer.assign(detectionBufferSize, 0.0f);
+
+    //circular buffer holding exactly one detection window
+    ringBuffer.assign(detectionBufferSize, 0.0f);
+    writePosition = 0;
+    samplesUntilAnalysis = detectionBufferSize; //the first window always has to fill completely
+
+    //the common window sizes have compile-time specialised kernels with a constexpr Hamming window
+    fixedKernels = YINKernels::getTable(detectionBufferSize);
 
-    //precompute Hamming window to avoid recalculating
-    hammingWindow.resize(detectionBufferSize);
-    for (int i = 0; i < detectionBufferSize; ++i)
+    //other sizes precompute the Hamming window to avoid recalculating
+    hammingWindow.clear();
+    if (fixedKernels == nullptr)
     {
-        hammingWindow[i] = 0.54f - 0.46f * std::cos(2.0f * juce::MathConstants<float>::pi * i / (detectionBufferSize - 1));
+        hammingWindow.resize(detectionBufferSize);
+        for (int i = 0; i < detectionBufferSize; ++i)
+        {
+            hammingWindow[i] = 0.54f - 0.46f * std::cos(2.0f * juce::MathConstants<float>::pi * i / (detectionBufferSize - 1));
+        }
     }
 
+    analysisWindow = fixedKernels != nullptr ? fixedKernels->window : hammingWindow.data();
+
+    //preallocate the FFT engine for the detection window
+    prepareFFT(detectionBufferSize);
+}
+
+//empties the window and the front end, the tracker starts again from the next window
+void YINAudioComponent::reset()
+{
+    std::fill(ringBuffer.begin(), ringBuffer.end(), 0.0f);
+    std::fill(magnitudeRing.begin(), magnitudeRing.end(), 0.0f);
+    writePosition = 0;
+    samplesUntilAnalysis = static_cast<int>(ringBuffer.size());
+    decimator.reset();
+    pitchTracker.reset();
+    voicingProbability = 0.0f;
+    lastConfidence = 0.0f;
+}
+
+//selects which engine computes the difference function
+void YINAudioComponent::setDifferenceEngine(DifferenceEngine engine)
+{
+    differenceEngine = engine;
+}
+
+//sizes the FFT so the linear correlation up to lag N/2 does not wrap around
+void YINAudioComponent::prepareFFT(int bufferSize)
+{
+    int fftSize = juce::nextPowerOfTwo(bufferSize + bufferSize / 2);
+    int fftOrder = 0;
+    while ((1 << fftOrder) < fftSize)
+        ++fftOrder;
+
+    fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+    fftBuffer.assign(2 * static_cast<size_t>(fftSize), 0.0f);
+    squaredPrefixSum.assign(static_cast<size_t>(bufferSize) + 1, 0.0);
 }
 
 //apply hamming window to signal
 void YINAudioComponent::applyHammingWindow(std::vector<float>& buffer)
 {
-    for (size_t i = 0; i < buffer.size(); ++i)
+    if (analysisWindow == nullptr)
+        return;
+
+    int numSamples = static_cast<int>(std::min(buffer.size(), ringBuffer.size()));
+    DSPKernels::applyWindow(buffer.data(), buffer.data(), analysisWindow, numSamples);
+}
+
+//d'(tau) of a contiguous buffer, the same windowing and engine as process()
+const std::vector<float>& YINAudioComponent::computeNormalisedDifference(const float* samples, int numSamples)
+{
+    if (samples != nullptr && numSamples >= 4 && numSamples <= static_cast<int>(ringBuffer.size()))
     {
-        buffer[i] *= hammingWindow[i];
+        DSPKernels::applyWindow(windowedBuffer.data(), samples, analysisWindow, numSamples);
+        normaliseWindowedBuffer(numSamples);
     }
+
+    return yinBuffer;
 }
 
 //Handles the accumulated buffer required for YIN processing and applys yin processing
+//with a decimation factor the block goes through the front end first, a window's worth at a time
 float YINAudioComponent::processAudioBuffer(const float* audioBuffer, int bufferSize)
 {
-    //starts accumulated buffer
-    accumulatedBuffer.insert(accumulatedBuffer.end(), audioBuffer, audioBuffer + bufferSize);
+    if (audioBuffer == nullptr || bufferSize <= 0 || ringBuffer.empty())
+        return -1.0f;
+
+    const int factor = decimator.getFactor();
+    if (factor == 1)
+        return addToRingBuffer(audioBuffer, nullptr, bufferSize);
+
+    const int maxChunk = (static_cast<int>(decimatedBlock.size()) - 1) * factor;
+    float detectedPitch = -1.0f;
+
+    for (int samplesRead = 0; samplesRead < bufferSize; samplesRead += maxChunk)
+    {
+        const int numDecimated = decimator.process(audioBuffer + samplesRead, juce::jmin(maxChunk, bufferSize - samplesRead),
+                                                   decimatedBlock.data(), decimatedMagnitudes.data());
+        const float pitch = addToRingBuffer(decimatedBlock.data(), decimatedMagnitudes.data(), numDecimated);
+        if (pitch > 0.0f)
+            detectedPitch = pitch;
+    }
+
+    return detectedPitch;
+}
+
+//whole blocks are copied into the circular buffer and the window is analysed straight from it
+//block mode analyses each window once, streaming mode analyses the latest window every hop
+//when a block spans several analyses the most recent detected pitch is returned
+float YINAudioComponent::addToRingBuffer(const float* audioBuffer, const float* magnitudes, int bufferSize)
+{
+    if (bufferSize <= 0)
+        return -1.0f;
 
-    //check accumulated buffer size meets the required buffer
-    if (accumulatedBuffer.size() >= yinBuffer.size() * 2)
+    const int capacity = static_cast<int>(ringBuffer.size());
+    float detectedPitch = -1.0f;
+    int samplesRead = 0;
+
+    while (samplesRead < bufferSize)
     {
-        
-        int detectionBufferSize = static_cast<int>(yinBuffer.size() * 2);
-        std::vector<float> processBuffer(accumulatedBuffer.begin(), accumulatedBuffer.begin() + detectionBufferSize);
+        //copies as much of the block as fits before the next analysis or the buffer wraps
+        int samplesToCopy = std::min({ bufferSize - samplesRead,
+                                       samplesUntilAnalysis,
+                                       capacity - writePosition });
+
+        std::copy(audioBuffer + samplesRead, audioBuffer + samplesRead + samplesToCopy, ringBuffer.begin() + writePosition);
+        if (magnitudes != nullptr)
+            std::copy(magnitudes + samplesRead, magnitudes + samplesRead + samplesToCopy, magnitudeRing.begin() + writePosition);
+
+        samplesRead += samplesToCopy;
+        samplesUntilAnalysis -= samplesToCopy;
+        writePosition = (writePosition + samplesToCopy) % capacity;
 
-        //passes signal through the YIN process
-        float detectedPitch = process(processBuffer.data(), detectionBufferSize);
-        if (detectedPitch > 0.0f)
+        if (samplesUntilAnalysis == 0)
         {
-            DBG("Pitch detected: " + juce::String(detectedPitch));
-            accumulatedBuffer.clear();  //clears the buffer
-            return detectedPitch;
-        }
+            //passes signal through the YIN process
+            float pitch = processRingBuffer();
+            if (pitch > 0.0f)
+                detectedPitch = pitch;
 
-        //remove processed samples
-        accumulatedBuffer.erase(accumulatedBuffer.begin(), accumulatedBuffer.begin() + detectionBufferSize);
+            //block mode discards the processed window, streaming mode slides it by one hop
+            samplesUntilAnalysis = isStreaming() ? getDecimatedHop() : capacity;
+        }
     }
 
-    return -1.0f; //no pitch detected
+    return detectedPitch; //-1 when no pitch detected
+}
+
+PitchDetector::Result YINAudioComponent::analyseBlock(const float* samples, int numSamples)
+{
+    const float pitch = processAudioBuffer(samples, numSamples);
+    return { pitch, pitch > 0.0f ? lastConfidence : 0.0f };
+}
+
+//sets the number of samples between analyses of the sliding window
+//0 (or a hop of at least the window length) keeps the non-overlapping block mode
+void YINAudioComponent::setHopSize(int newHopSize)
+{
+    hopSize = std::max(0, newHopSize);
+
+    //an analysis already due sooner than the new hop is left alone
+    if (isStreaming() && samplesUntilAnalysis > getDecimatedHop() && samplesUntilAnalysis < static_cast<int>(ringBuffer.size()))
+        samplesUntilAnalysis = getDecimatedHop();
+}
+
+//the hop in samples of the window, at least one when a hop is set
+int YINAudioComponent::getDecimatedHop() const
+{
+    return hopSize > 0 ? std::max(1, hopSize / decimator.getFactor()) : 0;
+}
+
+//streaming mode is active when the hop is shorter than the window
+bool YINAudioComponent::isStreaming() const
+{
+    return hopSize > 0 && getDecimatedHop() < static_cast<int>(ringBuffer.size());
+}
+
+//input samples between two pitch estimates once the window has filled
+int YINAudioComponent::getAnalysisInterval() const
+{
+    return (isStreaming() ? getDecimatedHop() : static_cast<int>(ringBuffer.size())) * decimator.getFactor();
 }
 
 
-//this is the main process of the YIN algorithm
-//it includes the auto correlation, normalization and parabolic interpolation
+//this is the main process of the YIN algorithm for a contiguous buffer
+//with a decimation factor the front end starts again from silence and the buffer is decimated first
 float YINAudioComponent::process(const float* audioBuffer, int bufferSize)
 {
+    lastConfidence = 0.0f;
+
     //checks for audio buffer
-    if (audioBuffer == nullptr || bufferSize <= 0)
+    if (audioBuffer == nullptr || bufferSize <= 0 || bufferSize > getWindowSize())
         return -1.0f;
 
     //calculates the magnitude of the buffer
-    float magnitude = std::accumulate(audioBuffer, audioBuffer + bufferSize, 0.0f, [](float acc, float val) {
-        return acc + std::abs(val);
-    });
+    float magnitude = DSPKernels::sumOfMagnitudes(audioBuffer, bufferSize);
+
+    //checks if magnitude of inpuit signal is below the threshold, the tracker still moves on a frame
+    if (isBelowInputThreshold(magnitude, bufferSize))
+        return isTracking() ? trackFrame(nullptr, 0) : -1.0f;
+
+    if (decimator.getFactor() > 1)
+    {
+        decimator.reset();
+        bufferSize = decimator.process(audioBuffer, bufferSize, decimatedBlock.data());
+        audioBuffer = decimatedBlock.data();
+
+        if (bufferSize <= 0)
+            return -1.0f;
+    }
+
+    //application of the hamming windowing
+    DSPKernels::applyWindow(windowedBuffer.data(), audioBuffer, analysisWindow, bufferSize);
+
+    return analyseWindowedBuffer(bufferSize);
+}
+
+//runs the YIN process on the full window held in the circular buffer
+//the oldest sample sits at the write position once the buffer is full
+float YINAudioComponent::processRingBuffer()
+{
+    const int bufferSize = static_cast<int>(ringBuffer.size());
+    lastConfidence = 0.0f;
 
+    //calculates the magnitude of the buffer, sample order does not matter here
+    //a decimated window is judged on the input's magnitudes, the low-pass takes energy out
+    const float* magnitudeSource = magnitudeRing.empty() ? ringBuffer.data() : magnitudeRing.data();
+    float magnitude = fixedKernels != nullptr ? fixedKernels->sumOfMagnitudes(magnitudeSource)
+                                              : DSPKernels::sumOfMagnitudes(magnitudeSource, bufferSize);
+
+    if (isBelowInputThreshold(magnitude, bufferSize * decimator.getFactor()))
+        return isTracking() ? trackFrame(nullptr, 0) : -1.0f;
+
+    //application of the hamming windowing, reading the two segments of the circular buffer in time order
+    if (fixedKernels != nullptr)
+    {
+        fixedKernels->applyWindowToRing(windowedBuffer.data(), ringBuffer.data(), writePosition);
+    }
+    else
+    {
+        const int olderSamples = bufferSize - writePosition;
+        DSPKernels::applyWindow(windowedBuffer.data(), ringBuffer.data() + writePosition, analysisWindow, olderSamples);
+        DSPKernels::applyWindow(windowedBuffer.data() + olderSamples, ringBuffer.data(), analysisWindow + olderSamples, writePosition);
+    }
+
+    return analyseWindowedBuffer(bufferSize);
+}
+
+//checks the mean magnitude of the input against the dynamic threshold
+bool YINAudioComponent::isBelowInputThreshold(float magnitude, int bufferSize) const
+{
     //sets dynamic threshold
     float dynamicThreshold = std::max(inputMagnitudeThreshold, DEFAULT_DYNAMIC_THRESHOLD_MULTIPLIER * magnitude / bufferSize);
-    //checks if magnitude of inpuit signal is below the threshold
-    if (magnitude / bufferSize < dynamicThreshold)
-        return -1.0f;
+    return magnitude / bufferSize < dynamicThreshold;
+}
 
-    //application of the hamming windowing
-    std::vector<float> windowedBuffer(audioBuffer, audioBuffer + bufferSize);
-    applyHammingWindow(windowedBuffer);
+//difference function, normalization and parabolic interpolation on the windowed buffer
+float YINAudioComponent::analyseWindowedBuffer(int bufferSize)
+{
+    if (isVerifying())
+    {
+        const float pitch = verifyCandidates(bufferSize);
+        if (pitch > 0.0f)
+        {
+            if (bestCandidate >= 0)
+                lastConfidence = candidates[static_cast<size_t>(bestCandidate)].confidence;
+            return pitch;
+        }
 
-    //auto correlation
+        //none of the candidates while the input is loud enough, the full search still names the note
+    }
+    else
+    {
+        lagsEvaluated = 0;
+    }
+
+    lagsEvaluated += bufferSize / 2;
+    normaliseWindowedBuffer(bufferSize);
+
+    if (isTracking())
+        return trackDips(bufferSize);
+
+    //detect the first dip
     for (int tau = 1; tau < bufferSize / 2; tau++)
     {
-        yinBuffer[tau] = 0.0f;
-        for (int j = 0; (j + tau) < bufferSize; j++)
+        if (yinBuffer[tau] < FIXED_DYNAMIC_TOLERANCE)
         {
-            float diff = windowedBuffer[j] - windowedBuffer[j + tau];
-            yinBuffer[tau] += diff * diff;
+            lastConfidence = 1.0f - yinBuffer[tau];
+            return sampleRate / getParabolicLag(tau, bufferSize); //returns the pitch detected
         }
     }
 
-    
+    return -1.0f;
+}
+
+//difference function and cumulative mean normalisation of the windowed buffer into yinBuffer
+void YINAudioComponent::normaliseWindowedBuffer(int bufferSize)
+{
+    //a full window of a size with fixed kernels, process() can pass a shorter one
+    const bool useFixedKernels = fixedKernels != nullptr && bufferSize == fixedKernels->windowSize;
+
+    //difference function
+    if (differenceEngine == DifferenceEngine::FFT)
+        computeDifferenceFFT(windowedBuffer, bufferSize);
+    else if (useFixedKernels)
+        fixedKernels->computeDifference(windowedBuffer.data(), yinBuffer.data());
+    else
+        computeDifferenceDirect(windowedBuffer, bufferSize);
+
     //cumulative mean normalization
-    float sum = 0.0f;
-    const float epsilon = 1e-6f; //prevent division by 0 to avoid errors
-    
-    yinBuffer[0] = 1.0f;
+    if (useFixedKernels)
+    {
+        fixedKernels->normaliseDifference(yinBuffer.data());
+    }
+    else
+    {
+        float sum = 0.0f;
+        const float epsilon = 1e-6f; //prevent division by 0 to avoid errors
+
+        yinBuffer[0] = 1.0f;
+        for (int tau = 1; tau < bufferSize / 2; tau++)
+        {
+            sum += yinBuffer[tau]; //gather differences
+            yinBuffer[tau] *= tau / (sum + epsilon); //normalisation
+        }
+    }
+}
+
+//refine better tau using parabolic interpolation
+float YINAudioComponent::getParabolicLag(int tau, int bufferSize) const
+{
+    float betterTau = static_cast<float>(tau); //initial tau
+
+    if (tau > 1 && tau < bufferSize / 2 - 1)
+    {
+        float s0 = yinBuffer[tau - 1];
+        float s1 = yinBuffer[tau];
+        float s2 = yinBuffer[tau + 1];
+
+        float denominator = 2.0f * (2.0f * s1 - s2 - s0);
+        if (std::abs(denominator) > 1e-6f)
+            betterTau += (s2 - s0) / denominator; //set new betterTau
+    }
+
+    return betterTau;
+}
+
+//switches between the first dip and the probabilistic search, either way the tracker starts again
+void YINAudioComponent::setProbabilistic(bool shouldBeProbabilistic)
+{
+    probabilistic = shouldBeProbabilistic;
+    pitchTracker.reset();
+    voicingProbability = 0.0f;
+}
+
+//samples between the end of the window just analysed and the end of the window a result describes,
+//the group delay of the front end included
+int YINAudioComponent::getDecodingDelay() const
+{
+    return (isTracking() ? pitchTracker.getDecodingLag() * getAnalysisInterval() : 0) + decimator.getLatency();
+}
+
+//probabilistic mode, walks the dips of d'(tau) from the shortest lag
+//thresholds above a dip and below every earlier dip would have picked it first, so that share
+//of the prior is its probability, a single pass over the lags the tracker covers
+float YINAudioComponent::trackDips(int bufferSize)
+{
+    std::array<ViterbiPitchTracker::Candidate, ViterbiPitchTracker::maxCandidates> dips;
+    int numDips = 0;
+
+    const int firstLag = juce::jmax(2, static_cast<int>(sampleRate / ViterbiPitchTracker::maxFrequency));
+    const int lastLag = juce::jmin(bufferSize / 2 - 2, static_cast<int>(std::ceil(sampleRate / ViterbiPitchTracker::minFrequency)));
+    float lowestDip = 1.0f;
+
+    for (int tau = firstLag; tau <= lastLag && lowestDip > 1.0f / NUM_THRESHOLDS; ++tau)
+    {
+        const float value = yinBuffer[tau];
+        if (value >= lowestDip || value >= yinBuffer[tau - 1] || value > yinBuffer[tau + 1])
+            continue;
+
+        const int below = juce::jlimit(0, NUM_THRESHOLDS, static_cast<int>(value * NUM_THRESHOLDS));
+        const int above = juce::jlimit(0, NUM_THRESHOLDS, static_cast<int>(lowestDip * NUM_THRESHOLDS));
+        const float probability = thresholdPrior[static_cast<size_t>(above)] - thresholdPrior[static_cast<size_t>(below)];
+        lowestDip = value;
+
+        if (probability <= 0.0f)
+            continue;
+
+        //keeps the most probable dips when there are more than the tracker takes
+        int slot = numDips;
+        if (numDips == ViterbiPitchTracker::maxCandidates)
+        {
+            slot = 0;
+            for (int i = 1; i < numDips; ++i)
+                if (dips[static_cast<size_t>(i)].probability < dips[static_cast<size_t>(slot)].probability)
+                    slot = i;
+
+            if (dips[static_cast<size_t>(slot)].probability >= probability)
+                continue;
+        }
+        else
+        {
+            ++numDips;
+        }
+
+        dips[static_cast<size_t>(slot)] = { sampleRate / getParabolicLag(tau, bufferSize), probability, 1.0f - value };
+    }
+
+    return trackFrame(dips.data(), numDips);
+}
+
+//hands a frame to the tracker and returns the pitch of the frame it decodes, -1 for unvoiced
+float YINAudioComponent::trackFrame(const ViterbiPitchTracker::Candidate* frameCandidates, int numFrameCandidates)
+{
+    const auto frame = pitchTracker.processFrame(frameCandidates, numFrameCandidates);
+
+    voicingProbability = frame.voicingProbability;
+    lastConfidence = frame.frequency > 0.0f ? frame.confidence : 0.0f;
+    return frame.frequency;
+}
+
+//sets the candidates for verification mode, no allocation so it can change between frames
+void YINAudioComponent::setCandidateFrequencies(const float* frequencies, int newNumCandidates)
+{
+    numCandidates = 0;
+    bestCandidate = -1;
+    pitchTracker.reset();
+
+    if (frequencies == nullptr)
+        return;
+
+    for (int i = 0; i < newNumCandidates && numCandidates < MAX_CANDIDATES; ++i)
+    {
+        if (frequencies[i] <= 0.0f)
+            continue;
+
+        candidates[static_cast<size_t>(numCandidates)] = CandidateResult();
+        candidates[static_cast<size_t>(numCandidates)].targetFrequency = frequencies[i];
+        ++numCandidates;
+    }
+}
+
+//d(tau) / m(tau) where m(tau) is the energy of the two overlapping segments
+//unlike the cumulative mean normalisation it needs no other lags, 0 is a perfect repeat
+float YINAudioComponent::normalisedDifference(int tau, int bufferSize) const
+{
+    const double headEnergy = squaredPrefixSum[static_cast<size_t>(bufferSize - tau)];
+    const double tailEnergy = squaredPrefixSum[static_cast<size_t>(bufferSize)] - squaredPrefixSum[static_cast<size_t>(tau)];
+    const double energy = headEnergy + tailEnergy;
+
+    if (energy <= 0.0)
+        return 1.0f;
+
+    const float difference = DSPKernels::sumOfSquaredDifferences(windowedBuffer.data(), windowedBuffer.data() + tau, bufferSize - tau);
+    return static_cast<float>(difference / energy);
+}
+
+//lowest normalised difference within half a semitone of the lag, refined by parabolic interpolation
+//returns the confidence 1 - d / m of the best lag
+float YINAudioComponent::searchLagNeighbourhood(float centreLag, int bufferSize, float& refinedLag)
+{
+    const float spread = std::pow(2.0f, CANDIDATE_SEARCH_SEMITONES / 12.0f);
+    const int maxLag = bufferSize / 2 - 2;
+    const int firstLag = juce::jlimit(2, maxLag, static_cast<int>(std::floor(centreLag / spread)));
+    const int lastLag = juce::jlimit(2, maxLag, static_cast<int>(std::ceil(centreLag * spread)));
+
+    //the differences are kept in yinBuffer so the neighbours of the minimum are at hand
+    int bestLag = firstLag;
+    for (int tau = firstLag - 1; tau <= lastLag + 1; ++tau)
+    {
+        yinBuffer[static_cast<size_t>(tau)] = normalisedDifference(tau, bufferSize);
+        if (tau >= firstLag && tau <= lastLag && yinBuffer[static_cast<size_t>(tau)] < yinBuffer[static_cast<size_t>(bestLag)])
+            bestLag = tau;
+    }
+    lagsEvaluated += lastLag - firstLag + 3;
+
+    float s0 = yinBuffer[static_cast<size_t>(bestLag - 1)];
+    float s1 = yinBuffer[static_cast<size_t>(bestLag)];
+    float s2 = yinBuffer[static_cast<size_t>(bestLag + 1)];
+
+    refinedLag = static_cast<float>(bestLag);
+    float denominator = 2.0f * (2.0f * s1 - s2 - s0);
+    if (std::abs(denominator) > 1e-6f)
+        refinedLag += juce::jlimit(-0.5f, 0.5f, (s2 - s0) / denominator);
+
+    return 1.0f - s1;
+}
+
+//verification mode, scores every candidate and its octave guards on the windowed buffer
+//returns the pitch of the most confident candidate that clears the threshold, or -1
+float YINAudioComponent::verifyCandidates(int bufferSize)
+{
+    lagsEvaluated = 0;
+    bestCandidate = -1;
+
+    if (squaredPrefixSum.size() < static_cast<size_t>(bufferSize) + 1)
+        squaredPrefixSum.assign(static_cast<size_t>(bufferSize) + 1, 0.0);
+
+    squaredPrefixSum[0] = 0.0;
+    for (int j = 0; j < bufferSize; ++j)
+        squaredPrefixSum[static_cast<size_t>(j) + 1] = squaredPrefixSum[static_cast<size_t>(j)] + static_cast<double>(windowedBuffer[static_cast<size_t>(j)]) * windowedBuffer[static_cast<size_t>(j)];
+
+    for (int i = 0; i < numCandidates; ++i)
+    {
+        auto& candidate = candidates[static_cast<size_t>(i)];
+        const float lag = sampleRate / candidate.targetFrequency;
+
+        float refinedLag = lag, guardLag = lag;
+        candidate.confidence = searchLagNeighbourhood(lag, bufferSize, refinedLag);
+        candidate.detectedFrequency = sampleRate / refinedLag;
+
+        candidate.octaveAbove = false;
+        candidate.octaveBelow = false;
+
+        //the guards are only worth their cost for a candidate that would otherwise be accepted
+        if (candidate.confidence < CANDIDATE_CONFIDENCE_THRESHOLD)
+            continue;
+
+        //a note an octave up repeats at half the lag as well as at the full lag
+        candidate.octaveAbove = lag / 2.0f >= 2.0f
+                             && searchLagNeighbourhood(lag / 2.0f, bufferSize, guardLag) >= candidate.confidence - OCTAVE_ABOVE_MARGIN;
+
+        //a note an octave down only repeats at twice the lag
+        candidate.octaveBelow = lag * 2.0f < bufferSize / 2 - 2
+                             && searchLagNeighbourhood(lag * 2.0f, bufferSize, guardLag) > candidate.confidence + OCTAVE_BELOW_MARGIN;
+
+        if (candidate.octaveAbove || candidate.octaveBelow)
+            continue;
+
+        if (bestCandidate < 0 || candidate.confidence > candidates[static_cast<size_t>(bestCandidate)].confidence)
+            bestCandidate = i;
+    }
+
+    return bestCandidate >= 0 ? candidates[static_cast<size_t>(bestCandidate)].detectedFrequency : -1.0f;
+}
+
+//original difference function, sums the squared differences for every lag
+void YINAudioComponent::computeDifferenceDirect(const std::vector<float>& buffer, int bufferSize)
+{
+    //auto correlation
     for (int tau = 1; tau < bufferSize / 2; tau++)
+        yinBuffer[tau] = DSPKernels::sumOfSquaredDifferences(buffer.data(), buffer.data() + tau, bufferSize - tau);
+}
+
+//FFT difference function
+//d(tau) = sum x[j]^2 + sum x[j + tau]^2 - 2 r(tau) over j < N - tau
+//the energy terms come from prefix sums of squares and r(tau) from the
+//inverse FFT of the power spectrum of the zero padded window
+void YINAudioComponent::computeDifferenceFFT(const std::vector<float>& buffer, int bufferSize)
+{
+    if (fft == nullptr || fft->getSize() < bufferSize + bufferSize / 2 || squaredPrefixSum.size() < static_cast<size_t>(bufferSize) + 1)
+        prepareFFT(bufferSize);
+
+    const int fftSize = fft->getSize();
+
+    //prefix sums of squares, kept in double to avoid cancellation in the energy terms
+    squaredPrefixSum[0] = 0.0;
+    for (int j = 0; j < bufferSize; ++j)
+        squaredPrefixSum[j + 1] = squaredPrefixSum[j] + static_cast<double>(buffer[j]) * buffer[j];
+
+    //zero padded copy of the window
+    std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+    std::copy(buffer.begin(), buffer.begin() + bufferSize, fftBuffer.begin());
+
+    //power spectrum, the inverse transform of which is the autocorrelation
+    fft->performRealOnlyForwardTransform(fftBuffer.data());
+    for (int bin = 0; bin < fftSize; ++bin)
     {
-        sum += yinBuffer[tau]; //gather differences
-        yinBuffer[tau] *= tau / (sum + epsilon); //normalisation
+        float re = fftBuffer[2 * bin];
+        float im = fftBuffer[2 * bin + 1];
+        fftBuffer[2 * bin] = re * re + im * im;
+        fftBuffer[2 * bin + 1] = 0.0f;
     }
+    fft->performRealOnlyInverseTransform(fftBuffer.data());
 
-    //detect the first dip
+    const double totalEnergy = squaredPrefixSum[bufferSize];
     for (int tau = 1; tau < bufferSize / 2; tau++)
     {
-        if (yinBuffer[tau] < FIXED_DYNAMIC_TOLERANCE)
+        double headEnergy = squaredPrefixSum[bufferSize - tau];
+        double tailEnergy = totalEnergy - squaredPrefixSum[tau];
+        double difference = headEnergy + tailEnergy - 2.0 * fftBuffer[tau];
+
+        //rounding can take a perfect match slightly negative
+        yinBuffer[tau] = static_cast<float>(std::max(0.0, difference));
+    }
+}
+
+#if JUCE_UNIT_TESTS
+
+#include "NoteMapping.hpp"
+#include "SyntheticGuitarSignal.hpp"
+
+class YINDifferenceEngineTests : public juce::UnitTest
+{
+public:
+    YINDifferenceEngineTests() : juce::UnitTest("YIN difference engines", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        const float sampleRate = 48000.0f;
+
+        //8192 runs the fixed kernels against the FFT, 12000 the runtime sized path
+        for (int windowSize : { 8192, 12000 })
         {
-            float betterTau = static_cast<float>(tau); //initial tau
+            beginTest("FFT matches the direct engine at every lag, window of " + juce::String(windowSize));
+
+            YINAudioComponent direct, fft;
+            direct.initialize(sampleRate, windowSize);
+            direct.setDifferenceEngine(YINAudioComponent::DifferenceEngine::Direct);
+            fft.initialize(sampleRate, windowSize);
+            fft.setDifferenceEngine(YINAudioComponent::DifferenceEngine::FFT);
 
-            //refine better tau using parabolic interpolation
-            if (tau > 1 && tau < bufferSize / 2 - 1)
+            std::vector<std::vector<float>> windows;
+
+            juce::Random random(11);
+            windows.emplace_back(static_cast<size_t>(windowSize));
+            for (auto& sample : windows.back())
+                sample = random.nextFloat() * 1.6f - 0.8f;
+
+            for (int midiNote : { 40, 52, 69, 88 })
             {
-                float s0 = yinBuffer[tau - 1];
-                float s1 = yinBuffer[tau];
-                float s2 = yinBuffer[tau + 1];
+                windows.push_back(SyntheticGuitarSignal::renderNote(sampleRate, NoteMapping::getFrequencyForMidiNote(midiNote), 0.6f, windowSize));
+            }
 
-                float denominator = 2.0f * (2.0f * s1 - s2 - s0);
-                if (std::abs(denominator) > epsilon)
-                    betterTau += (s2 - s0) / denominator; //set new betterTau
+            windows.emplace_back(static_cast<size_t>(windowSize), 0.0f);
+
+            for (const auto& window : windows)
+            {
+                const auto expected = direct.computeNormalisedDifference(window.data(), windowSize);
+                const auto& actual = fft.computeNormalisedDifference(window.data(), windowSize);
+
+                float largestError = 0.0f;
+                for (int tau = 0; tau < windowSize / 2; ++tau)
+                    largestError = juce::jmax(largestError, std::abs(actual[static_cast<size_t>(tau)] - expected[static_cast<size_t>(tau)]));
+
+                expectLessThan(largestError, YINAudioComponent::FFT_DIFFERENCE_TOLERANCE);
             }
+        }
+    }
+};
+
+static YINDifferenceEngineTests yinDifferenceEngineTests;
+
+class YINVerificationTests : public juce::UnitTest
+{
+public:
+    YINVerificationTests() : juce::UnitTest("YIN verification mode", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        const float sampleRate = 48000.0f;
+        const int windowSize = 8192;
 
-            return sampleRate / betterTau; //returns the pitch detected
+        //A minor, A2 to G3
+        const int scale[] = { 45, 47, 48, 50, 52, 53, 55 };
+        float scaleFrequencies[7];
+        for (int i = 0; i < 7; ++i)
+            scaleFrequencies[i] = NoteMapping::getFrequencyForMidiNote(scale[i]);
+
+        YINAudioComponent fullSearch;
+        fullSearch.initialize(sampleRate, windowSize);
+
+        YINAudioComponent verifier;
+        verifier.initialize(sampleRate, windowSize);
+        verifier.setCandidateFrequencies(scaleFrequencies, 7);
+
+        beginTest("Each scale note is picked out of the candidates");
+        for (int i = 0; i < 7; ++i)
+        {
+            auto window = SyntheticGuitarSignal::renderNote(sampleRate, NoteMapping::getFrequencyForMidiNote(scale[i]), 0.6f, windowSize);
+            const float pitch = verifier.process(window.data(), windowSize);
+            const float reference = fullSearch.process(window.data(), windowSize);
+
+            expectEquals(verifier.getBestCandidate(), i);
+            expectGreaterThan(verifier.getCandidateResult(i).confidence, YINAudioComponent::CANDIDATE_CONFIDENCE_THRESHOLD);
+            expectWithinAbsoluteError(1200.0f * std::log2(pitch / reference), 0.0f, 2.0f);
+        }
+
+        beginTest("A note outside the candidates is named by the full search");
+        {
+            auto window = SyntheticGuitarSignal::renderNote(sampleRate, NoteMapping::getFrequencyForMidiNote(54), 0.6f, windowSize);  //F#3
+            const float pitch = verifier.process(window.data(), windowSize);
+
+            expectEquals(verifier.getBestCandidate(), -1);
+            expect(pitch > 0.0f && NoteMapping::getMidiNoteFromFrequencyWithTolerance(pitch) == 54);
+            expectGreaterThan(verifier.getLagsEvaluated(), windowSize / 2);
+        }
+
+        beginTest("Octave guards");
+        {
+            float a2 = NoteMapping::getFrequencyForMidiNote(45);
+            verifier.setCandidateFrequencies(&a2, 1);
+
+            //the candidate is turned down and the full search names the octave actually played
+            auto octaveUp = SyntheticGuitarSignal::renderNote(sampleRate, NoteMapping::getFrequencyForMidiNote(57), 0.6f, windowSize);
+            const float upPitch = verifier.process(octaveUp.data(), windowSize);
+            expectEquals(verifier.getBestCandidate(), -1);
+            expect(verifier.getCandidateResult(0).octaveAbove);
+            expect(upPitch > 0.0f && NoteMapping::getMidiNoteFromFrequencyWithTolerance(upPitch) == 57);
+
+            auto octaveDown = SyntheticGuitarSignal::renderNote(sampleRate, NoteMapping::getFrequencyForMidiNote(33), 0.6f, windowSize);
+            const float downPitch = verifier.process(octaveDown.data(), windowSize);
+            expectEquals(verifier.getBestCandidate(), -1);
+            const auto& result = verifier.getCandidateResult(0);
+            expect(result.octaveBelow || result.confidence < YINAudioComponent::CANDIDATE_CONFIDENCE_THRESHOLD);
+            expect(downPitch < 0.0f || NoteMapping::getMidiNoteFromFrequencyWithTolerance(downPitch) != 45);
+        }
+
+        beginTest("Only the candidate neighbourhoods are evaluated");
+        {
+            float a2 = NoteMapping::getFrequencyForMidiNote(45);
+            verifier.setCandidateFrequencies(&a2, 1);
+            auto window = SyntheticGuitarSignal::renderNote(sampleRate, NoteMapping::getFrequencyForMidiNote(45), 0.6f, windowSize);
+            expectGreaterThan(verifier.process(window.data(), windowSize), 0.0f);
+            expectLessThan(verifier.getLagsEvaluated() * 10, windowSize / 2);
+
+            verifier.setCandidateFrequencies(nullptr, 0);
+            expect(!verifier.isVerifying());
         }
     }
+};
 
-    return -1.0f;
-}
+static YINVerificationTests yinVerificationTests;
+
+class YINProbabilisticTests : public juce::UnitTest
+{
+public:
+    YINProbabilisticTests() : juce::UnitTest("YIN probabilistic mode", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        const float sampleRate = 48000.0f;
+        const int windowSize = 8192;
+        const int hopSize = 512;
+
+        YINAudioComponent yin;
+        yin.initialize(sampleRate, windowSize);
+        yin.setHopSize(hopSize);
+        yin.setProbabilistic(true);
+
+        beginTest("Results come the decoding lag late");
+        expectEquals(yin.getDecodingDelay(), ViterbiPitchTracker::defaultDecodingLag * hopSize);
+
+        beginTest("Plucked notes are tracked without octave jumps");
+        for (int midiNote : { 40, 45, 52, 57, 64 })
+        {
+            YINAudioComponent tracking;
+            tracking.initialize(sampleRate, windowSize);
+            tracking.setHopSize(hopSize);
+            tracking.setProbabilistic(true);
+
+            const float frequency = NoteMapping::getFrequencyForMidiNote(midiNote);
+            auto signal = SyntheticGuitarSignal::renderNote(sampleRate, frequency, 0.6f, windowSize + 40 * hopSize);
+
+            int numVoiced = 0, numWrong = 0;
+            float lowestVoicing = 1.0f;
+            for (int offset = 0; offset < static_cast<int>(signal.size()); offset += hopSize)
+            {
+                const float pitch = tracking.processAudioBuffer(signal.data() + offset, hopSize);
+                if (pitch <= 0.0f)
+                    continue;
+
+                ++numVoiced;
+                lowestVoicing = juce::jmin(lowestVoicing, tracking.getVoicingProbability());
+                if (std::abs(1200.0f * std::log2(pitch / frequency)) > 20.0f)
+                    ++numWrong;
+            }
+
+            expectGreaterThan(numVoiced, 10);
+            expectEquals(numWrong, 0);
+            expectGreaterThan(lowestVoicing, 0.5f);
+        }
+
+        beginTest("Silence is unvoiced");
+        {
+            std::vector<float> silence(static_cast<size_t>(hopSize), 0.0f);
+            float pitch = 0.0f;
+            for (int i = 0; i < windowSize / hopSize + 2 * ViterbiPitchTracker::defaultDecodingLag; ++i)
+                pitch = yin.processAudioBuffer(silence.data(), hopSize);
+
+            expectLessThan(pitch, 0.0f);
+            expectEquals(yin.getVoicingProbability(), 0.0f);
+        }
+
+        beginTest("Verification mode bypasses the tracker");
+        {
+            float a2 = NoteMapping::getFrequencyForMidiNote(45);
+            yin.setCandidateFrequencies(&a2, 1);
+            expectEquals(yin.getDecodingDelay(), 0);
+            yin.setCandidateFrequencies(nullptr, 0);
+            expectEquals(yin.getDecodingDelay(), ViterbiPitchTracker::defaultDecodingLag * hopSize);
+        }
+    }
+};
+
+static YINProbabilisticTests yinProbabilisticTests;
+
+class YINDecimationTests : public juce::UnitTest
+{
+public:
+    YINDecimationTests() : juce::UnitTest("YIN decimating front end", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        const float sampleRate = 48000.0f;
+        const int windowSize = 8192;
+        const int hopSize = 512;
+
+        beginTest("Sample counts stay at the input rate");
+        {
+            YINAudioComponent yin;
+            yin.setDecimationFactor(YINAudioComponent::automaticDecimation);
+            yin.initialize(sampleRate, windowSize);
+            yin.setHopSize(hopSize);
+
+            expectEquals(yin.getDecimationFactor(), 4);
+            expectEquals(yin.getWindowSize(), windowSize);
+            expectEquals(yin.getAnalysisInterval(), hopSize);
+            expectEquals(yin.getSamplesUntilNextAnalysis(), windowSize);
+
+            std::vector<float> silence(100, 0.0f);
+            yin.processAudioBuffer(silence.data(), 100);
+            expectEquals(yin.getSamplesUntilNextAnalysis(), windowSize - 100);
+            expectEquals(yin.getDecodingDelay(), Decimator::tapsPerPhase * 4 / 2);
+
+            yin.reset();
+            expectEquals(yin.getSamplesUntilNextAnalysis(), windowSize);
+        }
+
+        beginTest("Pitch accuracy in cents is preserved");
+        {
+            const auto fullRate = measureAccuracy(sampleRate, windowSize, hopSize, 1);
+            const auto decimated = measureAccuracy(sampleRate, windowSize, hopSize, 4);
+            logMessage("mean error " + juce::String(fullRate.meanCents, 2) + " cents at the full rate, "
+                       + juce::String(decimated.meanCents, 2) + " cents decimated by 4");
+
+            expectGreaterOrEqual(decimated.numDetected, fullRate.numDetected);
+            expectLessThan(decimated.meanCents, fullRate.meanCents + 1.0);
+            expectLessThan(decimated.maxCents, 15.0);
+        }
+    }
+
+private:
+    struct Accuracy
+    {
+        double meanCents = 0.0;   //of the frames with a pitch
+        double maxCents = 0.0;
+        int numDetected = 0;
+    };
+
+    //plucks from low E to E6 fed a hop at a time, judged once the window has filled
+    static Accuracy measureAccuracy(float sampleRate, int windowSize, int hopSize, int factor)
+    {
+        Accuracy accuracy;
+        double sumCents = 0.0;
+
+        for (int midiNote : { 40, 45, 50, 55, 59, 64, 69, 76, 84, 88 })
+        {
+            YINAudioComponent yin;
+            yin.setDecimationFactor(factor);
+            yin.initialize(sampleRate, windowSize);
+            yin.setHopSize(hopSize);
+
+            const float frequency = NoteMapping::getFrequencyForMidiNote(midiNote);
+            auto signal = SyntheticGuitarSignal::renderNote(sampleRate, frequency, 0.6f, windowSize + 16 * hopSize);
+
+            for (int offset = 0; offset + hopSize <= static_cast<int>(signal.size()); offset += hopSize)
+            {
+                const float pitch = yin.processAudioBuffer(signal.data() + offset, hopSize);
+                if (offset + hopSize <= windowSize + yin.getDecodingDelay() || pitch <= 0.0f)
+                    continue;
+
+                const double cents = std::abs(1200.0 * std::log2(pitch / frequency));
+                sumCents += cents;
+                accuracy.maxCents = juce::jmax(accuracy.maxCents, cents);
+                ++accuracy.numDetected;
+            }
+        }
+
+        accuracy.meanCents = accuracy.numDetected > 0 ? sumCents / accuracy.numDetected : 0.0;
+        return accuracy;
+    }
+};
+
+static YINDecimationTests yinDecimationTests;
+
+#endif
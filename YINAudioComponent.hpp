@@ -1,31 +1,191 @@
 #pragma once
 
+#include <array>
 #include <vector>
+#include <memory>
 #include <juce_core/juce_core.h>
+#include <juce_dsp/juce_dsp.h>
+#include "Decimator.hpp"
+#include "PitchDetector.hpp"
+#include "ViterbiPitchTracker.hpp"
+#include "YINKernels.hpp"
 
-class YINAudioComponent
+class YINAudioComponent : public PitchDetector
 {
 public:
 
+    //engines for computing the YIN difference function d(tau)
+    //Direct is the original O(N^2) nested loop
+    //FFT uses cross correlation plus prefix sums of squares, O(N log N)
+    enum class DifferenceEngine
+    {
+        Direct,
+        FFT
+    };
+
+    //maximum absolute difference between the normalised d'(tau) of the two engines
+    //measured error on sine, harmonic and noise windows of 2048-16384 samples is
+    //below 1e-4, the bound leaves headroom for the float precision of the platform FFT
+    //detected pitches agree to within about 0.1 cent
+    static constexpr float FFT_DIFFERENCE_TOLERANCE = 1e-3f;
+
     YINAudioComponent();
 
-    void initialize(float sampleRate, int bufferSize);
+    void initialize(float sampleRate, int bufferSize) override;
+    void reset() override;
 
     float process(const float* audioBuffer, int bufferSize);
 
     float processAudioBuffer(const float* audioBuffer, int bufferSize);
 
+    //PitchDetector, processAudioBuffer with the confidence of the last analysis
+    Result analyseBlock(const float* samples, int numSamples) override;
+
     void applyHammingWindow(std::vector<float>& buffer);
 
+    //streaming mode, a hop shorter than the window gives a pitch estimate every hop
+    void setHopSize(int newHopSize) override;
+    int getHopSize() const { return hopSize; }
+    bool isStreaming() const;
+    int getAnalysisInterval() const;
+    int getWindowSize() const override { return static_cast<int>(ringBuffer.size()) * decimator.getFactor(); }
+
+    //samples still needed before processAudioBuffer runs the next analysis
+    int getSamplesUntilNextAnalysis() const override { return samplesUntilAnalysis * decimator.getFactor() - decimator.getPendingInputs(); }
+
+    //1 - d'(tau) at the lag of the last analysis, or the best candidate's confidence while verifying
+    //0 when the last analysis found no pitch
+    float getLastConfidence() const { return lastConfidence; }
+
+    //true when initialize found compile-time specialised kernels for the window size
+    bool hasFixedKernels() const { return fixedKernels != nullptr; }
+
+    void setDifferenceEngine(DifferenceEngine engine);
+    DifferenceEngine getDifferenceEngine() const { return differenceEngine; }
+
+    //windows a contiguous buffer of at most the window size and returns d'(tau) for tau < numSamples / 2
+    //from the selected engine, without the level gate or the pitch search
+    const std::vector<float>& computeNormalisedDifference(const float* samples, int numSamples);
+
+    //verification mode, when candidates are set the difference function is only evaluated
+    //within a quarter tone of each candidate's lag and of the lags an octave either side,
+    //which guard against octave errors, instead of for every lag up to N/2
+    //a window none of the candidates matches falls back to the full search, so a wrong note is still named
+    static constexpr int MAX_CANDIDATES = 16;
+
+    //confidence a candidate needs before its pitch is returned, 1 - d(tau) / m(tau)
+    static constexpr float CANDIDATE_CONFIDENCE_THRESHOLD = 0.8f;
+
+    struct CandidateResult
+    {
+        float targetFrequency = 0.0f;
+        float detectedFrequency = -1.0f;  //refined pitch inside the candidate's neighbourhood
+        float confidence = 0.0f;          //1 for a perfectly periodic window, 0 or below for no match
+        bool octaveAbove = false;         //the window repeats at half the lag, the note is an octave higher
+        bool octaveBelow = false;         //the window repeats better at twice the lag, the note is an octave lower
+    };
+
+    //numCandidates of 0 returns to the full search, extra candidates past MAX_CANDIDATES are ignored
+    void setCandidateFrequencies(const float* frequencies, int numCandidates) override;
+    int getNumCandidates() const { return numCandidates; }
+    bool isVerifying() const { return numCandidates > 0; }
+
+    //results of the last analysed window, index -1 from getBestCandidate when nothing matched
+    const CandidateResult& getCandidateResult(int index) const { return candidates[static_cast<size_t>(index)]; }
+    int getBestCandidate() const { return bestCandidate; }
+
+    //lags whose difference was computed for the last window, N/2 for the full search, added to the
+    //candidates' when verification fell back to it
+    int getLagsEvaluated() const { return lagsEvaluated; }
+
+    //probabilistic mode (pYIN) for the full search, instead of the first dip under one threshold
+    //every dip of d'(tau) is a candidate weighted by the share of a prior over thresholds for
+    //which it is the first dip, and a ViterbiPitchTracker picks the path through the candidates
+    //each result then describes the window that ended getDecodingDelay() samples earlier
+    void setProbabilistic(bool shouldBeProbabilistic);
+    bool isProbabilistic() const { return probabilistic; }
+    void setDecodingLag(int frames) { pitchTracker.setDecodingLag(frames); }
+    int getDecodingDelay() const override;
+
+    //probabilistic mode only, how likely the frame of the last result was to hold a note
+    float getVoicingProbability() const { return voicingProbability; }
+    const ViterbiPitchTracker& getPitchTracker() const { return pitchTracker; }
+
+    //decimating front end, the input is low-passed and decimated before it reaches the window,
+    //which then spans the same time in a factor fewer samples and converts lags to pitch at the
+    //decimated rate, hop, window and delay stay in input samples
+    //automaticDecimation picks the factor from the sample rate, either takes effect at the next initialize
+    static constexpr int automaticDecimation = 0;
+    void setDecimationFactor(int factor) { requestedDecimation = factor; }
+    int getDecimationFactor() const { return decimator.getFactor(); }
+
 private:
 
+    float addToRingBuffer(const float* samples, const float* magnitudes, int numSamples);
+    float processRingBuffer();
+    float analyseWindowedBuffer(int bufferSize);
+    void normaliseWindowedBuffer(int bufferSize);
+    bool isBelowInputThreshold(float magnitude, int bufferSize) const;
+
+    void computeDifferenceDirect(const std::vector<float>& buffer, int bufferSize);
+    void computeDifferenceFFT(const std::vector<float>& buffer, int bufferSize);
+    void prepareFFT(int bufferSize);
+
+    float verifyCandidates(int bufferSize);
+    float normalisedDifference(int tau, int bufferSize) const;
+    float searchLagNeighbourhood(float centreLag, int bufferSize, float& refinedLag);
+
+    float trackDips(int bufferSize);
+    float trackFrame(const ViterbiPitchTracker::Candidate* frameCandidates, int numFrameCandidates);
+    bool isTracking() const { return probabilistic && !isVerifying(); }
+    int getDecimatedHop() const;
+    float getParabolicLag(int tau, int bufferSize) const;
+
     std::vector<float> yinBuffer;
 
-    std::vector<float> accumulatedBuffer;
+    //fixed capacity circular buffer holding the current detection window
+    std::vector<float> ringBuffer;
+    int writePosition;
+    int samplesUntilAnalysis;   //decimated samples
+    int hopSize;                //input samples
+
+    //preallocated scratch for the windowed copy of the detection window
+    std::vector<float> windowedBuffer;
+
+    std::vector<float> hammingWindow;   //only built for window sizes without fixed kernels
+
+    //kernels and constexpr window of the window size, or nullptr for the runtime sized path
+    const YINKernels::Table<float>* fixedKernels = nullptr;
+    const float* analysisWindow = nullptr;
+
+    //FFT difference engine state
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> fftBuffer;
+    std::vector<double> squaredPrefixSum;
+
+    DifferenceEngine differenceEngine;
+
+    //verification mode state
+    std::array<CandidateResult, MAX_CANDIDATES> candidates;
+    int numCandidates = 0;
+    int bestCandidate = -1;
+    int lagsEvaluated = 0;
+
+    float lastConfidence = 0.0f;
+
+    //probabilistic mode state
+    ViterbiPitchTracker pitchTracker;
+    bool probabilistic = false;
+    float voicingProbability = 0.0f;
 
-    std::vector<float> hammingWindow;
+    //decimating front end state
+    Decimator decimator;
+    int requestedDecimation = 1;
+    std::vector<float> decimatedBlock;
+    std::vector<float> decimatedMagnitudes;
+    std::vector<float> magnitudeRing;   //sum of |input| behind each sample of the window, decimated only
 
     float tolerance;
-    float sampleRate;
+    float sampleRate;   //of the analysis window, the input rate over the decimation factor
     float inputMagnitudeThreshold;
 };
@@ -0,0 +1,180 @@
+#include "YINKernels.hpp"
+
+const YINKernels::Table<float>* YINKernels::getTable(int windowSize)
+{
+    switch (windowSize)
+    {
+        case 1024:  return &Fixed<float, 1024>::table;
+        case 2048:  return &Fixed<float, 2048>::table;
+        case 4096:  return &Fixed<float, 4096>::table;
+        case 8192:  return &Fixed<float, 8192>::table;
+        case 16384: return &Fixed<float, 16384>::table;
+        default:    return nullptr;
+    }
+}
+
+#if JUCE_UNIT_TESTS
+
+#include "NoteMapping.hpp"
+#include "SyntheticGuitarSignal.hpp"
+#include "YINAudioComponent.hpp"
+#include <vector>
+
+class YINKernelsTests : public juce::UnitTest
+{
+public:
+    YINKernelsTests() : juce::UnitTest("YIN fixed size kernels", "GuitarLearningApp") {}
+
+    void runTest() override
+    {
+        beginTest("Every window the detector can run has an instantiation");
+        for (int windowSize : { 1024, 2048, 4096, 8192, 16384 })
+        {
+            const auto* table = YINKernels::getTable(windowSize);
+            expect(table != nullptr);
+            if (table != nullptr)
+                expectEquals(table->windowSize, windowSize);
+        }
+
+        expect(YINKernels::getTable(3000) == nullptr);
+        expect(YINKernels::getTable(32768) == nullptr);
+
+        beginTest("The constexpr window matches the runtime Hamming window");
+        {
+            const auto& window = YINKernels::Fixed<double, 8192>::window;
+            double maxError = 0.0;
+            for (int i = 0; i < 8192; ++i)
+            {
+                const double expected = 0.54 - 0.46 * std::cos(2.0 * juce::MathConstants<double>::pi * i / 8191.0);
+                maxError = juce::jmax(maxError, std::abs(window[static_cast<size_t>(i)] - expected));
+            }
+
+            expectLessThan(maxError, 1.0e-12);
+
+            //and in float, as YINAudioComponent builds the window for other sizes
+            checkFloatWindow(YINKernels::getTable(1024));
+            checkFloatWindow(YINKernels::getTable(16384));
+        }
+
+        beginTest("A fixed size detector matches a runtime sized one on the same input");
+        {
+            //a window one sample longer than an instantiation takes the runtime path, at the full rate
+            //and decimated by 8 down to the smallest window
+            compareWithRuntime(1, 8192, 8193);
+            compareWithRuntime(8, 8192, 8200);
+        }
+
+        beginTest("Double samples run the lane loop");
+        {
+            constexpr int windowSize = 1024;
+            std::vector<double> windowed(static_cast<size_t>(windowSize)), difference(static_cast<size_t>(windowSize / 2));
+            juce::Random random(3);
+            for (auto& sample : windowed)
+                sample = random.nextDouble() * 2.0 - 1.0;
+
+            YINKernels::Fixed<double, windowSize>::computeDifference(windowed.data(), difference.data());
+
+            double maxRelativeError = 0.0;
+            for (int tau = 1; tau < windowSize / 2; ++tau)
+            {
+                double expected = 0.0;
+                for (int j = 0; j < windowSize - tau; ++j)
+                    expected += (windowed[static_cast<size_t>(j)] - windowed[static_cast<size_t>(j + tau)]) * (windowed[static_cast<size_t>(j)] - windowed[static_cast<size_t>(j + tau)]);
+
+                maxRelativeError = juce::jmax(maxRelativeError, std::abs(difference[static_cast<size_t>(tau)] - expected) / expected);
+            }
+
+            expectLessThan(maxRelativeError, 1.0e-12);
+        }
+    }
+
+private:
+    void checkFloatWindow(const YINKernels::Table<float>* table)
+    {
+        expect(table != nullptr);
+        if (table == nullptr)
+            return;
+
+        float maxError = 0.0f;
+        for (int i = 0; i < table->windowSize; ++i)
+        {
+            const float expected = 0.54f - 0.46f * std::cos(2.0f * juce::MathConstants<float>::pi * i / (table->windowSize - 1));
+            maxError = juce::jmax(maxError, std::abs(table->window[i] - expected));
+        }
+
+        expectLessThan(maxError, 1.0e-6f);
+    }
+
+    //the direct engine on both, so the fixed kernels run for every step of the frame on one of them
+    void compareWithRuntime(int decimationFactor, int fixedSize, int runtimeSize)
+    {
+        const float sampleRate = 48000.0f;
+        const int hopSize = 512;
+
+        YINAudioComponent fixed, runtime;
+        for (auto* yin : { &fixed, &runtime })
+        {
+            yin->setDecimationFactor(decimationFactor);
+            yin->initialize(sampleRate, yin == &fixed ? fixedSize : runtimeSize);
+            yin->setHopSize(hopSize);
+            yin->setDifferenceEngine(YINAudioComponent::DifferenceEngine::Direct);
+        }
+
+        expect(fixed.hasFixedKernels());
+        expect(!runtime.hasFixedKernels());
+
+        //the normalised difference of a noise window, the runtime window only differs by its length
+        {
+            const int windowSize = fixed.getWindowSize() / decimationFactor;
+            juce::Random random(windowSize);
+            std::vector<float> noise(static_cast<size_t>(windowSize));
+            for (auto& sample : noise)
+                sample = random.nextFloat() * 2.0f - 1.0f;
+
+            const auto expected = runtime.computeNormalisedDifference(noise.data(), windowSize);
+            const auto& actual = fixed.computeNormalisedDifference(noise.data(), windowSize);
+
+            float largestError = 0.0f;
+            for (int tau = 0; tau < windowSize / 2; ++tau)
+                largestError = juce::jmax(largestError, std::abs(actual[static_cast<size_t>(tau)] - expected[static_cast<size_t>(tau)]));
+
+            expectLessThan(largestError, 1.0e-3f);
+        }
+
+        //plucks streamed through both a hop at a time, the ring reads, level gate and pitch search included
+        double largestCents = 0.0;
+        int numMismatched = 0;
+
+        for (int midiNote : { 40, 52, 69, 88 })
+        {
+            const auto signal = SyntheticGuitarSignal::renderNote(sampleRate, NoteMapping::getFrequencyForMidiNote(midiNote), 0.6f, fixedSize + 16 * hopSize);
+
+            //the runtime window is longer, a head start of silence lines the two up so both analyse the same hop
+            fixed.reset();
+            runtime.reset();
+            const std::vector<float> headStart(static_cast<size_t>(runtimeSize - fixedSize), 0.0f);
+            runtime.processAudioBuffer(headStart.data(), static_cast<int>(headStart.size()));
+
+            for (int offset = 0; offset + hopSize <= static_cast<int>(signal.size()); offset += hopSize)
+            {
+                const float fixedPitch = fixed.processAudioBuffer(signal.data() + offset, hopSize);
+                const float runtimePitch = runtime.processAudioBuffer(signal.data() + offset, hopSize);
+
+                if (offset + hopSize < fixedSize)
+                    continue;
+
+                if ((fixedPitch > 0.0f) != (runtimePitch > 0.0f))
+                    ++numMismatched;
+                else if (fixedPitch > 0.0f)
+                    largestCents = juce::jmax(largestCents, std::abs(1200.0 * std::log2(fixedPitch / runtimePitch)));
+            }
+        }
+
+        expectEquals(numMismatched, 0);
+        expectLessThan(largestCents, 0.1);
+    }
+};
+
+static YINKernelsTests yinKernelsTests;
+
+#endif
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <type_traits>
+#include <juce_core/juce_core.h>
+#include "DSPKernels.hpp"
+
+//compile-time specialised kernels for the YIN window sizes the app actually runs
+//the Hamming window of each size is a constexpr table in read-only data and every loop has a trip
+//count the compiler knows, so it can unroll and vectorise without the runtime size checks
+//YINAudioComponent picks an instantiation once in initialize through a table of function pointers
+//and falls back to its runtime sized path for any other window
+namespace YINKernels
+{
+    //cosine by its Taylor series after reducing to [-pi, pi], constexpr so the compiler builds the tables
+    constexpr double constexprCos(double x)
+    {
+        constexpr double pi = 3.14159265358979323846;
+        const double turns = x / (2.0 * pi);
+        x -= 2.0 * pi * static_cast<double>(static_cast<long long>(turns < 0.0 ? turns - 0.5 : turns + 0.5));
+
+        double term = 1.0, sum = 1.0;
+        for (int k = 1; k <= 14; ++k)   //the last term is under 1e-15 at pi
+        {
+            term *= -x * x / ((2.0 * k - 1.0) * (2.0 * k));
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    //0.54 - 0.46 cos(2 pi i / (N - 1)), the window YINAudioComponent has always used
+    //symmetric, so only the first half is evaluated, which keeps 16384 points inside clang's constexpr step limit
+    template <typename Sample, int windowSize>
+    constexpr std::array<Sample, windowSize> makeHammingWindow()
+    {
+        constexpr double pi = 3.14159265358979323846;
+        std::array<Sample, windowSize> window {};
+
+        for (int i = 0; i < windowSize / 2; ++i)
+        {
+            const auto value = static_cast<Sample>(0.54 - 0.46 * constexprCos(2.0 * pi * i / (windowSize - 1)));
+            window[static_cast<size_t>(i)] = value;
+            window[static_cast<size_t>(windowSize - 1 - i)] = value;
+        }
+
+        return window;
+    }
+
+    //the per-frame kernels of one window size
+    template <typename Sample>
+    struct Table
+    {
+        int windowSize;
+        const Sample* window;
+
+        //dest = window * the circular buffer read in time order, the oldest sample at writePosition
+        void (*applyWindowToRing)(Sample* dest, const Sample* ring, int writePosition);
+
+        //sum of |source[i]| over the window
+        Sample (*sumOfMagnitudes)(const Sample* source);
+
+        //d(tau) for 1 <= tau < N / 2, the original O(N^2) difference function
+        void (*computeDifference)(const Sample* windowed, Sample* difference);
+
+        //d'(tau), the cumulative mean normalisation in place, d'(0) = 1
+        void (*normaliseDifference)(Sample* difference);
+    };
+
+    template <typename Sample, int windowSize>
+    struct Fixed
+    {
+        static_assert(std::is_floating_point<Sample>::value, "samples are float or double");
+        static_assert(windowSize >= 64 && (windowSize & (windowSize - 1)) == 0, "window sizes are powers of two");
+
+        static constexpr int numLags = windowSize / 2;
+        static constexpr int numLanes = 8;   //independent accumulators, enough to fill a NEON or SSE pipeline
+
+        alignas(16) static constexpr std::array<Sample, windowSize> window = makeHammingWindow<Sample, windowSize>();
+
+        static void applyWindowToRing(Sample* dest, const Sample* ring, int writePosition)
+        {
+            const int olderSamples = windowSize - writePosition;
+
+            for (int i = 0; i < olderSamples; ++i)
+                dest[i] = ring[writePosition + i] * window[static_cast<size_t>(i)];
+
+            for (int i = olderSamples; i < windowSize; ++i)
+                dest[i] = ring[i - olderSamples] * window[static_cast<size_t>(i)];
+        }
+
+        static Sample sumOfMagnitudes(const Sample* source)
+        {
+            std::array<Sample, numLanes> lanes {};
+
+            for (int i = 0; i < windowSize; i += numLanes)
+                for (int lane = 0; lane < numLanes; ++lane)
+                    lanes[static_cast<size_t>(lane)] += std::abs(source[i + lane]);
+
+            return sumLanes(lanes);
+        }
+
+        //float goes through the hand written NEON and SSE kernel, which the lane loop only matches
+        static void computeDifference(const Sample* windowed, Sample* difference)
+        {
+            if constexpr (std::is_same<Sample, float>::value)
+            {
+                for (int tau = 1; tau < numLags; ++tau)
+                    difference[tau] = DSPKernels::sumOfSquaredDifferences(windowed, windowed + tau, windowSize - tau);
+            }
+            else
+            {
+                for (int tau = 1; tau < numLags; ++tau)
+                {
+                    const int numTerms = windowSize - tau;
+                    const int numBlocked = numTerms - numTerms % numLanes;
+                    std::array<Sample, numLanes> lanes {};
+
+                    for (int j = 0; j < numBlocked; j += numLanes)
+                        for (int lane = 0; lane < numLanes; ++lane)
+                        {
+                            const Sample delta = windowed[j + lane] - windowed[j + lane + tau];
+                            lanes[static_cast<size_t>(lane)] += delta * delta;
+                        }
+
+                    Sample sum = sumLanes(lanes);
+                    for (int j = numBlocked; j < numTerms; ++j)
+                    {
+                        const Sample delta = windowed[j] - windowed[j + tau];
+                        sum += delta * delta;
+                    }
+
+                    difference[tau] = sum;
+                }
+            }
+        }
+
+        static void normaliseDifference(Sample* difference)
+        {
+            const Sample epsilon = static_cast<Sample>(1e-6);   //as the runtime path, no division by 0
+            Sample sum = 0;
+
+            difference[0] = 1;
+            for (int tau = 1; tau < numLags; ++tau)
+            {
+                sum += difference[tau];
+                difference[tau] *= tau / (sum + epsilon);
+            }
+        }
+
+        static constexpr Table<Sample> table { windowSize, window.data(), &applyWindowToRing, &sumOfMagnitudes,
+                                               &computeDifference, &normaliseDifference };
+
+    private:
+        static Sample sumLanes(const std::array<Sample, numLanes>& lanes)
+        {
+            Sample sum = 0;
+            for (auto lane : lanes)
+                sum += lane;
+
+            return sum;
+        }
+    };
+
+    //the instantiation for a window size, nullptr for sizes without one
+    //YINAudioComponent raises full rate windows to at least 8192, the app runs 8192 and the benchmark
+    //16384 too, and decimating by 2, 4 or 8 takes those down to 4096, 2048 and 1024
+    const Table<float>* getTable(int windowSize);
+}